@@ -53,6 +53,17 @@ class Histogram
 		_samples++;
 	}
 
+	void Add(T v, unsigned count)
+	{
+		_data[ v ] += count;
+		_samples += count;
+	}
+
+	std::map<T,unsigned> GetSortedData() const
+	{
+		return _GetSortedData();
+	}
+
 	void Merge(const Histogram<T> &other)
 	{
 		for (auto i : other._data)
@@ -27,6 +27,11 @@ namespace diskspd {
 	}
 
 	void IoBucketizer::Add(uint64_t ioCompletionTime)
+	{
+		Add(ioCompletionTime, 1);
+	}
+
+	void IoBucketizer::Add(uint64_t ioCompletionTime, unsigned int count)
 	{
 		assert(_bucketDuration != INVALID_BUCKET_DURATION);
 
@@ -41,7 +46,7 @@ namespace diskspd {
 				_vBuckets[i] = 0;
 			}
 		}
-		_vBuckets[bucketNumber]++;
+		_vBuckets[bucketNumber] += count;
 	}
 
 	size_t IoBucketizer::GetNumberOfValidBuckets() const
@@ -19,6 +19,7 @@ namespace diskspd {
 		size_t GetNumberOfBuckets() const;
 		unsigned int GetIoBucket(size_t bucketNumber) const;
 		void Add(uint64_t ioCompletionTime);
+		void Add(uint64_t ioCompletionTime, unsigned int count);
 		double GetStandardDeviation() const;
 		void Merge(const IoBucketizer& other);
 	private:
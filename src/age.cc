@@ -0,0 +1,261 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/statvfs.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+// linux/fs.h's BLOCK_SIZE would clash with the option
+#undef BLOCK_SIZE
+
+#include "debug.h"
+#include "options.h"
+#include "target.h"
+#include "rng_engine.h"
+#include "age.h"
+
+namespace diskspd {
+
+	bool FsAging::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t end = settings.find(',');
+		if (end == std::string::npos) end = settings.size();
+
+		std::string size = settings.substr(0, end);
+		if (!Options::valid_byte_size(size.c_str()) || size.back() == 'b') {
+			fprintf(stderr, "Invalid --age extent size\n");
+			return false;
+		}
+		extent_size = Options::byte_size_from_arg(size.c_str(), 0);
+
+		size_t pos = end + 1;
+		while (pos < settings.size()) {
+			end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --age setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+			int number = Options::is_numeric(value.c_str()) ? atoi(value.c_str()) : -1;
+
+			if (key == "rounds" && number > 0) {
+				rounds = number;
+			} else if (key == "files" && number > 0) {
+				files = number;
+			} else if (key == "fill" && number > 0 && number <= 100) {
+				fill = number;
+			} else if (key == "keep" && number >= 0 && number <= 100) {
+				keep = number;
+			} else {
+				fprintf(stderr, "Invalid --age setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+
+		// pieces are up to twice the extent size, and written from Job::run_job's 64MiB buffer
+		if (extent_size < 4096 || extent_size > 32*1024*1024) {
+			fprintf(stderr, "--age extent size must be between 4K and 32M\n");
+			return false;
+		}
+		return true;
+	}
+
+	bool FsAging::count_extents(int fd, uint64_t& extents) {
+		struct fiemap map;
+		memset(&map, 0, sizeof(map));
+		map.fm_length = FIEMAP_MAX_OFFSET;
+		map.fm_flags = FIEMAP_FLAG_SYNC;
+		// with no room for extents, FIEMAP just counts them
+		map.fm_extent_count = 0;
+		if (ioctl(fd, FS_IOC_FIEMAP, &map) == -1) {
+			perror("FIEMAP failed");
+			return false;
+		}
+		extents = map.fm_mapped_extents;
+		return true;
+	}
+
+	/**
+	 *	Write len bytes of buf at offset and make sure they're allocated, so delayed allocation
+	 *	can't put the pieces back together
+	 */
+	static bool write_piece(int fd, const char * buf, size_t len, off_t offset) {
+		return pwrite(fd, buf, len, offset) == (ssize_t)len && !fdatasync(fd);
+	}
+
+	/**
+	 *	A filler file and the pieces it was written in
+	 */
+	struct Filler {
+		std::string path;
+		int fd = -1;
+		off_t size = 0;
+		std::vector<std::pair<off_t, size_t>> pieces;
+	};
+
+	bool FsAging::age(const Target& target, const char * buf, size_t buf_size, uint64_t seed) {
+
+		int fd = open(target.path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			perror("--age failed to open target");
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+			fprintf(stderr, "--age can only age regular files, not %s\n", target.path.c_str());
+			close(fd);
+			return false;
+		}
+		Result& result = results[&target];
+		bool counted = count_extents(fd, result.extents_before);
+		close(fd);
+		if (!counted) {
+			return false;
+		}
+		result.extents_after = result.extents_before;
+
+		// pieces are multiples of the filesystem block, from one block to max_size. The target's
+		// are twice the size of the fillers', which is what leaves the holes it's rewritten into
+		RngEngine rng(seed);
+		size_t fs_block = st.st_blksize;
+		auto piece_size = [&](size_t max_size) {
+			size_t blocks = std::max(max_size/fs_block, (size_t)1);
+			return std::min(fs_block*(1 + rng.get_rand_offset(blocks)), buf_size);
+		};
+
+		off_t target_bytes = target.max_size - target.base_offset;
+		std::string dir = target.path.substr(0, target.path.rfind('/') + 1);
+		if (dir.empty()) dir = ".";
+		uint64_t goal = std::max<uint64_t>((target_bytes + extent_size - 1)/extent_size, 1);
+
+		std::vector<Filler> fillers;
+		auto remove_fillers = [&]() {
+			for (auto& filler : fillers) {
+				if (filler.fd != -1) close(filler.fd);
+				unlink(filler.path.c_str());
+			}
+			fillers.clear();
+		};
+
+		while (result.extents_after < goal && result.rounds < rounds) {
+
+			++result.rounds;
+			v_printf("	Aging \"%s\", round %u\n", target.path.c_str(), result.rounds);
+
+			// fill the free space, including the target's, with fillers in interleaved pieces;
+			// as long as there's plenty of free space the target can be laid out in one piece
+			unlink(target.path.c_str());
+			struct statvfs fs;
+			if (statvfs(dir.c_str(), &fs)) {
+				perror("--age failed to get the free space");
+				return false;
+			}
+			off_t fill_bytes = (off_t)fs.f_bavail*fs.f_frsize/100*fill;
+
+			for (unsigned int f = 0; f < files; ++f) {
+				Filler filler;
+				filler.path = target.path + ".age" + std::to_string(f);
+				filler.fd = open(filler.path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0664);
+				if (filler.fd == -1) {
+					fprintf(stderr, "--age failed to create %s\n", filler.path.c_str());
+					remove_fillers();
+					return false;
+				}
+				fillers.push_back(filler);
+			}
+			for (off_t written = 0, f = 0; written < fill_bytes; ++f) {
+				Filler& filler = fillers[f % fillers.size()];
+				size_t len = piece_size(extent_size);
+				if (!write_piece(filler.fd, buf, len, filler.size)) {
+					// out of space is as full as it gets
+					if (errno == ENOSPC) break;
+					perror("--age failed to write a filler");
+					remove_fillers();
+					return false;
+				}
+				filler.pieces.push_back({ filler.size, len });
+				filler.size += len;
+				written += len;
+			}
+
+			// leave holes in what's kept of the fillers
+			std::vector<Filler *> kept;
+			for (auto& filler : fillers) {
+				if (rng.get_percentage() > keep) {
+					close(filler.fd);
+					filler.fd = -1;
+					unlink(filler.path.c_str());
+					continue;
+				}
+				for (size_t p = 0; p < filler.pieces.size(); p += 2) {
+					if (fallocate(filler.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+								filler.pieces[p].first, filler.pieces[p].second)) {
+						perror("--age failed to punch a hole");
+						remove_fillers();
+						return false;
+					}
+				}
+				kept.push_back(&filler);
+			}
+
+			// rewrite the target in pieces, appending to the kept fillers in between
+			fd = open(target.path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0664);
+			if (fd == -1) {
+				fprintf(stderr, "--age failed to recreate %s\n", target.path.c_str());
+				remove_fillers();
+				return false;
+			}
+			for (off_t offset = target.base_offset; offset < target.max_size; ) {
+				size_t len = std::min((off_t)piece_size(2*extent_size), target.max_size - offset);
+				if (!write_piece(fd, buf, len, offset)) {
+					perror("--age failed to rewrite the target");
+					close(fd);
+					remove_fillers();
+					return false;
+				}
+				offset += len;
+
+				// the fillers just stop growing if they run out of space
+				if (kept.size()) {
+					Filler& filler = *kept[rng.get_rand_offset(kept.size())];
+					size_t filler_len = piece_size(extent_size);
+					if (write_piece(filler.fd, buf, filler_len, filler.size)) {
+						filler.size += filler_len;
+					}
+				}
+			}
+
+			counted = count_extents(fd, result.extents_after);
+			close(fd);
+			remove_fillers();
+			if (!counted) {
+				return false;
+			}
+		}
+
+		result.reached = result.extents_after >= goal;
+		return true;
+	}
+
+} // namespace diskspd
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <map>
+#include <cstdint>
+#include <sys/types.h>
+
+#ifndef DISKSPD_AGE_H
+#define DISKSPD_AGE_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	Ages the targets' layouts before the Job runs (--age), as -c lays them out in one
+	 *	sequential pass. Each round deletes a target and fills most of the free space with filler
+	 *	files next to it, written in interleaved pieces. It punches holes in some of the fillers
+	 *	and deletes the rest, so free space is in pieces, then rewrites the target a piece at a
+	 *	time, appending to the fillers in between. Rounds go on until the target's average extent
+	 *	is no bigger than extent_size. The fillers are deleted at the end of each round
+	 */
+	struct FsAging {
+		size_t extent_size			= 0;
+		unsigned int rounds			= 8;	// rounds=; the most rounds per target
+		unsigned int files			= 16;	// files=; filler files per round
+		unsigned int fill			= 90;	// fill=; % of the free space filled per round
+		unsigned int keep			= 90;	// keep=; % of fillers kept, with holes, per round
+
+		struct Result {
+			uint64_t extents_before	= 0;
+			uint64_t extents_after	= 0;
+			unsigned int rounds		= 0;
+			bool reached			= false;
+		};
+		std::map<const Target *, Result> results;
+
+		/**
+		 *	Parse an --age argument: EXTENT_SIZE, then optional comma separated key=value
+		 *	settings, named as above
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	Age a target that was just laid out, rewriting it with the buf_size bytes in buf
+		 *	as Job::run_job lays it out. seed seeds the piece sizes
+		 */
+		bool age(const Target& target, const char * buf, size_t buf_size, uint64_t seed);
+
+		/**
+		 *	The number of extents an open file has, from FIEMAP
+		 */
+		static bool count_extents(int fd, uint64_t& extents);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_AGE_H
@@ -112,6 +112,20 @@ namespace diskspd {
 			 *	The returned AsyncIop can be re-enqueue()d if desired, or just discarded
 			 */
 			virtual std::shared_ptr<IAsyncIop> wait(int group_id)=0;
+
+			/**
+			 *	Like wait(), but gives up after timeout_us microseconds, returning nullptr if no
+			 *	request completed in that time
+			 */
+			virtual std::shared_ptr<IAsyncIop> wait(int group_id, uint64_t timeout_us)=0;
+
+			/**
+			 *	Try to cancel a submit()ted request. Returns 0 if cancellation was started, or an
+			 *	errno value if not (the request may be done already, and most files and devices
+			 *	don't support it). Either way wait() still returns the request once it's finished;
+			 *	get_errno() is ECANCELED if it was cancelled
+			 */
+			virtual int cancel(std::shared_ptr<IAsyncIop> a)=0;
 	};
 
 } // namespace diskspd
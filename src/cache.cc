@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "cache.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool LruCache::lookup(const CachePage& p) {
+		auto it = index.find(p);
+		if (it == index.end()) {
+			return false;
+		}
+		pages.splice(pages.begin(), pages, it->second);
+		return true;
+	}
+
+	void LruCache::insert(const CachePage& p) {
+		if (lookup(p)) {
+			return;
+		}
+		if (pages.size() == capacity) {
+			index.erase(pages.back());
+			pages.pop_back();
+		}
+		pages.push_front(p);
+		index[p] = pages.begin();
+	}
+
+	bool ClockCache::lookup(const CachePage& p) {
+		auto it = index.find(p);
+		if (it == index.end()) {
+			return false;
+		}
+		ring[it->second].referenced = true;
+		return true;
+	}
+
+	void ClockCache::insert(const CachePage& p) {
+		if (lookup(p)) {
+			return;
+		}
+		// every pass clears the bits it finds set, so this finds a frame within two passes
+		while (ring[hand].used && ring[hand].referenced) {
+			ring[hand].referenced = false;
+			hand = (hand + 1) % ring.size();
+		}
+		Frame& frame = ring[hand];
+		if (frame.used) {
+			index.erase(frame.page);
+		}
+		frame.page = p;
+		frame.used = true;
+		frame.referenced = true;
+		index[p] = hand;
+		hand = (hand + 1) % ring.size();
+	}
+
+	bool TwoQCache::lookup(const CachePage& p) {
+		auto it = index.find(p);
+		if (it == index.end() || it->second.queue == A1OUT) {
+			return false;
+		}
+		// a1in is a FIFO; a hit there doesn't move the page
+		if (it->second.queue == AM) {
+			am.splice(am.begin(), am, it->second.it);
+		}
+		return true;
+	}
+
+	void TwoQCache::insert(const CachePage& p) {
+		auto it = index.find(p);
+		if (it == index.end()) {
+			make_room();
+			a1in.push_front(p);
+			index[p] = { A1IN, a1in.begin() };
+			return;
+		}
+		switch (it->second.queue) {
+			case AM:
+				am.splice(am.begin(), am, it->second.it);
+				break;
+			case A1IN:
+				break;
+			case A1OUT:
+				// seen again soon after it left a1in, so it's hot
+				a1out.erase(it->second.it);
+				make_room();
+				am.push_front(p);
+				it->second = { AM, am.begin() };
+				break;
+		}
+	}
+
+	void TwoQCache::make_room() {
+		if (am.size() + a1in.size() < capacity) {
+			return;
+		}
+		if (a1in.size() > a1in_max || am.empty()) {
+			CachePage p = a1in.back();
+			a1in.pop_back();
+			a1out.push_front(p);
+			index[p] = { A1OUT, a1out.begin() };
+			if (a1out.size() > a1out_max) {
+				index.erase(a1out.back());
+				a1out.pop_back();
+			}
+		} else {
+			index.erase(am.back());
+			am.pop_back();
+		}
+	}
+
+	bool BufferCache::parse(const char * arg, size_t block_size) {
+
+		std::string settings(arg);
+		size_t end = settings.find(',');
+		if (end == std::string::npos) end = settings.size();
+
+		std::string cache_size = settings.substr(0, end);
+		if (!Options::valid_byte_size(cache_size.c_str())) {
+			fprintf(stderr, "Invalid --cache size\n");
+			return false;
+		}
+		size = Options::byte_size_from_arg(cache_size.c_str(), block_size);
+		page_size = block_size;
+
+		size_t pos = end + 1;
+		while (pos < settings.size()) {
+			end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --cache setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			if (key == "policy" && (value == "clock" || value == "lru" || value == "2q")) {
+				policy = value == "clock" ? CLOCK : value == "lru" ? LRU : TWO_Q;
+			} else if (key == "page" && Options::valid_byte_size(value.c_str())) {
+				page_size = Options::byte_size_from_arg(value.c_str(), block_size);
+			} else {
+				fprintf(stderr, "Invalid --cache setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+
+		if (!page_size || size < page_size) {
+			fprintf(stderr, "--cache must hold at least one page\n");
+			return false;
+		}
+
+		size_t capacity = size/page_size;
+		switch (policy) {
+			case CLOCK:
+				pages.reset(new ClockCache(capacity));
+				break;
+			case LRU:
+				pages.reset(new LruCache(capacity));
+				break;
+			case TWO_Q:
+				pages.reset(new TwoQCache(capacity));
+				break;
+		}
+		return true;
+	}
+
+	const char * BufferCache::policy_name(Policy policy) {
+		switch (policy) {
+			case CLOCK:	return "CLOCK";
+			case LRU:	return "LRU";
+			default:	return "2Q";
+		}
+	}
+
+	bool BufferCache::lookup(const Target * target, off_t offset, size_t nbytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// every page is looked up, so each counts as accessed even if another one misses
+		bool hit = true;
+		for (uint64_t p = offset/page_size; p <= (offset + nbytes - 1)/page_size; ++p) {
+			hit &= pages->lookup({ target, p });
+		}
+		return hit;
+	}
+
+	void BufferCache::insert(const Target * target, off_t offset, size_t nbytes) {
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (uint64_t p = offset/page_size; p <= (offset + nbytes - 1)/page_size; ++p) {
+			pages->insert({ target, p });
+		}
+	}
+
+	bool ThreadParams::skip_cache_hits(const std::shared_ptr<IAsyncIop>& op) {
+
+		BufferCache& cache = *job_options->cache;
+		CacheResults& cache_results = *results->cache_results;
+		std::shared_ptr<TargetData> t_data = op->get_target_data();
+		const Target * target = t_data->target.get();
+
+		while (*run_threads) {
+
+			if (op->get_type() == IAsyncIop::Type::WRITE) {
+				return true;
+			}
+
+			uint64_t start_ns = PerfClock::get_time_ns();
+			if (!cache.lookup(target, op->get_offset(), op->get_nbytes())) {
+				// a miss's latency includes the lookup
+				op->set_time(start_ns/1000);
+				return true;
+			}
+
+			if (*record_results) {
+				++cache_results.hits;
+				cache_results.hit_bytes += op->get_nbytes();
+				if (job_options->measure_latency) {
+					cache_results.hit_latency_histogram.Add(PerfClock::get_time_ns() - start_ns);
+				}
+			}
+
+			// the hit is done; on to the next op
+			op->set_offset(t_data->get_next_offset(op->get_offset()));
+			if (rw_rng_engine->get_percentage() <= target->write_percentage) {
+				op->set_type(IAsyncIop::Type::WRITE);
+			} else {
+				op->set_type(IAsyncIop::Type::READ);
+			}
+		}
+		return false;
+	}
+
+} // namespace diskspd
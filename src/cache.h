@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <list>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_CACHE_H
+#define DISKSPD_CACHE_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	A page of a target
+	 */
+	struct CachePage {
+		const Target * target;
+		uint64_t page;
+
+		bool operator==(const CachePage& other) const {
+			return target == other.target && page == other.page;
+		}
+	};
+
+	struct CachePageHash {
+		size_t operator()(const CachePage& p) const {
+			return std::hash<uint64_t>()(p.page * 0x9e3779b97f4a7c15ULL ^ (uintptr_t)p.target);
+		}
+	};
+
+	/**
+	 *	Generic interface for a page replacement policy. Only tracks which pages are cached;
+	 *	there's no data behind them
+	 */
+	class ICachePolicy {
+		public:
+			virtual ~ICachePolicy(){}
+
+			/**
+			 *	Look a page up, counting it as an access. Returns true on a hit
+			 */
+			virtual bool lookup(const CachePage& p) = 0;
+
+			/**
+			 *	Add a page that was just read or written, evicting another if the cache is full
+			 */
+			virtual void insert(const CachePage& p) = 0;
+	};
+
+	/**
+	 *	Least recently used
+	 */
+	class LruCache : public ICachePolicy {
+		public:
+			LruCache(size_t capacity) : capacity(capacity) {}
+			bool lookup(const CachePage& p) override;
+			void insert(const CachePage& p) override;
+		private:
+			const size_t capacity;
+			std::list<CachePage> pages;		// most recently used first
+			std::unordered_map<CachePage, std::list<CachePage>::iterator, CachePageHash> index;
+	};
+
+	/**
+	 *	CLOCK: pages sit in a ring with a reference bit that an access sets. To evict, the hand
+	 *	sweeps the ring clearing set bits, and takes the first page whose bit was already clear
+	 */
+	class ClockCache : public ICachePolicy {
+		public:
+			ClockCache(size_t capacity) : ring(capacity) {}
+			bool lookup(const CachePage& p) override;
+			void insert(const CachePage& p) override;
+		private:
+			struct Frame {
+				CachePage page;
+				bool referenced = false;
+				bool used = false;
+			};
+			std::vector<Frame> ring;
+			size_t hand = 0;
+			std::unordered_map<CachePage, size_t, CachePageHash> index;
+	};
+
+	/**
+	 *	2Q (Johnson & Shasha): a page seen once goes into a FIFO, a1in, of a quarter of the cache.
+	 *	Pages pushed out of it are remembered (without being cached) in a1out, of half the
+	 *	cache's size in pages; only a page missed again while in a1out goes into the main LRU
+	 *	list, am. A scan therefore can't push the hot pages out
+	 */
+	class TwoQCache : public ICachePolicy {
+		public:
+			TwoQCache(size_t capacity) :
+				capacity(capacity),
+				a1in_max(std::max(capacity/4, (size_t)1)),
+				a1out_max(std::max(capacity/2, (size_t)1)) {}
+			bool lookup(const CachePage& p) override;
+			void insert(const CachePage& p) override;
+		private:
+			enum Queue { AM, A1IN, A1OUT };
+			struct Entry {
+				Queue queue;
+				std::list<CachePage>::iterator it;
+			};
+			const size_t capacity;
+			const size_t a1in_max;
+			const size_t a1out_max;
+			std::list<CachePage> am;		// most recently used first
+			std::list<CachePage> a1in;		// newest first
+			std::list<CachePage> a1out;		// newest first
+			std::unordered_map<CachePage, Entry, CachePageHash> index;
+
+			void make_room();
+	};
+
+	/**
+	 *	An emulated application buffer cache in front of every target (--cache), shared by all
+	 *	threads. A read op is a hit if all the pages it covers are cached. Writes are write
+	 *	through: they always go to the target, and leave their pages in the cache
+	 */
+	struct BufferCache {
+		enum Policy {
+			CLOCK,
+			LRU,
+			TWO_Q
+		};
+
+		size_t size				= 0;
+		size_t page_size		= 0;		// page=; defaults to the block size
+		Policy policy			= CLOCK;	// policy=
+
+		/**
+		 *	Parse a --cache argument: SIZE, then optional comma separated key=value settings,
+		 *	named as above, and create the policy. block_size is the -b block size
+		 */
+		bool parse(const char * arg, size_t block_size);
+
+		static const char * policy_name(Policy policy);
+
+		/**
+		 *	Look up the pages of an op. Returns true on a hit
+		 */
+		bool lookup(const Target * target, off_t offset, size_t nbytes);
+
+		/**
+		 *	Add the pages of an op that completed
+		 */
+		void insert(const Target * target, off_t offset, size_t nbytes);
+
+		private:
+			std::mutex mutex;
+			std::unique_ptr<ICachePolicy> pages;
+	};
+
+	/**
+	 *	Per-thread buffer cache results. Latencies are in nanoseconds, as hits are much
+	 *	shorter than a microsecond
+	 */
+	struct CacheResults {
+		uint64_t hits				= 0;
+		uint64_t misses				= 0;
+		uint64_t hit_bytes			= 0;
+		uint64_t miss_bytes			= 0;
+
+		Histogram<uint64_t> hit_latency_histogram;
+		Histogram<uint64_t> miss_latency_histogram;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_CACHE_H
@@ -0,0 +1,660 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/*
+ *	LD_PRELOAD library that records an application's file I/O as a diskspd trace (see trace.h)
+ *
+ *		DISKSPD_CAPTURE_FILE=app.trace LD_PRELOAD=bin/libdiskspd_capture.so <application>
+ *		diskspd --replay=app.trace [FILE...]
+ *
+ *	Every process that loads the library writes its own trace, so if the application starts other
+ *	processes use "%p" in DISKSPD_CAPTURE_FILE, which is replaced by the process id. The default
+ *	is diskspd-capture.%p.trace in the working directory.
+ *
+ *	read/pread/write/pwrite/fsync/fdatasync, libaio's io_submit and io_uring_enter are
+ *	intercepted. Only regular files and block devices are traced.
+ *
+ *	Each application thread appends records to its own single-producer ring, and a background
+ *	thread drains the rings into the trace file. Traced threads never take a lock or do trace I/O
+ *	on the fast path; if a ring is full the record is dropped and counted instead.
+ *
+ *	Limitations:
+ *	- io_uring submissions are only seen if the application enters the kernel through libc's
+ *	  syscall() or liburing's exported io_uring_setup/io_uring_enter. SQPOLL rings and registered
+ *	  (fixed) files are not traced.
+ *	- Children created with fork() are not traced.
+ */
+
+// pread/pread64 etc. are intercepted separately, so don't let glibc redirect one to the other
+#undef _FILE_OFFSET_BITS
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <new>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/aio_abi.h>
+#include <linux/io_uring.h>
+#include <linux/limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "../trace.h"
+
+namespace {
+
+	using namespace diskspd;
+
+	const uint64_t RING_SIZE = 8192;			// records per thread; must be a power of 2
+	const int MAX_TRACKED_FDS = 65536;			// I/O on fds above this is not traced
+	const int MAX_URINGS = 64;					// io_uring instances we can decode
+	const long FLUSH_INTERVAL_NS = 10*1000*1000;
+
+	/**
+	 *	Single-producer single-consumer ring of records owned by one application thread
+	 *	Rings are never freed; when a thread exits its ring is handed to the next new thread
+	 */
+	struct ThreadRing {
+		std::atomic<uint64_t> head;		// next record the flusher will read
+		std::atomic<uint64_t> tail;		// next record the owning thread will write
+		std::atomic<bool> in_use;
+		ThreadRing * next;				// global list of all rings
+		TraceRecord records[RING_SIZE];
+	};
+
+	/**
+	 *	What we need to know to decode the submission queue of an io_uring instance
+	 */
+	struct UringState {
+		std::atomic<int> fd;
+		io_sqring_offsets sq_off;
+		size_t sqe_size;
+		std::atomic<char *> sq_ring;
+		std::atomic<char *> sqes;
+	};
+
+	// pointers to the real implementations, looked up lazily with dlsym
+	ssize_t (*real_read)(int, void *, size_t);
+	ssize_t (*real_write)(int, const void *, size_t);
+	ssize_t (*real_pread)(int, void *, size_t, off_t);
+	ssize_t (*real_pwrite)(int, const void *, size_t, off_t);
+	ssize_t (*real_pread64)(int, void *, size_t, off_t);
+	ssize_t (*real_pwrite64)(int, const void *, size_t, off_t);
+	int (*real_fsync)(int);
+	int (*real_fdatasync)(int);
+	int (*real_close)(int);
+	void * (*real_mmap)(void *, size_t, int, int, int, off_t);
+	void * (*real_mmap64)(void *, size_t, int, int, int, off_t);
+	long (*real_syscall)(long, ...);
+	int (*real_io_submit)(aio_context_t, long, struct iocb **);
+	int (*real_io_uring_setup)(unsigned, io_uring_params *);
+	int (*real_io_uring_enter)(unsigned, unsigned, unsigned, unsigned, sigset_t *);
+
+	template <typename F>
+	inline F resolve(F& fn, const char * name) {
+		if (!fn) fn = reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+		return fn;
+	}
+
+#define REAL(name) resolve(real_##name, #name)
+
+	std::atomic<bool> g_enabled(false);
+	std::atomic<bool> g_stop(false);
+	std::atomic<uint64_t> g_dropped(0);
+	std::atomic<ThreadRing *> g_rings(nullptr);
+
+	int g_trace_fd = -1;
+	pthread_t g_flusher;
+	pthread_key_t g_ring_key;
+
+	// fd -> path id + 1. 0 = not looked up yet, -1 = not something we trace
+	std::atomic<int32_t> g_fd_paths[MAX_TRACKED_FDS];
+
+	// path table and the serialized path definitions that haven't been written out yet
+	std::mutex g_path_mutex;
+	std::map<std::string, uint32_t> g_path_ids;
+	std::string g_pending_paths;
+
+	UringState g_urings[MAX_URINGS];
+	std::atomic<int> g_uring_count(0);
+
+	thread_local ThreadRing * t_ring = nullptr;
+	thread_local uint32_t t_tid = 0;
+	// set on the flusher thread and while a hook is doing bookkeeping, to avoid tracing ourselves
+	thread_local bool t_internal = false;
+
+	/**
+	 *	Marks the current thread as internal for the lifetime of the guard
+	 */
+	struct HookGuard {
+		HookGuard() { t_internal = true; }
+		~HookGuard() { t_internal = false; }
+	};
+
+	inline bool tracing() {
+		return g_enabled.load(std::memory_order_relaxed) && !t_internal;
+	}
+
+	inline uint64_t now_ns() {
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return (uint64_t)t.tv_sec*1000000000 + (uint64_t)t.tv_nsec;
+	}
+
+	/**
+	 *	pthread key destructor; gives the ring of an exiting thread back to the pool
+	 */
+	void release_ring(void * ring) {
+		t_ring = nullptr;
+		static_cast<ThreadRing *>(ring)->in_use.store(false, std::memory_order_release);
+	}
+
+	ThreadRing * get_ring() {
+		if (t_ring) return t_ring;
+
+		// try to reuse the ring of a thread that has exited
+		for (ThreadRing * r = g_rings.load(std::memory_order_acquire); r; r = r->next) {
+			bool expected = false;
+			if (r->in_use.compare_exchange_strong(expected, true)) {
+				t_ring = r;
+				break;
+			}
+		}
+
+		if (!t_ring) {
+			ThreadRing * r = new (std::nothrow) ThreadRing();
+			if (!r) return nullptr;
+			r->in_use.store(true);
+			r->next = g_rings.load(std::memory_order_relaxed);
+			while (!g_rings.compare_exchange_weak(r->next, r, std::memory_order_release));
+			t_ring = r;
+		}
+
+		pthread_setspecific(g_ring_key, t_ring);
+		t_tid = (uint32_t)::syscall(SYS_gettid);
+		return t_ring;
+	}
+
+	/**
+	 *	Get the path id for an fd, assigning a new one (and queueing its definition) if needed
+	 *	Returns -1 if the fd isn't a regular file or block device
+	 */
+	int32_t path_for_fd(int fd) {
+		if (fd < 0 || fd >= MAX_TRACKED_FDS) return -1;
+
+		int32_t cached = g_fd_paths[fd].load(std::memory_order_relaxed);
+		if (cached) return cached > 0 ? cached - 1 : -1;
+
+		int32_t id = -1;
+		struct stat buf;
+		if (!fstat(fd, &buf) && (S_ISREG(buf.st_mode) || S_ISBLK(buf.st_mode))) {
+
+			char link[64];
+			char path[PATH_MAX];
+			snprintf(link, sizeof(link), "/proc/self/fd/%d", fd);
+			ssize_t len = readlink(link, path, sizeof(path));
+
+			if (len > 0) {
+				std::lock_guard<std::mutex> lock(g_path_mutex);
+				std::string p(path, len);
+				auto it = g_path_ids.find(p);
+				if (it != g_path_ids.end()) {
+					id = it->second;
+				} else {
+					id = (int32_t)g_path_ids.size();
+					g_path_ids[p] = id;
+
+					// the flusher writes definitions out before any record that uses them
+					TraceRecord def;
+					memset(&def, 0, sizeof(def));
+					def.time_ns = now_ns();
+					def.size = (uint32_t)len;
+					def.path_id = id;
+					def.op = TRACE_OP_PATH;
+					g_pending_paths.append((const char *)&def, sizeof(def));
+					g_pending_paths.append(p);
+				}
+			}
+		}
+
+		g_fd_paths[fd].store(id >= 0 ? id + 1 : -1, std::memory_order_relaxed);
+		return id;
+	}
+
+	void record(uint8_t op, int fd, uint64_t offset, uint64_t size, uint64_t time_ns) {
+		int32_t path_id = path_for_fd(fd);
+		if (path_id < 0) return;
+
+		ThreadRing * ring = get_ring();
+		if (!ring) {
+			++g_dropped;
+			return;
+		}
+
+		uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+		if (tail - ring->head.load(std::memory_order_acquire) >= RING_SIZE) {
+			++g_dropped;
+			return;
+		}
+
+		TraceRecord& r = ring->records[tail & (RING_SIZE - 1)];
+		r.time_ns = time_ns;
+		r.offset = offset;
+		r.size = size > UINT32_MAX ? UINT32_MAX : (uint32_t)size;
+		r.tid = t_tid;
+		r.path_id = (uint32_t)path_id;
+		r.op = op;
+
+		ring->tail.store(tail + 1, std::memory_order_release);
+	}
+
+	void write_all(const char * buf, size_t nbytes) {
+		while (nbytes) {
+			ssize_t ret = REAL(write)(g_trace_fd, buf, nbytes);
+			if (ret <= 0) {
+				if (ret == -1 && errno == EINTR) continue;
+				return;
+			}
+			buf += ret;
+			nbytes -= ret;
+		}
+	}
+
+	void flush(std::vector<TraceRecord>& batch) {
+		batch.clear();
+
+		// drain the rings before taking the path definitions, so that every record we have has
+		// its path definition in g_pending_paths
+		for (ThreadRing * r = g_rings.load(std::memory_order_acquire); r; r = r->next) {
+			uint64_t head = r->head.load(std::memory_order_relaxed);
+			uint64_t tail = r->tail.load(std::memory_order_acquire);
+			for (; head != tail; ++head) {
+				batch.push_back(r->records[head & (RING_SIZE - 1)]);
+			}
+			r->head.store(head, std::memory_order_release);
+		}
+
+		std::string paths;
+		{
+			std::lock_guard<std::mutex> lock(g_path_mutex);
+			paths.swap(g_pending_paths);
+		}
+
+		write_all(paths.data(), paths.size());
+		write_all((const char *)batch.data(), batch.size()*sizeof(TraceRecord));
+	}
+
+	void * flusher_func(void *) {
+		t_internal = true;
+		std::vector<TraceRecord> batch;
+		timespec interval = {0, FLUSH_INTERVAL_NS};
+
+		while (!g_stop.load()) {
+			nanosleep(&interval, nullptr);
+			flush(batch);
+		}
+		flush(batch);
+		return nullptr;
+	}
+
+	void disable_in_child() {
+		g_enabled.store(false);
+	}
+
+	/*
+	 *	**************
+	 *	io_uring state
+	 *	**************
+	 */
+
+	UringState * find_uring(int fd) {
+		int count = g_uring_count.load(std::memory_order_acquire);
+		for (int i = 0; i < count; ++i) {
+			if (g_urings[i].fd.load(std::memory_order_relaxed) == fd) return &g_urings[i];
+		}
+		return nullptr;
+	}
+
+	void track_uring_setup(int fd, const io_uring_params * params) {
+		if (fd < 0 || !params || (params->flags & IORING_SETUP_SQPOLL)) return;
+
+		std::lock_guard<std::mutex> lock(g_path_mutex);
+		int i = g_uring_count.load();
+		if (i == MAX_URINGS) return;
+
+		UringState& u = g_urings[i];
+		u.sq_off = params->sq_off;
+		u.sqe_size = params->flags & IORING_SETUP_SQE128 ? 128 : sizeof(io_uring_sqe);
+		u.sq_ring.store(nullptr);
+		u.sqes.store(nullptr);
+		u.fd.store(fd);
+		g_uring_count.store(i + 1, std::memory_order_release);
+	}
+
+	void track_uring_mmap(void * addr, int fd, off_t offset) {
+		if (addr == MAP_FAILED || !g_uring_count.load(std::memory_order_relaxed)) return;
+
+		UringState * u = find_uring(fd);
+		if (!u) return;
+
+		if (offset == (off_t)IORING_OFF_SQ_RING) {
+			u->sq_ring.store((char *)addr, std::memory_order_release);
+		} else if (offset == (off_t)IORING_OFF_SQES) {
+			u->sqes.store((char *)addr, std::memory_order_release);
+		}
+	}
+
+	void untrack_uring(int fd) {
+		UringState * u = find_uring(fd);
+		if (u) u->fd.store(-1);
+	}
+
+	/**
+	 *	Record the sqes that are about to be consumed by an io_uring_enter
+	 */
+	void record_uring_submit(int fd, unsigned to_submit) {
+		UringState * u = find_uring(fd);
+		if (!u || !to_submit) return;
+
+		char * ring = u->sq_ring.load(std::memory_order_acquire);
+		char * sqes = u->sqes.load(std::memory_order_acquire);
+		if (!ring || !sqes) return;
+
+		unsigned head = __atomic_load_n((unsigned *)(ring + u->sq_off.head), __ATOMIC_ACQUIRE);
+		unsigned tail = __atomic_load_n((unsigned *)(ring + u->sq_off.tail), __ATOMIC_ACQUIRE);
+		unsigned mask = *(unsigned *)(ring + u->sq_off.ring_mask);
+		unsigned * array = (unsigned *)(ring + u->sq_off.array);
+
+		uint64_t now = now_ns();
+
+		for (unsigned i = 0; i < to_submit && head + i != tail; ++i) {
+			unsigned idx = array[(head + i) & mask] & mask;
+			const io_uring_sqe * sqe = (const io_uring_sqe *)(sqes + idx*u->sqe_size);
+
+			if (sqe->flags & IOSQE_FIXED_FILE) continue;
+
+			uint64_t nbytes = sqe->len;
+			uint8_t op;
+
+			switch (sqe->opcode) {
+				case IORING_OP_READ:
+				case IORING_OP_READ_FIXED:
+					op = TRACE_OP_READ;
+					break;
+				case IORING_OP_WRITE:
+				case IORING_OP_WRITE_FIXED:
+					op = TRACE_OP_WRITE;
+					break;
+				case IORING_OP_READV:
+				case IORING_OP_WRITEV: {
+					op = sqe->opcode == IORING_OP_READV ? TRACE_OP_READ : TRACE_OP_WRITE;
+					const iovec * iov = (const iovec *)sqe->addr;
+					nbytes = 0;
+					for (unsigned v = 0; v < sqe->len; ++v) nbytes += iov[v].iov_len;
+					break;
+				}
+				case IORING_OP_FSYNC:
+					op = TRACE_OP_SYNC;
+					nbytes = 0;
+					break;
+				default:
+					continue;
+			}
+			record(op, sqe->fd, sqe->off, nbytes, now);
+		}
+	}
+
+	/*
+	 *	*******************
+	 *	setup and teardown
+	 *	*******************
+	 */
+
+	__attribute__((constructor))
+	void capture_init() {
+		const char * env = getenv("DISKSPD_CAPTURE_FILE");
+		std::string file = env && env[0] ? env : "diskspd-capture.%p.trace";
+
+		size_t pid_pos = file.find("%p");
+		if (pid_pos != std::string::npos) {
+			file.replace(pid_pos, 2, std::to_string(getpid()));
+		}
+
+		g_trace_fd = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (g_trace_fd == -1) {
+			fprintf(stderr, "diskspd capture: couldn't open trace file %s: %s\n",
+					file.c_str(), strerror(errno));
+			return;
+		}
+
+		TraceHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+		header.version = TRACE_VERSION;
+		header.record_size = sizeof(TraceRecord);
+		header.start_time_ns = now_ns();
+		write_all((const char *)&header, sizeof(header));
+
+		pthread_key_create(&g_ring_key, release_ring);
+		pthread_atfork(nullptr, nullptr, disable_in_child);
+
+		if (pthread_create(&g_flusher, nullptr, flusher_func, nullptr)) {
+			fprintf(stderr, "diskspd capture: couldn't start flusher thread\n");
+			REAL(close)(g_trace_fd);
+			return;
+		}
+
+		g_enabled.store(true);
+	}
+
+	__attribute__((destructor))
+	void capture_fini() {
+		if (!g_enabled.load()) return;
+
+		g_enabled.store(false);
+		g_stop.store(true);
+		pthread_join(g_flusher, nullptr);
+		REAL(close)(g_trace_fd);
+
+		if (g_dropped.load()) {
+			fprintf(stderr, "diskspd capture: dropped %lu records (trace rings full)\n",
+					(unsigned long)g_dropped.load());
+		}
+	}
+
+} // namespace
+
+/*
+ *	**************
+ *	intercepted calls
+ *	**************
+ */
+
+extern "C" {
+
+	ssize_t read(int fd, void * buf, size_t count) {
+		if (!tracing()) return REAL(read)(fd, buf, count);
+
+		uint64_t now = now_ns();
+		off_t offset;
+		{
+			HookGuard guard;
+			if (path_for_fd(fd) < 0) return REAL(read)(fd, buf, count);
+			offset = lseek(fd, 0, SEEK_CUR);
+		}
+		ssize_t ret = REAL(read)(fd, buf, count);
+		if (ret > 0) record(TRACE_OP_READ, fd, offset, ret, now);
+		return ret;
+	}
+
+	ssize_t write(int fd, const void * buf, size_t count) {
+		if (!tracing()) return REAL(write)(fd, buf, count);
+
+		uint64_t now = now_ns();
+		off_t offset;
+		{
+			HookGuard guard;
+			if (path_for_fd(fd) < 0) return REAL(write)(fd, buf, count);
+			offset = lseek(fd, 0, SEEK_CUR);
+		}
+		ssize_t ret = REAL(write)(fd, buf, count);
+		if (ret > 0) record(TRACE_OP_WRITE, fd, offset, ret, now);
+		return ret;
+	}
+
+	ssize_t pread(int fd, void * buf, size_t count, off_t offset) {
+		uint64_t now = now_ns();
+		ssize_t ret = REAL(pread)(fd, buf, count, offset);
+		if (ret > 0 && tracing()) record(TRACE_OP_READ, fd, offset, ret, now);
+		return ret;
+	}
+
+	ssize_t pread64(int fd, void * buf, size_t count, off_t offset) {
+		uint64_t now = now_ns();
+		ssize_t ret = REAL(pread64)(fd, buf, count, offset);
+		if (ret > 0 && tracing()) record(TRACE_OP_READ, fd, offset, ret, now);
+		return ret;
+	}
+
+	ssize_t pwrite(int fd, const void * buf, size_t count, off_t offset) {
+		uint64_t now = now_ns();
+		ssize_t ret = REAL(pwrite)(fd, buf, count, offset);
+		if (ret > 0 && tracing()) record(TRACE_OP_WRITE, fd, offset, ret, now);
+		return ret;
+	}
+
+	ssize_t pwrite64(int fd, const void * buf, size_t count, off_t offset) {
+		uint64_t now = now_ns();
+		ssize_t ret = REAL(pwrite64)(fd, buf, count, offset);
+		if (ret > 0 && tracing()) record(TRACE_OP_WRITE, fd, offset, ret, now);
+		return ret;
+	}
+
+	int fsync(int fd) {
+		if (tracing()) record(TRACE_OP_SYNC, fd, 0, 0, now_ns());
+		return REAL(fsync)(fd);
+	}
+
+	int fdatasync(int fd) {
+		if (tracing()) record(TRACE_OP_SYNC, fd, 0, 0, now_ns());
+		return REAL(fdatasync)(fd);
+	}
+
+	int close(int fd) {
+		if (fd >= 0 && fd < MAX_TRACKED_FDS) {
+			g_fd_paths[fd].store(0, std::memory_order_relaxed);
+		}
+		if (g_uring_count.load(std::memory_order_relaxed)) untrack_uring(fd);
+		return REAL(close)(fd);
+	}
+
+	void * mmap(void * addr, size_t length, int prot, int flags, int fd, off_t offset) {
+		void * ret = REAL(mmap)(addr, length, prot, flags, fd, offset);
+		track_uring_mmap(ret, fd, offset);
+		return ret;
+	}
+
+	void * mmap64(void * addr, size_t length, int prot, int flags, int fd, off_t offset) {
+		void * ret = REAL(mmap64)(addr, length, prot, flags, fd, offset);
+		track_uring_mmap(ret, fd, offset);
+		return ret;
+	}
+
+	/**
+	 *	libaio
+	 */
+	int io_submit(aio_context_t ctx, long nr, struct iocb ** iocbs) {
+		if (!REAL(io_submit)) return -ENOSYS;
+
+		if (tracing() && nr > 0) {
+			uint64_t now = now_ns();
+			for (long i = 0; i < nr; ++i) {
+				const struct iocb * cb = iocbs[i];
+				uint64_t nbytes = cb->aio_nbytes;
+
+				switch (cb->aio_lio_opcode) {
+					case IOCB_CMD_PREAD:
+						record(TRACE_OP_READ, cb->aio_fildes, cb->aio_offset, nbytes, now);
+						break;
+					case IOCB_CMD_PWRITE:
+						record(TRACE_OP_WRITE, cb->aio_fildes, cb->aio_offset, nbytes, now);
+						break;
+					case IOCB_CMD_PREADV:
+					case IOCB_CMD_PWRITEV: {
+						const iovec * iov = (const iovec *)cb->aio_buf;
+						nbytes = 0;
+						for (uint64_t v = 0; v < cb->aio_nbytes; ++v) nbytes += iov[v].iov_len;
+						record(cb->aio_lio_opcode == IOCB_CMD_PREADV ? TRACE_OP_READ : TRACE_OP_WRITE,
+								cb->aio_fildes, cb->aio_offset, nbytes, now);
+						break;
+					}
+					case IOCB_CMD_FSYNC:
+					case IOCB_CMD_FDSYNC:
+						record(TRACE_OP_SYNC, cb->aio_fildes, 0, 0, now);
+						break;
+					default:
+						break;
+				}
+			}
+		}
+		return REAL(io_submit)(ctx, nr, iocbs);
+	}
+
+	/**
+	 *	liburing's exported syscall wrappers
+	 */
+	int io_uring_setup(unsigned entries, io_uring_params * params) {
+		if (!REAL(io_uring_setup)) return -ENOSYS;
+		int fd = REAL(io_uring_setup)(entries, params);
+		if (g_enabled.load()) track_uring_setup(fd, params);
+		return fd;
+	}
+
+	int io_uring_enter(unsigned fd, unsigned to_submit, unsigned min_complete, unsigned flags,
+			sigset_t * sig) {
+		if (!REAL(io_uring_enter)) return -ENOSYS;
+		if (tracing()) record_uring_submit(fd, to_submit);
+		return REAL(io_uring_enter)(fd, to_submit, min_complete, flags, sig);
+	}
+
+	/**
+	 *	libc's generic syscall wrapper, for io_uring users that don't go through liburing
+	 */
+	long syscall(long number, ...) {
+		va_list ap;
+		va_start(ap, number);
+		long a1 = va_arg(ap, long);
+		long a2 = va_arg(ap, long);
+		long a3 = va_arg(ap, long);
+		long a4 = va_arg(ap, long);
+		long a5 = va_arg(ap, long);
+		long a6 = va_arg(ap, long);
+		va_end(ap);
+
+		if (number == SYS_io_uring_enter && tracing()) {
+			record_uring_submit((int)a1, (unsigned)a2);
+		}
+
+		long ret = REAL(syscall)(number, a1, a2, a3, a4, a5, a6);
+
+		if (number == SYS_io_uring_setup && g_enabled.load()) {
+			track_uring_setup((int)ret, (const io_uring_params *)a2);
+		}
+		return ret;
+	}
+
+} // extern "C"
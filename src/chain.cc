@@ -0,0 +1,228 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "debug.h"
+#include "async_io.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "chain.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool parse_chain(const char * arg, std::vector<ChainStep>& chain) {
+
+		bool has_io = false;
+
+		while (*arg) {
+			ChainStep step;
+			switch (*arg) {
+				case 'r': step = CHAIN_READ;		break;
+				case 'w': step = CHAIN_WRITE;		break;
+				case 'R': step = CHAIN_READ_SAME;	break;
+				case 'W': step = CHAIN_WRITE_SAME;	break;
+				case 'f': step = CHAIN_SYNC;		break;
+				default:
+					fprintf(stderr, "Invalid --chain step '%c'. Choose from r, w, R, W, f\n", *arg);
+					return false;
+			}
+			++arg;
+
+			// optional repeat count
+			unsigned long count = 1;
+			if (*arg >= '0' && *arg <= '9') {
+				char * end;
+				count = strtoul(arg, &end, 10);
+				arg = end;
+				if (!count) {
+					fprintf(stderr, "--chain repeat counts must be at least 1\n");
+					return false;
+				}
+			}
+
+			chain.insert(chain.end(), count, step);
+			has_io |= step != CHAIN_SYNC;
+		}
+
+		if (!has_io) {
+			fprintf(stderr, "--chain must contain at least one read or write\n");
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 *	State of one -o slot working through the chain
+	 */
+	struct ChainSlot {
+		std::shared_ptr<IAsyncIop> op;
+		std::shared_ptr<TargetData> t_data;
+		size_t step = 0;			// index of the step in flight
+		off_t offset = 0;			// offset of the slot's last read or write
+		off_t next_offset = 0;		// offset for the slot's next r or w step
+		uint64_t start_us = 0;		// when the current pass through the chain started
+	};
+
+	/**
+	 *	Run a slot's chain up to its next read or write, and enqueue it. Steps that don't need the
+	 *	io manager (fsync) are done here, as are completed chains
+	 */
+	static bool advance_chain(ThreadParams& thread, ChainSlot& slot) {
+
+		const std::vector<ChainStep>& chain = thread.job_options->chain;
+
+		while (true) {
+
+			uint64_t now_us = PerfClock::get_time_us();
+
+			if (slot.step == chain.size()) {
+				if (*thread.record_results) {
+					++slot.t_data->results->chain_count;
+					if (thread.job_options->measure_latency) {
+						slot.t_data->results->chain_latency_histogram.Add(now_us - slot.start_us);
+					}
+				}
+				slot.step = 0;
+				slot.start_us = now_us;
+			}
+
+			ChainStep step = chain[slot.step];
+
+			if (step == CHAIN_SYNC) {
+				if (fsync(slot.t_data->fd)) {
+					perror("fsync failed");
+					thread.thread_abort();
+					return false;
+				}
+				++slot.step;
+				continue;
+			}
+
+			if (step == CHAIN_READ || step == CHAIN_WRITE) {
+				slot.offset = slot.next_offset;
+				slot.next_offset = slot.t_data->get_next_offset(slot.next_offset);
+			}
+
+			slot.op->set_type(step == CHAIN_READ || step == CHAIN_READ_SAME ?
+					IAsyncIop::Type::READ : IAsyncIop::Type::WRITE);
+			slot.op->set_offset(slot.offset);
+			slot.op->set_time(now_us);
+
+			if (thread.io_manager->enqueue(slot.op)) {
+				perror("aio enqueue failed");
+				thread.thread_abort();
+				return false;
+			}
+			return true;
+		}
+	}
+
+	void ThreadParams::chain_func() {
+
+		int aio_result = 0;
+
+		std::vector<ChainSlot> slots;
+		// the slot each op belongs to, to find it again when the op completes
+		std::map<IAsyncIop *, size_t> slot_index;
+
+		for (auto& t_data : targets) {
+
+			off_t curr_offset = t_data->get_start_offset();
+
+			for (unsigned int i = 0; i < t_data->target->overlap; ++i) {
+
+				void * read_buf = static_cast<char *>(t_data->buffer.ptr()) + i*t_data->target->block_size;
+				void * write_buf =
+					t_data->target->separate_buffers ? t_data->write_buffer.ptr() : read_buf;
+
+				ChainSlot slot;
+				slot.t_data = t_data;
+				slot.op = io_manager->construct(
+						IAsyncIop::Type::READ,
+						t_data->fd,
+						curr_offset,
+						read_buf,
+						write_buf,
+						t_data->target->block_size,
+						thread_id,
+						t_data,
+						0
+						);
+				slot.offset = curr_offset;
+				slot.next_offset = curr_offset;
+				slot.start_us = PerfClock::get_time_us();
+
+				slot_index[slot.op.get()] = slots.size();
+				slots.push_back(slot);
+
+				curr_offset = t_data->get_next_offset(curr_offset);
+			}
+		}
+
+		for (auto& slot : slots) {
+			if (!advance_chain(*this, slot)) {
+				return;
+			}
+		}
+
+		aio_result = io_manager->submit(thread_id);
+		if (aio_result) {
+			perror("aio submit failed");
+			thread_abort();
+			return;
+		}
+
+		// Unblock main thread (so the job can start the warmup/duration)
+		signal_initialized();
+
+		/************
+		 *	Do Work
+		 ************/
+
+		while(*run_threads) {
+
+			// block until an operation completes
+			std::shared_ptr<IAsyncIop> op = io_manager->wait(thread_id);
+
+			// potentially exit right after waiting for io - improves accuracy of duration
+			if (!*run_threads) break;
+
+			if (!check_completion(op)) {
+				return;
+			}
+
+			if (*record_results) {
+				record_completion(op, PerfClock::get_time_us());
+			}
+
+			// only now can the slot move on to its next step
+			ChainSlot& slot = slots[slot_index[op.get()]];
+			++slot.step;
+			if (!advance_chain(*this, slot)) {
+				return;
+			}
+
+			aio_result = io_manager->submit(thread_id);
+			if (aio_result) {
+				perror("aio submit failed");
+				thread_abort();
+				return;
+			}
+		}
+
+		// release resources
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+
+#ifndef DISKSPD_CHAIN_H
+#define DISKSPD_CHAIN_H
+
+namespace diskspd {
+
+	/**
+	 *	A step of a --chain. Each -o slot works through the steps of the chain in order, only
+	 *	starting a step once the previous one has completed, then starts the chain over
+	 */
+	enum ChainStep {
+		CHAIN_READ,			// r: read at the slot's next offset
+		CHAIN_WRITE,		// w: write at the slot's next offset
+		CHAIN_READ_SAME,	// R: read again at the offset of the slot's previous op
+		CHAIN_WRITE_SAME,	// W: write back to the offset of the slot's previous op
+		CHAIN_SYNC			// f: fsync the target
+	};
+
+	/**
+	 *	Parse a --chain argument: a sequence of step letters, each optionally followed by a repeat
+	 *	count (e.g. "r4" is four dependent reads). Prints an error and returns false if invalid
+	 */
+	bool parse_chain(const char * arg, std::vector<ChainStep>& chain);
+
+} // namespace diskspd
+
+#endif // DISKSPD_CHAIN_H
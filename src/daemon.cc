@@ -0,0 +1,250 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "debug.h"
+#include "options.h"
+#include "profile.h"
+#include "sys_info.h"
+#include "target.h"
+#include "daemon.h"
+
+namespace diskspd {
+
+	// the longest request line read
+	static const size_t MAX_REQUEST = 64*1024;
+
+	// how long a client has to send its request
+	static const time_t REQUEST_TIMEOUT_S = 10;
+
+	static bool write_all(int fd, const char * buf, size_t len) {
+		while (len) {
+			ssize_t n = write(fd, buf, len);
+			if (n == -1 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			buf += n;
+			len -= n;
+		}
+		return true;
+	}
+
+	/**
+	 *	The address of a socket, or false if the path doesn't fit in one
+	 */
+	static bool socket_address(const std::string& path, struct sockaddr_un& addr) {
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+			fprintf(stderr, "Invalid socket path \"%s\"\n", path.c_str());
+			return false;
+		}
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		return true;
+	}
+
+	bool Daemon::serve() {
+
+		struct sockaddr_un addr;
+		if (!socket_address(socket, addr)) {
+			return false;
+		}
+
+		sys_info = std::make_shared<SysInfo>();
+		sys_info->init_sys_info(nullptr);
+
+		// a bad request mustn't end the daemon, nor a client that goes away during its run
+		Options::exit_on_error = false;
+		signal(SIGPIPE, SIG_IGN);
+		TargetBuffer::keep_freed(true);
+
+		int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (listener == -1) {
+			perror("socket");
+			return false;
+		}
+
+		// a socket left by an earlier daemon is replaced, but nothing else is
+		struct stat buf;
+		if (!stat(socket.c_str(), &buf) && S_ISSOCK(buf.st_mode)) {
+			unlink(socket.c_str());
+		}
+		if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) || listen(listener, SOMAXCONN)) {
+			fprintf(stderr, "Couldn't listen on %s: %s\n", socket.c_str(), strerror(errno));
+			close(listener);
+			return false;
+		}
+		printf("Listening on %s\n", socket.c_str());
+		fflush(stdout);
+
+		while (true) {
+			int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (fd == -1) {
+				if (errno == EINTR || errno == ECONNABORTED) continue;
+				perror("accept");
+				break;
+			}
+
+			// the request is everything up to the first newline
+			struct timeval timeout = { REQUEST_TIMEOUT_S, 0 };
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+			std::string line;
+			char chunk[4096];
+			while (line.find('\n') == std::string::npos && line.size() < MAX_REQUEST) {
+				ssize_t n = read(fd, chunk, sizeof(chunk));
+				if (n == -1 && errno == EINTR) continue;
+				if (n <= 0) break;
+				line.append(chunk, n);
+			}
+			if (line.find('\n') == std::string::npos) {
+				fprintf(stderr, "Dropped an incomplete request\n");
+				close(fd);
+				continue;
+			}
+			line.erase(line.find('\n'));
+
+			int status = run(line, fd);
+
+			std::string end = std::string(1, '\0') + std::to_string(status) + "\n";
+			write_all(fd, end.c_str(), end.size());
+			close(fd);
+		}
+
+		close(listener);
+		return false;
+	}
+
+	int Daemon::run(const std::string& line, int fd) {
+
+		// the request is a command line, split on spaces as a --group is
+		std::vector<std::string> words = { "diskspd" };
+		std::istringstream stream(line);
+		for (std::string word; stream >> word; ) {
+			words.push_back(word);
+		}
+		std::vector<char *> argv;
+		for (auto& word : words) {
+			argv.push_back(&word[0]);
+		}
+
+		// everything the run prints goes to the client
+		fflush(stdout);
+		fflush(stderr);
+		int saved_stdout = dup(STDOUT_FILENO);
+		int saved_stderr = dup(STDERR_FILENO);
+		dup2(fd, STDOUT_FILENO);
+		dup2(fd, STDERR_FILENO);
+
+		int status = 1;
+
+		// -a is picked out first, as the Profile takes the SysInfo as it is
+		Options options;
+		if (options.parse_args(argv.size(), argv.data())) {
+			std::shared_ptr<SysInfo> run_info = std::make_shared<SysInfo>(*sys_info);
+			if (const char * affinity = options.get_arg(CPU_AFFINITY)) {
+				run_info->set_affinity(affinity);
+			}
+			verbose = false;
+			debug = false;
+
+			Profile profile;
+			profile.set_sys_info(run_info);
+			if (!profile.parse_options(argv.size(), argv.data())) {
+				// nothing more to say
+			} else if (profile.get_mode() == Profile::Mode::DAEMON ||
+					profile.get_mode() == Profile::Mode::CONNECT) {
+				fprintf(stderr, "Can't use --daemon or --connect in a request!\n");
+			} else if (profile.get_mode() == Profile::Mode::SYNTHESIZE) {
+				status = profile.synthesize() ? 0 : 1;
+			} else if (profile.run_jobs()) {
+				profile.get_results();
+				status = 0;
+			}
+		}
+
+		fflush(stdout);
+		fflush(stderr);
+		dup2(saved_stdout, STDOUT_FILENO);
+		dup2(saved_stderr, STDERR_FILENO);
+		close(saved_stdout);
+		close(saved_stderr);
+
+		// the buffers this run freed stay for the next one; any older ones go
+		TargetBuffer::trim_kept();
+		return status;
+	}
+
+	int Daemon::request(const std::string& socket, const std::vector<std::string>& args) {
+
+		std::string line;
+		for (auto& arg : args) {
+			if (arg.empty() || arg.find_first_of(" \t\r\n") != std::string::npos) {
+				fprintf(stderr, "Arguments for a --daemon can't be empty or have spaces in them\n");
+				return 1;
+			}
+			line += (line.empty() ? "" : " ") + arg;
+		}
+		line += '\n';
+
+		struct sockaddr_un addr;
+		if (!socket_address(socket, addr)) {
+			return 1;
+		}
+		int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd == -1) {
+			perror("socket");
+			return 1;
+		}
+		if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+				!write_all(fd, line.c_str(), line.size())) {
+			fprintf(stderr, "Couldn't send the run to the daemon at %s: %s\n", socket.c_str(),
+					strerror(errno));
+			close(fd);
+			return 1;
+		}
+
+		// the output as it comes, up to the NUL before the status
+		bool ended = false;
+		std::string status;
+		char chunk[4096];
+		while (true) {
+			ssize_t n = read(fd, chunk, sizeof(chunk));
+			if (n == -1 && errno == EINTR) continue;
+			if (n <= 0) break;
+			if (ended) {
+				status.append(chunk, n);
+				continue;
+			}
+			const char * nul = static_cast<const char *>(memchr(chunk, '\0', n));
+			size_t output = nul ? nul - chunk : n;
+			fwrite(chunk, 1, output, stdout);
+			fflush(stdout);
+			if (nul) {
+				ended = true;
+				status.append(nul + 1, n - output - 1);
+			}
+		}
+		close(fd);
+
+		if (!ended) {
+			fprintf(stderr, "The daemon closed the connection before the run ended\n");
+			return 1;
+		}
+		return atoi(status.c_str());
+	}
+
+} // namespace diskspd
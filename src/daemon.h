@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#ifndef DISKSPD_DAEMON_H
+#define DISKSPD_DAEMON_H
+
+namespace diskspd {
+
+	struct SysInfo;
+
+	/**
+	 *	A diskspd that stays up and does runs for others (--daemon), so running it back to back
+	 *	doesn't mean starting it every time. It listens on a UNIX domain socket and does one run
+	 *	per connection, one at a time so runs don't disturb each other's results.
+	 *
+	 *	A request is a line of arguments, as on the command line but split on spaces. The run's
+	 *	stdout and stderr go to the connection as it runs, then a NUL byte and the exit status
+	 *	diskspd would have had, as text. Runs share the SysInfo read when the daemon started,
+	 *	and I/O buffers are kept from one run to the next (see TargetBuffer::keep_freed); files
+	 *	were already only laid out when they don't exist or are too small.
+	 *
+	 *	Runs happen in the daemon itself, so anything that ends diskspd ends the daemon too
+	 */
+	class Daemon {
+		public:
+			Daemon(const std::string& socket) : socket(socket) {}
+
+			/**
+			 *	Listen on the socket and serve requests. Only returns if it can't listen
+			 */
+			bool serve();
+
+			/**
+			 *	--connect; have the daemon listening on a socket do a run, printing its output as
+			 *	it comes. Returns the run's exit status
+			 */
+			static int request(const std::string& socket, const std::vector<std::string>& args);
+
+		private:
+			std::string socket;
+
+			// read once, and copied for each run so its -a is its own
+			std::shared_ptr<SysInfo> sys_info;
+
+			/**
+			 *	Do the run a request asks for, with its output going to fd. Returns its exit
+			 *	status
+			 */
+			int run(const std::string& line, int fd);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_DAEMON_H
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include "profile.h"
+#include "daemon.h"
 
 int main(int argc, char ** argv) {
 
@@ -12,6 +13,19 @@ int main(int argc, char ** argv) {
 		return 1;
 	}
 
+	// --daemon serves runs until it's killed, and --connect has one of them do this one
+	if (profile.get_mode() == diskspd::Profile::Mode::DAEMON) {
+		return diskspd::Daemon(profile.get_socket()).serve() ? 0 : 1;
+	}
+	if (profile.get_mode() == diskspd::Profile::Mode::CONNECT) {
+		return diskspd::Daemon::request(profile.get_socket(), profile.get_request());
+	}
+
+	// --synthesize only describes a trace; there's nothing to run
+	if (profile.get_mode() == diskspd::Profile::Mode::SYNTHESIZE) {
+		return profile.synthesize() ? 0 : 1;
+	}
+
 	// run the profile
 	if (!profile.run_jobs()) {
 		return 1;
@@ -0,0 +1,423 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "debug.h"
+#include "async_io.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "erasure.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool ErasureSet::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t end = settings.find(',');
+		if (end == std::string::npos) end = settings.size();
+
+		// K+M comes first
+		std::string layout = settings.substr(0, end);
+		size_t plus = layout.find('+');
+		char * data_end = nullptr;
+		char * parity_end = nullptr;
+		long k = plus == std::string::npos ? 0 : strtol(layout.c_str(), &data_end, 10);
+		long m = plus == std::string::npos ? 0 : strtol(layout.c_str() + plus + 1, &parity_end, 10);
+		if (!k || data_end != layout.c_str() + plus || *parity_end) {
+			fprintf(stderr, "Invalid --erasure argument; expected K+M\n");
+			return false;
+		}
+		// the Cauchy matrix needs K+M distinct field elements
+		if (k < 1 || m < 1 || k + m > 256) {
+			fprintf(stderr, "--erasure needs at least one data and one parity member, and at most 256 in all\n");
+			return false;
+		}
+		data = k;
+		parity = m;
+
+		size_t pos = end + 1;
+		while (pos < settings.size()) {
+			end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --erasure setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			if (key == "simd" && (value == "scalar" || value == "avx2" || value == "avx512")) {
+				simd = value == "avx512" ? Gf256::Simd::AVX512 :
+					value == "avx2" ? Gf256::Simd::AVX2 : Gf256::Simd::SCALAR;
+				if (!Gf256::supported(simd)) {
+					fprintf(stderr, "This CPU doesn't support --erasure simd=%s\n", value.c_str());
+					return false;
+				}
+			} else if (key == "read" && (value == "any" || value == "data")) {
+				read_any = value == "any";
+			} else {
+				fprintf(stderr, "Invalid --erasure setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+
+		// Cauchy matrix: 1/(x_i + y_j) with x_i = K+i and y_j = j. Every square submatrix of a
+		// Cauchy matrix is invertible, which is what lets any K chunks rebuild the data.
+		// Scaling a column keeps that true, so scale each one to make the first row all ones
+		matrix.resize(parity*data);
+		for (unsigned int i = 0; i < parity; ++i) {
+			for (unsigned int j = 0; j < data; ++j) {
+				matrix[i*data + j] = Gf256::inv((data + i) ^ j);
+			}
+		}
+		for (unsigned int j = 0; j < data; ++j) {
+			uint8_t scale = Gf256::inv(matrix[j]);
+			for (unsigned int i = 0; i < parity; ++i) {
+				matrix[i*data + j] = Gf256::mul(matrix[i*data + j], scale);
+			}
+		}
+		return true;
+	}
+
+	void ErasureSet::encode(const uint8_t * const * data_chunks, uint8_t * const * parity_chunks,
+			size_t len) const {
+		for (unsigned int i = 0; i < parity; ++i) {
+			Gf256::dot(simd, &matrix[i*data], data_chunks, data, parity_chunks[i], len);
+		}
+	}
+
+	bool ErasureSet::decode_matrix(const std::vector<unsigned int>& chunks,
+			std::vector<uint8_t>& out) const {
+
+		// the rows of the generator matrix (the identity, then the parity rows) that made them
+		out.assign(data*data, 0);
+		for (unsigned int r = 0; r < data; ++r) {
+			if (chunks[r] < data) {
+				out[r*data + chunks[r]] = 1;
+			} else {
+				std::copy(&matrix[(chunks[r] - data)*data], &matrix[(chunks[r] - data + 1)*data],
+						&out[r*data]);
+			}
+		}
+		return Gf256::invert(out, data);
+	}
+
+	/**
+	 *	A timestamp for the parity math: TSC cycles on x86, nanoseconds elsewhere
+	 */
+	static inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return PerfClock::get_time_ns();
+#endif
+	}
+
+	/**
+	 *	State of one -o slot of logical ops
+	 */
+	struct ErasureSlot {
+		// one op per member, reused for each logical op, and its buffer
+		std::vector<std::shared_ptr<IAsyncIop>> member_ops;
+		std::vector<uint8_t *> buffers;
+		IAsyncIop::Type type;
+		off_t offset = 0;					// logical offset
+		uint64_t start_us = 0;
+		unsigned int in_flight = 0;			// member ops not yet completed
+		std::vector<unsigned int> chunks;	// the chunks a read is reading
+		uint8_t * rebuilt = nullptr;		// room for the data chunks a read rebuilds
+	};
+
+	/**
+	 *	Per-thread state of the --erasure workload
+	 */
+	class ErasureThread {
+		public:
+			ErasureThread(ThreadParams& thread) :
+				thread(thread),
+				set(*thread.job_options->erasure),
+				block_size(set.logical->block_size),
+				all_chunks(set.members()),
+				data_chunks(set.data),
+				parity_chunks(set.parity) {}
+
+			/**
+			 *	Create the member ops and start every slot's first logical op
+			 */
+			bool start() {
+
+				logical = std::make_shared<TargetData>();
+				logical->target = set.logical;
+				logical->results = thread.results->logical_results;
+				logical->thread = thread.targets[0]->thread;
+				logical->rng_engine = thread.rng_engine;
+
+				for (unsigned int c = 0; c < all_chunks.size(); ++c) {
+					all_chunks[c] = c;
+				}
+
+				slots.resize(set.logical->overlap);
+				rebuilt_buffer.calloc(slots.size()*set.parity*block_size, 64);
+
+				off_t curr_offset = logical->get_start_offset();
+				for (size_t i = 0; i < slots.size(); ++i) {
+					ErasureSlot& slot = slots[i];
+					slot.offset = curr_offset;
+					curr_offset = logical->get_next_offset(curr_offset);
+					slot.rebuilt = static_cast<uint8_t *>(rebuilt_buffer.ptr()) + i*set.parity*block_size;
+
+					// parity is computed in place, so every op writes from its own buffer
+					for (auto& t_data : thread.targets) {
+						uint8_t * buf = static_cast<uint8_t *>(t_data->buffer.ptr()) + i*block_size;
+						slot.buffers.push_back(buf);
+						slot.member_ops.push_back(thread.io_manager->construct(
+								IAsyncIop::Type::READ,
+								t_data->fd,
+								t_data->target->base_offset,
+								buf,
+								buf,
+								block_size,
+								thread.thread_id,
+								t_data,
+								0
+								));
+						slot_index[slot.member_ops.back().get()] = i;
+					}
+
+					if (!start_op(slot)) {
+						return false;
+					}
+				}
+				return submit();
+			}
+
+			/**
+			 *	Wait for the next member op, and finish its logical op if it was the last one.
+			 *	Returns false if the thread has to stop
+			 */
+			bool step() {
+
+				std::shared_ptr<IAsyncIop> op = thread.io_manager->wait(thread.thread_id);
+
+				// potentially exit right after waiting for io - improves accuracy of duration
+				if (!*thread.run_threads) return false;
+
+				if (!thread.check_completion(op)) {
+					return false;
+				}
+
+				bool record = *thread.record_results;
+				if (record) {
+					thread.record_completion(op, PerfClock::get_time_us());
+				}
+
+				ErasureSlot& slot = slots[slot_index[op.get()]];
+				if (--slot.in_flight) {
+					return true;
+				}
+
+				if (slot.type == IAsyncIop::Type::READ && !rebuild(slot, record)) {
+					return false;
+				}
+
+				if (record) {
+					thread.record_logical_completion(slot.type == IAsyncIop::Type::WRITE,
+							set.data*block_size, slot.start_us, PerfClock::get_time_us());
+				}
+
+				slot.offset = logical->get_next_offset(slot.offset);
+				return start_op(slot) && submit();
+			}
+
+		private:
+			ThreadParams& thread;
+			const ErasureSet& set;
+			const size_t block_size;
+
+			// the logical op offsets come from a TargetData for the set, like any target's
+			std::shared_ptr<TargetData> logical;
+			std::vector<ErasureSlot> slots;
+			std::map<IAsyncIop *, size_t> slot_index;
+			TargetBuffer rebuilt_buffer;
+
+			std::vector<unsigned int> all_chunks;
+			// chunk pointers for the parity math; on a read, data_chunks holds the chunks read
+			std::vector<const uint8_t *> data_chunks;
+			std::vector<uint8_t *> parity_chunks;
+			// decode matrices, by the chunks that were read
+			std::map<std::vector<unsigned int>, std::vector<uint8_t>> decode_matrices;
+
+			/**
+			 *	Start a slot's logical op at its offset: encode and write every chunk, or read K
+			 */
+			bool start_op(ErasureSlot& slot) {
+
+				slot.type = thread.rw_rng_engine->get_percentage() <= set.logical->write_percentage ?
+					IAsyncIop::Type::WRITE : IAsyncIop::Type::READ;
+				slot.start_us = PerfClock::get_time_us();
+				uint64_t stripe = slot.offset/block_size;
+
+				if (slot.type == IAsyncIop::Type::WRITE) {
+					for (unsigned int c = 0; c < set.data; ++c) {
+						data_chunks[c] = slot.buffers[set.member(stripe, c)];
+					}
+					for (unsigned int c = 0; c < set.parity; ++c) {
+						parity_chunks[c] = slot.buffers[set.member(stripe, set.data + c)];
+					}
+
+					uint64_t begin = read_cycles();
+					set.encode(data_chunks.data(), parity_chunks.data(), block_size);
+					uint64_t end = read_cycles();
+
+					if (*thread.record_results) {
+						ErasureResults& results = *thread.results->erasure_results;
+						++results.encodes;
+						results.encode_bytes += set.data*block_size;
+						results.encode_cycles += end - begin;
+					}
+					slot.chunks = all_chunks;
+
+				} else if (set.read_any) {
+					// any K chunks; pick them like the first K of a shuffle
+					std::vector<unsigned int> shuffled(all_chunks);
+					for (unsigned int c = 0; c < set.data; ++c) {
+						std::swap(shuffled[c], shuffled[c + thread.rw_rng_engine->get_rand_offset(
+								shuffled.size() - c)]);
+					}
+					slot.chunks.assign(shuffled.begin(), shuffled.begin() + set.data);
+					std::sort(slot.chunks.begin(), slot.chunks.end());
+
+				} else {
+					slot.chunks.assign(all_chunks.begin(), all_chunks.begin() + set.data);
+				}
+
+				uint64_t now = PerfClock::get_time_us();
+				for (auto chunk : slot.chunks) {
+					size_t m = set.member(stripe, chunk);
+					std::shared_ptr<IAsyncIop>& op = slot.member_ops[m];
+					op->set_type(slot.type);
+					op->set_offset(thread.targets[m]->target->base_offset + slot.offset);
+					op->set_time(now);
+
+					if (thread.io_manager->enqueue(op)) {
+						perror("aio enqueue failed");
+						thread.thread_abort();
+						return false;
+					}
+					++slot.in_flight;
+				}
+				return true;
+			}
+
+			bool submit() {
+				if (thread.io_manager->submit(thread.thread_id)) {
+					perror("aio submit failed");
+					thread.thread_abort();
+					return false;
+				}
+				return true;
+			}
+
+			/**
+			 *	Rebuild the data chunks a read didn't read from the ones it did
+			 */
+			bool rebuild(ErasureSlot& slot, bool record) {
+
+				ErasureResults& results = *thread.results->erasure_results;
+				if (record) ++results.reads;
+
+				// the chunks are sorted, so the data chunks that were read come first
+				unsigned int data_read = 0;
+				while (data_read < set.data && slot.chunks[data_read] < set.data) ++data_read;
+				if (data_read == set.data) {
+					return true;
+				}
+
+				uint64_t begin = read_cycles();
+
+				auto it = decode_matrices.find(slot.chunks);
+				if (it == decode_matrices.end()) {
+					std::vector<uint8_t> decode;
+					if (!set.decode_matrix(slot.chunks, decode)) {
+						fprintf(stderr, "Can't decode --erasure chunks\n");
+						thread.thread_abort();
+						return false;
+					}
+					it = decode_matrices.insert(std::make_pair(slot.chunks, decode)).first;
+				}
+
+				uint64_t stripe = slot.offset/block_size;
+				for (unsigned int r = 0; r < set.data; ++r) {
+					data_chunks[r] = slot.buffers[set.member(stripe, slot.chunks[r])];
+				}
+
+				unsigned int rebuilt = 0;
+				for (unsigned int d = 0, r = 0; d < set.data; ++d) {
+					if (r < data_read && slot.chunks[r] == d) {
+						++r;
+						continue;
+					}
+					Gf256::dot(set.simd, &it->second[d*set.data], data_chunks.data(), set.data,
+							slot.rebuilt + rebuilt*block_size, block_size);
+					++rebuilt;
+				}
+
+				uint64_t end = read_cycles();
+
+				if (record) {
+					++results.decodes;
+					results.decode_bytes += set.data*block_size;
+					results.decode_cycles += end - begin;
+					results.rebuilt_chunks += rebuilt;
+				}
+				return true;
+			}
+	};
+
+	void ThreadParams::erasure_func() {
+
+		ErasureThread erasure(*this);
+
+		if (!erasure.start()) {
+			return;
+		}
+
+		// Unblock main thread (so the job can start the warmup/duration)
+		signal_initialized();
+
+		/************
+		 *	Do Work
+		 ************/
+
+		while (*run_threads) {
+			if (!erasure.step()) {
+				break;
+			}
+		}
+
+		// release resources
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
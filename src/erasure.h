@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "gf256.h"
+
+#ifndef DISKSPD_ERASURE_H
+#define DISKSPD_ERASURE_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	An erasure coded set of all of a Job's targets (--erasure): K data and M parity members,
+	 *	with a systematic Reed-Solomon code over GF(2^8). Logical ops are generated on the
+	 *	'logical' target, and each covers one -b block at the same offset on every member.
+	 *	A write computes the parity chunks from the K data chunks and writes all K+M; a read
+	 *	reads K chunks and rebuilds any data chunks that weren't among them.
+	 *
+	 *	The chunks rotate across the members from one stripe to the next, as in RAID5.
+	 *	Parity is a Cauchy matrix with its columns scaled so that the first parity row is all
+	 *	ones, so the first parity chunk is a plain XOR, and --erasure=K+1 is RAID5
+	 */
+	struct ErasureSet {
+		unsigned int data			= 0;
+		unsigned int parity			= 0;
+		Gf256::Simd simd			= Gf256::best_simd();	// simd=
+		bool read_any				= true;					// read=any, or read=data
+
+		// parity x data coefficients, row-major
+		std::vector<uint8_t> matrix;
+
+		// one block on every member; holds the offset, -w and -o settings for logical ops
+		std::shared_ptr<Target> logical;
+
+		/**
+		 *	Parse an --erasure argument: K+M, then optional comma separated key=value settings,
+		 *	named as above. Builds the matrix
+		 */
+		bool parse(const char * arg);
+
+		inline unsigned int members() const { return data + parity; }
+
+		/**
+		 *	The member a stripe's chunk (data chunks first, then parity) is on
+		 */
+		inline size_t member(uint64_t stripe, unsigned int chunk) const {
+			return (stripe + chunk) % members();
+		}
+
+		/**
+		 *	Compute the parity chunks from the data chunks, len bytes each
+		 */
+		void encode(const uint8_t * const * data_chunks, uint8_t * const * parity_chunks,
+				size_t len) const;
+
+		/**
+		 *	Given the K chunks that were read (sorted), fill in the K x K matrix that turns them
+		 *	back into the data chunks. Returns false if they can't be decoded (which a Cauchy
+		 *	code never does)
+		 */
+		bool decode_matrix(const std::vector<unsigned int>& chunks, std::vector<uint8_t>& out) const;
+	};
+
+	/**
+	 *	Per-thread erasure coding results. Cycles are TSC cycles spent in the parity math
+	 */
+	struct ErasureResults {
+		uint64_t encodes			= 0;
+		uint64_t encode_bytes		= 0;	// data bytes encoded
+		uint64_t encode_cycles		= 0;
+
+		uint64_t reads				= 0;
+		uint64_t decodes			= 0;	// reads that had to rebuild data
+		uint64_t decode_bytes		= 0;	// data bytes of the stripes that were rebuilt
+		uint64_t decode_cycles		= 0;
+		uint64_t rebuilt_chunks		= 0;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_ERASURE_H
@@ -0,0 +1,294 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <assert.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DISKSPD_GF256_X86 1
+#endif
+
+#include "gf256.h"
+
+namespace diskspd {
+
+	/**
+	 *	Lookup tables, built the first time they're needed
+	 */
+	struct Gf256Tables {
+		uint8_t exp[512];		// doubled, so exp[log a + log b] needs no modulo
+		uint8_t log[256];
+		uint8_t mul[256][256];
+
+		// for each coefficient c, c*x for x = 0..15 then c*(x << 4) for x = 0..15; the SIMD
+		// kernels multiply a byte by looking up each of its nibbles with a byte shuffle
+		uint8_t nibble[256][32];
+
+		Gf256Tables() {
+			unsigned int x = 1;
+			for (unsigned int i = 0; i < 255; ++i) {
+				exp[i] = exp[i + 255] = x;
+				log[x] = i;
+				x <<= 1;
+				if (x & 0x100) x ^= 0x11d;
+			}
+			exp[510] = exp[511] = 0;
+			log[0] = 0;
+
+			for (unsigned int a = 0; a < 256; ++a) {
+				for (unsigned int b = 0; b < 256; ++b) {
+					mul[a][b] = a && b ? exp[log[a] + log[b]] : 0;
+				}
+				for (unsigned int n = 0; n < 16; ++n) {
+					nibble[a][n] = mul[a][n];
+					nibble[a][16 + n] = mul[a][n << 4];
+				}
+			}
+		}
+	};
+
+	static const Gf256Tables& tables() {
+		static const Gf256Tables t;
+		return t;
+	}
+
+	uint8_t Gf256::mul(uint8_t a, uint8_t b) {
+		return tables().mul[a][b];
+	}
+
+	uint8_t Gf256::inv(uint8_t a) {
+		assert(a);
+		const Gf256Tables& t = tables();
+		return t.exp[255 - t.log[a]];
+	}
+
+	/**
+	 *	The scalar kernels do bytes [start, len), so the SIMD kernels can hand them their tail
+	 */
+	static void dot_scalar(const uint8_t * coefs, const uint8_t * const * srcs, size_t n,
+			uint8_t * dst, size_t start, size_t len) {
+
+		const Gf256Tables& t = tables();
+		for (size_t j = 0; j < n; ++j) {
+			const uint8_t * row = t.mul[coefs[j]];
+			const uint8_t * src = srcs[j];
+			if (!j) {
+				for (size_t i = start; i < len; ++i) dst[i] = row[src[i]];
+			} else {
+				for (size_t i = start; i < len; ++i) dst[i] ^= row[src[i]];
+			}
+		}
+	}
+
+	static void xor_scalar(const uint8_t * const * srcs, size_t n, uint8_t * dst,
+			size_t start, size_t len) {
+
+		// a word at a time, then the last few bytes
+		size_t i = start;
+		for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+			uint64_t acc = 0;
+			for (size_t j = 0; j < n; ++j) {
+				uint64_t w;
+				memcpy(&w, srcs[j] + i, sizeof(w));
+				acc ^= w;
+			}
+			memcpy(dst + i, &acc, sizeof(acc));
+		}
+		for (; i < len; ++i) {
+			uint8_t acc = 0;
+			for (size_t j = 0; j < n; ++j) acc ^= srcs[j][i];
+			dst[i] = acc;
+		}
+	}
+
+#ifdef DISKSPD_GF256_X86
+
+	/**
+	 *	The SIMD kernels are compiled for their instruction set whatever the build's target is,
+	 *	and only called if the CPU supports it. They return how many bytes they did
+	 */
+	__attribute__((target("avx2")))
+	static size_t dot_avx2(const uint8_t * coefs, const uint8_t * const * srcs, size_t n,
+			uint8_t * dst, size_t len) {
+
+		const Gf256Tables& t = tables();
+		const __m256i mask = _mm256_set1_epi8(0x0f);
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			__m256i acc = _mm256_setzero_si256();
+			for (size_t j = 0; j < n; ++j) {
+				const uint8_t * table = t.nibble[coefs[j]];
+				__m256i lo_table = _mm256_broadcastsi128_si256(
+						_mm_loadu_si128(reinterpret_cast<const __m128i *>(table)));
+				__m256i hi_table = _mm256_broadcastsi128_si256(
+						_mm_loadu_si128(reinterpret_cast<const __m128i *>(table + 16)));
+
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(srcs[j] + i));
+				__m256i lo = _mm256_and_si256(v, mask);
+				__m256i hi = _mm256_and_si256(_mm256_srli_epi64(v, 4), mask);
+				acc = _mm256_xor_si256(acc, _mm256_xor_si256(
+						_mm256_shuffle_epi8(lo_table, lo), _mm256_shuffle_epi8(hi_table, hi)));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), acc);
+		}
+		return i;
+	}
+
+	__attribute__((target("avx2")))
+	static size_t xor_avx2(const uint8_t * const * srcs, size_t n, uint8_t * dst, size_t len) {
+
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			__m256i acc = _mm256_setzero_si256();
+			for (size_t j = 0; j < n; ++j) {
+				acc = _mm256_xor_si256(acc,
+						_mm256_loadu_si256(reinterpret_cast<const __m256i *>(srcs[j] + i)));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), acc);
+		}
+		return i;
+	}
+
+	__attribute__((target("avx512f,avx512bw")))
+	static size_t dot_avx512(const uint8_t * coefs, const uint8_t * const * srcs, size_t n,
+			uint8_t * dst, size_t len) {
+
+		const Gf256Tables& t = tables();
+		const __m512i mask = _mm512_set1_epi8(0x0f);
+		size_t i = 0;
+		for (; i + 64 <= len; i += 64) {
+			__m512i acc = _mm512_setzero_si512();
+			for (size_t j = 0; j < n; ++j) {
+				const uint8_t * table = t.nibble[coefs[j]];
+				__m512i lo_table = _mm512_broadcast_i32x4(
+						_mm_loadu_si128(reinterpret_cast<const __m128i *>(table)));
+				__m512i hi_table = _mm512_broadcast_i32x4(
+						_mm_loadu_si128(reinterpret_cast<const __m128i *>(table + 16)));
+
+				__m512i v = _mm512_loadu_si512(srcs[j] + i);
+				__m512i lo = _mm512_and_si512(v, mask);
+				__m512i hi = _mm512_and_si512(_mm512_srli_epi64(v, 4), mask);
+				acc = _mm512_xor_si512(acc, _mm512_xor_si512(
+						_mm512_shuffle_epi8(lo_table, lo), _mm512_shuffle_epi8(hi_table, hi)));
+			}
+			_mm512_storeu_si512(dst + i, acc);
+		}
+		return i;
+	}
+
+	__attribute__((target("avx512f")))
+	static size_t xor_avx512(const uint8_t * const * srcs, size_t n, uint8_t * dst, size_t len) {
+
+		size_t i = 0;
+		for (; i + 64 <= len; i += 64) {
+			__m512i acc = _mm512_setzero_si512();
+			for (size_t j = 0; j < n; ++j) {
+				acc = _mm512_xor_si512(acc, _mm512_loadu_si512(srcs[j] + i));
+			}
+			_mm512_storeu_si512(dst + i, acc);
+		}
+		return i;
+	}
+
+#endif // DISKSPD_GF256_X86
+
+	bool Gf256::supported(Simd simd) {
+		switch (simd) {
+			case Simd::SCALAR:
+				return true;
+#ifdef DISKSPD_GF256_X86
+			case Simd::AVX2:
+				return __builtin_cpu_supports("avx2");
+			case Simd::AVX512:
+				return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+			default:
+				return false;
+		}
+	}
+
+	Gf256::Simd Gf256::best_simd() {
+		if (supported(Simd::AVX512)) return Simd::AVX512;
+		if (supported(Simd::AVX2)) return Simd::AVX2;
+		return Simd::SCALAR;
+	}
+
+	const char * Gf256::simd_name(Simd simd) {
+		switch (simd) {
+			case Simd::AVX2:	return "avx2";
+			case Simd::AVX512:	return "avx512";
+			default:			return "scalar";
+		}
+	}
+
+	void Gf256::dot(Simd simd, const uint8_t * coefs, const uint8_t * const * srcs, size_t n,
+			uint8_t * dst, size_t len) {
+
+		bool all_ones = true;
+		for (size_t j = 0; j < n; ++j) {
+			all_ones &= coefs[j] == 1;
+		}
+
+		size_t done = 0;
+#ifdef DISKSPD_GF256_X86
+		if (simd == Simd::AVX512) {
+			done = all_ones ? xor_avx512(srcs, n, dst, len) : dot_avx512(coefs, srcs, n, dst, len);
+		} else if (simd == Simd::AVX2) {
+			done = all_ones ? xor_avx2(srcs, n, dst, len) : dot_avx2(coefs, srcs, n, dst, len);
+		}
+#endif
+		if (all_ones) {
+			xor_scalar(srcs, n, dst, done, len);
+		} else {
+			dot_scalar(coefs, srcs, n, dst, done, len);
+		}
+	}
+
+	bool Gf256::invert(std::vector<uint8_t>& matrix, size_t n) {
+
+		assert(matrix.size() == n*n);
+
+		// Gauss-Jordan elimination, applying the same row operations to the identity
+		std::vector<uint8_t> result(n*n, 0);
+		for (size_t i = 0; i < n; ++i) {
+			result[i*n + i] = 1;
+		}
+
+		for (size_t col = 0; col < n; ++col) {
+
+			size_t pivot = col;
+			while (pivot < n && !matrix[pivot*n + col]) ++pivot;
+			if (pivot == n) {
+				return false;
+			}
+			if (pivot != col) {
+				for (size_t k = 0; k < n; ++k) {
+					std::swap(matrix[pivot*n + k], matrix[col*n + k]);
+					std::swap(result[pivot*n + k], result[col*n + k]);
+				}
+			}
+
+			uint8_t scale = inv(matrix[col*n + col]);
+			for (size_t k = 0; k < n; ++k) {
+				matrix[col*n + k] = mul(matrix[col*n + k], scale);
+				result[col*n + k] = mul(result[col*n + k], scale);
+			}
+
+			for (size_t row = 0; row < n; ++row) {
+				uint8_t factor = matrix[row*n + col];
+				if (row == col || !factor) continue;
+				for (size_t k = 0; k < n; ++k) {
+					matrix[row*n + k] ^= mul(factor, matrix[col*n + k]);
+					result[row*n + k] ^= mul(factor, result[col*n + k]);
+				}
+			}
+		}
+
+		matrix.swap(result);
+		return true;
+	}
+
+} // namespace diskspd
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#ifndef DISKSPD_GF256_H
+#define DISKSPD_GF256_H
+
+namespace diskspd {
+
+	/**
+	 *	Static class for arithmetic in GF(2^8) (polynomial 0x11d), as used by Reed-Solomon codes.
+	 *	The bulk operation is a dot product of blocks with a vector of coefficients, which has a
+	 *	scalar kernel and, on x86, AVX2 and AVX-512 kernels chosen at runtime
+	 */
+	class Gf256 {
+
+		public:
+
+			enum class Simd {
+				SCALAR,
+				AVX2,
+				AVX512
+			};
+
+			static uint8_t mul(uint8_t a, uint8_t b);
+
+			/**
+			 *	Multiplicative inverse; a must not be 0
+			 */
+			static uint8_t inv(uint8_t a);
+
+			/**
+			 *	The fastest kernel this CPU supports
+			 */
+			static Simd best_simd();
+
+			/**
+			 *	Whether this CPU supports simd's kernel
+			 */
+			static bool supported(Simd simd);
+
+			static const char * simd_name(Simd simd);
+
+			/**
+			 *	dst = coefs[0]*srcs[0] + ... + coefs[n-1]*srcs[n-1], over len bytes. If every
+			 *	coefficient is 1 this is a plain XOR
+			 */
+			static void dot(Simd simd, const uint8_t * coefs, const uint8_t * const * srcs, size_t n,
+					uint8_t * dst, size_t len);
+
+			/**
+			 *	Invert the n x n row-major matrix in place. Returns false if it's singular
+			 */
+			static bool invert(std::vector<uint8_t>& matrix, size_t n);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_GF256_H
@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "idle.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	/**
+	 *	Parse a time in milliseconds, or seconds with an s suffix
+	 */
+	static bool time_ms_from_arg(const std::string& arg, uint64_t& ms) {
+		std::string number = arg;
+		uint64_t multiplier = 1;
+		if (number.size() > 2 && number.compare(number.size() - 2, 2, "ms") == 0) {
+			number.resize(number.size() - 2);
+		} else if (number.size() > 1 && number.back() == 's') {
+			number.resize(number.size() - 1);
+			multiplier = 1000;
+		}
+		if (number.empty() || !Options::is_numeric(number.c_str())) {
+			return false;
+		}
+		ms = strtoull(number.c_str(), nullptr, 10)*multiplier;
+		return true;
+	}
+
+	bool IdleGaps::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t end = settings.find(',');
+		if (end == std::string::npos) end = settings.size();
+
+		if (!time_ms_from_arg(settings.substr(0, end), gap_ms) || !gap_ms) {
+			fprintf(stderr, "Invalid --idle gap\n");
+			return false;
+		}
+
+		size_t pos = end + 1;
+		while (pos < settings.size()) {
+			end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --idle setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			bool valid = false;
+			if (key == "every") {
+				valid = time_ms_from_arg(value, every_ms) && every_ms;
+			} else if (key == "probes") {
+				valid = Options::is_numeric(value.c_str()) && atoi(value.c_str()) > 0;
+				probes = atoi(value.c_str());
+			}
+			if (!valid) {
+				fprintf(stderr, "Invalid --idle setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool IdleGaps::due(uint64_t now_us) {
+		uint64_t next = next_gap_us.load();
+		if (!next) {
+			// the first op to complete starts the clock
+			next_gap_us.compare_exchange_strong(next, now_us + every_ms*1000);
+			return false;
+		}
+		return now_us >= next;
+	}
+
+	bool ThreadParams::idle_gap(std::vector<std::shared_ptr<IAsyncIop>>& parked) {
+
+		IdleGaps& idle = *job_options->idle;
+		std::unique_lock<std::mutex> lock(idle.mutex);
+
+		uint64_t gap = idle.gaps;
+		if (++idle.drained < job_options->total_threads) {
+
+			// another thread still has ops outstanding, or is probing; the Job doesn't wake
+			// this cv when it ends, so check in on it now and then
+			while (idle.gaps == gap) {
+				if (!*run_threads) return false;
+				idle.resumed.wait_for(lock, std::chrono::milliseconds(10));
+			}
+
+		} else {
+
+			// this thread drained last, so nothing is outstanding anywhere
+			lock.unlock();
+
+			uint64_t end_us = PerfClock::get_time_us() + idle.gap_ms*1000;
+			for (uint64_t now_us; (now_us = PerfClock::get_time_us()) < end_us; ) {
+				if (!*run_threads) return false;
+				usleep(std::min(end_us - now_us, (uint64_t)10000));
+			}
+
+			IdleResults& idle_results = *results->idle_results;
+			if (*record_results) {
+				++idle_results.gaps;
+			}
+
+			// the probes go one at a time, so only the first sees a device that was idle
+			std::shared_ptr<IAsyncIop> op = parked[0];
+			std::shared_ptr<TargetData> t_data = op->get_target_data();
+			for (unsigned int i = 0; i < idle.probes; ++i) {
+
+				op->set_time(PerfClock::get_time_us());
+				if (io_manager->enqueue(op)) {
+					perror("aio enqueue failed");
+					thread_abort();
+					return false;
+				}
+				if (io_manager->submit(thread_id)) {
+					perror("aio submit failed");
+					thread_abort();
+					return false;
+				}
+				io_manager->wait(thread_id);
+				if (!check_completion(op)) {
+					return false;
+				}
+
+				uint64_t abs_time_us = PerfClock::get_time_us();
+				if (*record_results) {
+					(i ? idle_results.later_latency_histogram : idle_results.first_latency_histogram)
+						.Add(abs_time_us - op->get_time());
+				}
+
+				op->set_offset(t_data->get_next_offset(op->get_offset()));
+				if (rw_rng_engine->get_percentage() <= t_data->target->write_percentage) {
+					op->set_type(IAsyncIop::Type::WRITE);
+				} else {
+					op->set_type(IAsyncIop::Type::READ);
+				}
+			}
+
+			lock.lock();
+			idle.drained = 0;
+			idle.next_gap_us = PerfClock::get_time_us() + idle.every_ms*1000;
+			++idle.gaps;
+			idle.resumed.notify_all();
+		}
+		lock.unlock();
+
+		// back to the standard workload
+		uint64_t now_us = PerfClock::get_time_us();
+		for (auto& op : parked) {
+			op->set_time(now_us);
+			if (io_manager->enqueue(op)) {
+				perror("aio enqueue failed");
+				thread_abort();
+				return false;
+			}
+		}
+		if (io_manager->submit(thread_id)) {
+			perror("aio submit failed");
+			thread_abort();
+			return false;
+		}
+		parked.clear();
+		return true;
+	}
+
+} // namespace diskspd
@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_IDLE_H
+#define DISKSPD_IDLE_H
+
+namespace diskspd {
+
+	/**
+	 *	Idle gaps injected into the standard workload (--idle). After every 'every_ms' of I/O,
+	 *	threads stop restarting their ops until none are outstanding in the whole Job. The last
+	 *	thread to drain then leaves the device idle for gap_ms, and issues 'probes' ops one at
+	 *	a time before every thread picks up where it left off
+	 */
+	struct IdleGaps {
+		uint64_t gap_ms				= 0;
+		uint64_t every_ms			= 1000;		// every=
+		unsigned int probes			= 1;		// probes=
+
+		std::mutex mutex;
+		std::condition_variable resumed;
+
+		// when the next gap is due; 0 until the first op completes
+		std::atomic<uint64_t> next_gap_us{0};
+
+		// protected by mutex
+		unsigned int drained		= 0;		// threads with all of their ops held back
+		uint64_t gaps				= 0;		// gaps so far
+
+		/**
+		 *	Parse an --idle argument: GAP, then optional comma separated key=value settings,
+		 *	named as above. Times are in milliseconds, or seconds with an s suffix
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	Is a gap due at now_us?
+		 */
+		bool due(uint64_t now_us);
+	};
+
+	/**
+	 *	Per-thread idle gap results; only the thread that probes after a gap has any. Latencies
+	 *	are in microseconds
+	 */
+	struct IdleResults {
+		uint64_t gaps				= 0;
+		Histogram<uint64_t> first_latency_histogram;	// first probe after each gap
+		Histogram<uint64_t> later_latency_histogram;	// the rest of the probes
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_IDLE_H
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <vector>
+#include <algorithm>
 #include <cstdio>
 #include <chrono>
 #include <assert.h>
@@ -42,6 +43,22 @@ namespace diskspd {
 		return NULL;
 	}
 
+	/**
+	 *	The average usage of all cpus between two get_cpu_stats() calls, from 0 to 1
+	 */
+	static double average_cpu_usage(const std::map<unsigned int, std::vector<double>>& init,
+			const std::map<unsigned int, std::vector<double>>& end) {
+		double usage = 0;
+		for (auto& c : init) {
+			const std::vector<double>& i = c.second;
+			const std::vector<double>& e = end.at(c.first);
+			double total_time = (e[0]+e[1]+e[2]+e[3]+e[4]) - (i[0]+i[1]+i[2]+i[3]+i[4]);
+			double nonidle = (e[0]+e[1]+e[2]) - (i[0]+i[1]+i[2]);
+			usage += total_time ? nonidle/total_time : 0;
+		}
+		return init.size() ? usage/init.size() : 0;
+	}
+
 	/**
 	 *	Run this job with the options supplied in the constructor
 	 */
@@ -165,16 +182,58 @@ namespace diskspd {
 			}
 			close(fd);	
 		}
+
+		// --age; fragment the layouts that were just laid out
+		if (options->age) {
+			for (auto& target : options->targets) {
+				if (!options->age->age(*target, target->zero_buffers ? zero_buf : fill_buf,
+							fill_buf_size, options->rand_seed)) {
+					free(fill_buf);
+					free(zero_buf);
+					return false;
+				}
+			}
+		}
+
 		free(fill_buf);
 		free(zero_buf);
+
+		// --precondition; the targets are written all over until they're steady
+		if (options->precondition) {
+			v_printf("Preconditioning targets\n");
+			for (auto& target : options->targets) {
+				if (!options->precondition->precondition(*target, options->rand_seed)) {
+					return false;
+				}
+			}
+		}
+
+		// an LSM tree starts out with its base data set
+		if (options->lsm && !options->lsm->populate(*options->targets[0])) {
+			return false;
+		}
 	
-		// get device name and scheduler for each target
+		// get device name for each target
+		std::vector<std::string> devices;
 		for (auto& target : options->targets) {
 			struct stat buf = {0};
 			int err = stat(target->path.c_str(), &buf);
 
 			// use appropriate device id (st_dev != st_rdev if target is a device)
 			target->device = options->sys_info->device_from_id(buf.st_rdev ? buf.st_rdev : buf.st_dev);
+			if (std::find(devices.begin(), devices.end(), target->device) == devices.end()) {
+				devices.push_back(target->device);
+			}
+		}
+
+		// --sweep; this point's block queue settings
+		if (options->sweep && !options->sweep->tune_queues(options->sweep_point, devices,
+					*options->sys_info)) {
+			return false;
+		}
+
+		// and the scheduler it's using now
+		for (auto& target : options->targets) {
 			target->scheduler = options->sys_info->scheduler_from_device(target->device);
 		}
 
@@ -200,6 +259,44 @@ namespace diskspd {
 			th->results = th_results;
 			results->thread_results.push_back(th_results);
 
+			// --stripe, --mirror and --erasure; the set of targets gets results of its own
+			if (options->stripe || options->mirror || options->erasure) {
+				th_results->logical_results = std::make_shared<TargetResults>();
+				th_results->logical_results->target =
+					options->stripe ? options->stripe->logical :
+					options->mirror ? options->mirror->logical : options->erasure->logical;
+			}
+			if (options->mirror) {
+				th_results->mirror_results = std::make_shared<MirrorResults>();
+			}
+			if (options->erasure) {
+				th_results->erasure_results = std::make_shared<ErasureResults>();
+			}
+			if (options->cache) {
+				th_results->cache_results = std::make_shared<CacheResults>();
+			}
+			if (options->idle) {
+				th_results->idle_results = std::make_shared<IdleResults>();
+			}
+			if (options->qd_target) {
+				th_results->qd_results = std::make_shared<QdResults>();
+			}
+			if (options->ramp) {
+				th_results->ramp_results = std::make_shared<RampResults>();
+				th_results->ramp_results->steps.resize(options->ramp->steps(options->total_threads));
+			}
+			if (options->work) {
+				th_results->work_results = std::make_shared<WorkResults>();
+			}
+			if (options->scan) {
+				th_results->scan_results = std::make_shared<ScanResults>();
+			}
+			if (options->steady) {
+				th_results->warmup_results = std::make_shared<WarmupResults>();
+				th_results->warmup_results->windows.resize(
+						(options->warmup_time*1000 + options->steady->window_ms - 1)/options->steady->window_ms);
+			}
+
 			// tell it what Job it's serving
 			th->job = this;
 
@@ -285,6 +382,21 @@ namespace diskspd {
 		std::map<unsigned int, std::vector <double> > cpu_stats_init;
 		std::map<unsigned int, std::vector <double> > cpu_stats_end;
 
+		// --work; a target's work is shared by its threads
+		if (options->work && options->work->per_target) {
+			options->work->targets.clear();
+			for (auto& target : options->targets) {
+				auto progress = std::unique_ptr<FixedWork::Progress>(new FixedWork::Progress());
+				progress->quota = options->work->quota(*target);
+				options->work->targets[target.get()] = std::move(progress);
+			}
+		}
+
+		// --scan; every thread gets an even share of the chunks to start with
+		if (options->scan) {
+			options->scan->split(options->targets, options->total_threads);
+		}
+
 		// start io_manager
 		if (!options->io_manager->start(total_overlap)) {
 			fprintf(stderr, "io engine failed to start\n");
@@ -295,6 +407,12 @@ namespace diskspd {
 		 *	Start threads
 		 *****************/
 
+		// --ramp; the warm up is the first step
+		if (options->ramp) {
+			options->ramp->current = 0;
+			options->ramp->active = options->ramp->threads(0, options->total_threads);
+		}
+
 		v_printf("Starting %u threads... ", options->total_threads);
 		fflush(stdout);
 
@@ -307,12 +425,28 @@ namespace diskspd {
 
 		auto cpuit = options->sys_info->affinity_cpus.begin();
 
-		for (auto& t : thread_params) {
-			int err = pthread_create(&t->thread_handle, NULL, _thread_func, static_cast<void *>(t.get()));
-			if (err) {
-				perror("Couldn't create pthread");
+		// --processes; the threads run in worker processes, which share a control block with
+		// the Job instead of its memory
+		if (options->processes) {
+			workers = std::make_shared<ProcessWorkers>(*this, &run_threads, &thread_error);
+			if (!workers->create()) {
 				return false;
 			}
+		}
+
+		for (auto& t : thread_params) {
+			if (workers) {
+				// a worker pins itself before it starts
+				if (!workers->start(t, options->disable_affinity ? -1 : (int)*cpuit)) {
+					return false;
+				}
+			} else {
+				int err = pthread_create(&t->thread_handle, NULL, _thread_func, static_cast<void *>(t.get()));
+				if (err) {
+					perror("Couldn't create pthread");
+					return false;
+				}
+			}
 			// cpu affinity
 			if (!options->disable_affinity) {
 
@@ -321,7 +455,8 @@ namespace diskspd {
 				CPU_SET_S(*cpuit, cpu_set_size, cpu_set);
 
 				// actually set the affinity
-				err = pthread_setaffinity_np(t->thread_handle, cpu_set_size, (const cpu_set_t*)cpu_set);
+				int err = workers ? 0 :
+					pthread_setaffinity_np(t->thread_handle, cpu_set_size, (const cpu_set_t*)cpu_set);
 
 				if (err) {
 					perror("Couldn't affinitize pthread");
@@ -337,6 +472,10 @@ namespace diskspd {
 		}
 		CPU_FREE(cpu_set);
 
+		if (workers) {
+			workers->listen();
+		}
+
 		// sleep on thread initialization, with a timeout in case of errors
 		std::cv_status timeout_status;			// for getting result of wait_for
 		std::chrono::milliseconds init_timeout(1);	 // the timeout for checking errors
@@ -372,7 +511,43 @@ namespace diskspd {
 		 *	Warmup
 		 *************/
 
-		if(options->warmup_time) {
+		if (options->steady) {
+			// --steady; warm up a window at a time until steady, or -W is up
+			SteadyState& steady = *options->steady;
+			results->steady_results = std::make_shared<SteadyResults>();
+			SteadyResults& steady_results = *results->steady_results;
+			v_printf("Warming up until steady, for at most %u second%s\n", options->warmup_time, options->warmup_time > 1 ? "s" : "");
+
+			unsigned int windows = thread_params[0]->results->warmup_results->windows.size();
+			uint64_t warmup_start_ns = PerfClock::get_time_ns();
+			std::unique_lock<std::mutex> thread_warmup_lock(thread_mutex);
+			timeout_status = std::cv_status::timeout;
+			for (unsigned int w = 0; w < windows && !steady_results.reached; ++w) {
+				steady.current = w;
+				timeout_status = thread_error_cv.wait_for(thread_warmup_lock,
+						std::chrono::milliseconds(steady.window_ms));
+				if (timeout_status == std::cv_status::no_timeout || thread_error) {
+					break;
+				}
+				// the window before this one is over for every thread by now
+				if (w) {
+					steady_results.reached = steady.add_window(w - 1, results->thread_results,
+							options->measure_latency, steady_results);
+				}
+			}
+			steady.current = windows;
+			thread_warmup_lock.unlock();
+			steady_results.warmup_ms = (PerfClock::get_time_ns() - warmup_start_ns)/1000000;
+
+			if (timeout_status == std::cv_status::no_timeout || thread_error) {
+				fprintf(stderr, "Error during warmup phase!\n");
+				return false;
+			}
+
+			v_printf("%s after %lums; main test will run for %u second%s\n",
+					steady_results.reached ? "Reached steady state" : "Not steady",
+					steady_results.warmup_ms, options->duration, options->duration > 1 ? "s" : "");
+		} else if(options->warmup_time) {
 			v_printf("Warming up for %u second%s\n", options->warmup_time, options->warmup_time > 1 ? "s" : "");
 
 			std::chrono::seconds warmupdur(options->warmup_time);
@@ -411,10 +586,43 @@ namespace diskspd {
 
 		// start recording data
 		record_results = true;
-		// sleep
-		timeout_status = thread_error_cv.wait_for(thread_duration_lock, maindur);
+		if (workers) {
+			workers->start_recording(options->start_time_us);
+		}
+		if (options->ramp) {
+			// --ramp; a step per thread count, each with its own cpu usage
+			RampSchedule& ramp = *options->ramp;
+			timeout_status = std::cv_status::timeout;
+			for (unsigned int step = 0; step < ramp.steps(options->total_threads) &&
+					timeout_status == std::cv_status::timeout; ++step) {
+
+				unsigned int threads = ramp.threads(step, options->total_threads);
+				v_printf("Ramp step %u: %u thread%s\n", step + 1, threads, threads > 1 ? "s" : "");
+				ramp.current = step;
+				ramp.active = threads;
+
+				auto step_cpu_init = options->sys_info->get_cpu_stats();
+				timeout_status = thread_error_cv.wait_for(thread_duration_lock,
+						std::chrono::seconds(ramp.step_s));
+				results->ramp_cpu_usage.push_back(
+						average_cpu_usage(step_cpu_init, options->sys_info->get_cpu_stats()));
+			}
+		} else if (options->work || options->scan) {
+			// --work and --scan; sleep until every thread is done, or the duration is over
+			unsigned int total_threads = options->total_threads;
+			results->work_done = thread_error_cv.wait_for(thread_duration_lock, maindur, [&]() {
+				return thread_error || threads_done == total_threads;
+			}) && !thread_error;
+			timeout_status = thread_error ? std::cv_status::no_timeout : std::cv_status::timeout;
+		} else {
+			// sleep
+			timeout_status = thread_error_cv.wait_for(thread_duration_lock, maindur);
+		}
 		// stop recording data
 		record_results = false;
+		if (workers) {
+			workers->stop_recording();
+		}
 
 		thread_duration_lock.unlock();
 
@@ -438,8 +646,47 @@ namespace diskspd {
 		run_threads = false;
 
 		// block on threads finishing
-		for (auto& t : thread_params) {
-			pthread_join(t->thread_handle, NULL);
+		if (workers) {
+			// and bring the workers' results back
+			if (!workers->finish()) {
+				return false;
+			}
+		} else {
+			for (auto& t : thread_params) {
+				pthread_join(t->thread_handle, NULL);
+			}
+		}
+
+		// a thread can still fail as it's stopped, after the check above
+		if (thread_error) {
+			fprintf(stderr, "Error during main test!\n");
+			return false;
+		}
+
+		// --work and --scan; the time it took is up to when the last share of it was done
+		if (options->work || options->scan) {
+			results->work_time_us = (uint64_t)options->duration*1000000;
+			if (results->work_done) {
+				uint64_t finished_us = options->start_time_us;
+				if (options->scan) {
+					for (auto& thread_result : results->thread_results) {
+						finished_us = std::max(finished_us, thread_result->scan_results->finished_us);
+					}
+				} else if (options->work->per_target) {
+					for (auto& progress : options->work->targets) {
+						finished_us = std::max(finished_us, progress.second->finished_us.load());
+					}
+				} else {
+					for (auto& thread_result : results->thread_results) {
+						finished_us = std::max(finished_us, thread_result->work_results->finished_us);
+					}
+				}
+				results->work_time_us = finished_us - options->start_time_us;
+			}
+		}
+
+		if (options->lsm) {
+			options->lsm->remove_tables();
 		}
 
 		// convert processor times to processor usage percentages
@@ -17,6 +17,26 @@
 #include "target.h"
 #include "async_io.h"
 #include "sys_info.h"
+#include "replay.h"
+#include "chain.h"
+#include "lsm.h"
+#include "wal.h"
+#include "stripe.h"
+#include "mirror.h"
+#include "erasure.h"
+#include "cache.h"
+#include "idle.h"
+#include "age.h"
+#include "precondition.h"
+#include "weights.h"
+#include "throttle.h"
+#include "qd.h"
+#include "sweep.h"
+#include "ramp.h"
+#include "steady.h"
+#include "work.h"
+#include "scan.h"
+#include "process.h"
 
 #ifndef DISKSPD_JOB_H
 #define DISKSPD_JOB_H
@@ -37,6 +57,16 @@ namespace diskspd {
 		uint64_t total_time_ms; // ms or shorter? us?
 
 		std::vector<std::shared_ptr<ThreadResults>> thread_results;
+
+		// --ramp; the average cpu usage in each step
+		std::vector<double> ramp_cpu_usage;
+
+		// --steady; the warm up windows
+		std::shared_ptr<SteadyResults> steady_results;
+
+		// --work and --scan; how long it took, if all of it was done
+		bool work_done				= false;
+		uint64_t work_time_us		= 0;
 	};
 
 	/**
@@ -72,6 +102,71 @@ namespace diskspd {
 		uint64_t start_time_ms			= 0;
 
 		std::vector<std::shared_ptr<Target>> targets;
+
+		// --replay; if set, threads replay this trace instead of generating I/O
+		std::shared_ptr<Trace> replay_trace;
+
+		// --chain; if set, each slot issues these steps in order instead of independent ops
+		std::vector<ChainStep> chain;
+
+		// --lsm; if set, the single target is a directory holding an emulated LSM tree
+		std::shared_ptr<LsmTree> lsm;
+
+		// --wal; if set, threads commit records to the single target with group commit
+		std::shared_ptr<WalLog> wal;
+
+		// --stripe; if set, the targets are the members of this stripe set
+		std::shared_ptr<StripeSet> stripe;
+
+		// --mirror; if set, the targets are the replicas of this mirror
+		std::shared_ptr<MirrorSet> mirror;
+
+		// --erasure; if set, the targets are the data and parity members of this set
+		std::shared_ptr<ErasureSet> erasure;
+
+		// --cache; if set, reads go through this emulated buffer cache
+		std::shared_ptr<BufferCache> cache;
+
+		// --idle; if set, the standard workload stops now and then to leave the device idle
+		std::shared_ptr<IdleGaps> idle;
+
+		// --age; if set, the targets are aged after they're laid out
+		std::shared_ptr<FsAging> age;
+
+		// --work; if set, the Job ends once this work is done, or after duration if it isn't
+		std::shared_ptr<FixedWork> work;
+
+		// --scan; if set, the threads scan every target, and the Job ends once they're done
+		std::shared_ptr<TargetScan> scan;
+
+		// --processes; each thread runs in a worker process of its own
+		bool processes				= false;
+
+		// --precondition; if set, the targets are preconditioned before the Job starts
+		std::shared_ptr<Precondition> precondition;
+
+		// --weights; if set, each thread's -o slots go to the targets in proportion to these
+		std::shared_ptr<TargetWeights> weights;
+
+		// --rate; if set, ops wait for tokens from these buckets
+		std::shared_ptr<RateLimits> rate;
+
+		// --qd-target; if set, each thread adjusts its queue depth to hold this latency
+		std::shared_ptr<QdTarget> qd_target;
+
+		// --ramp; if set, threads start doing I/O on this schedule
+		std::shared_ptr<RampSchedule> ramp;
+
+		// --steady; if set, the warm up ends once the Job reaches steady state
+		std::shared_ptr<SteadyState> steady;
+
+		// --sweep; if set, this Job is a point of this sweep, and sets its queue settings
+		std::shared_ptr<ParamSweep> sweep;
+		size_t sweep_point = 0;
+
+		// --group; the options and targets given for each workload group. A Target's group
+		// is an index into this plus one, as group 0 is the command line's own targets
+		std::vector<std::string> groups;
 	};
 
 	/**
@@ -83,7 +178,8 @@ namespace diskspd {
 				options(options),
 				run_threads(true),
 				record_results(false),
-				thread_error(false){}
+				thread_error(false),
+				threads_done(0){}
 
 			/**
 			 *	Run this job with the options supplied in the constructor
@@ -102,6 +198,10 @@ namespace diskspd {
 			// used by any thread to indicate a thread failure. Used with thread_mutex
 			std::condition_variable thread_error_cv;
 
+			// --work and --scan; threads that are done, used with thread_mutex and
+			// thread_error_cv
+			unsigned int threads_done;
+
 		private:
 			// store the user-defined options for this Job
 			std::shared_ptr<JobOptions> options;
@@ -114,6 +214,9 @@ namespace diskspd {
 			volatile bool record_results;
 			// used to denote an error in a worker thread
 			volatile bool thread_error;
+
+			// --processes; the worker processes the threads run in
+			std::shared_ptr<ProcessWorkers> workers;
 	};
 
 } // namespace diskspd
@@ -14,6 +14,8 @@
 #include <libaio.h>
 #include <assert.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
 
 #include "debug.h"
 #include "target.h"
@@ -53,6 +55,7 @@ namespace diskspd {
 				this->group_id = group_id;
 				this->read_buf = read_buf;
 				this->write_buf = write_buf;
+				time = time_stamp;
 
 				// set up iocb struct
 				if (t == READ) {
@@ -255,40 +258,59 @@ namespace diskspd {
 				return 0;
 			}
 
-			std::shared_ptr<IAsyncIop> wait(int group_id) {
+			std::shared_ptr<IAsyncIop> wait(int group_id, const timespec * timeout) {
 				if (!started) assert(!"IOManager not started!");
 
 				groups_mutex.lock();
 				auto group = groups[group_id];
 				groups_mutex.unlock();
 
+				// ops cancel() took back from the kernel come first
+				if (group->cancelled.size()) {
+					auto op = group->cancelled.front();
+					group->cancelled.pop();
+					return op;
+				}
+
 				// wait on a single event
 				io_event event = {0};
-				int err = io_getevents(group->ctx, 1, 1, &event, NULL);
+				int err = io_getevents(group->ctx, 1, 1, &event, const_cast<timespec *>(timeout));
+				if (!err && timeout) {
+					return nullptr;
+				}
 				if (err != 1) {
 					perror("IOManager failed: io_getevents returned unexpected result");
 					exit(1);
 				}
 
-				// get the op
-				void * in_flight_id = event.data;
-				auto op = group->in_flight[in_flight_id];
-				group->in_flight.erase(in_flight_id);
+				return complete(*group, event);
+			}
 
-				// remove from cbarray, destroy array if need be
-				auto array = op->cb_array;
-				--array->items_left;
-				if (!array->items_left) {
-					free(array->array); // free the malloc'd memory
-					group->arrays.erase(array); // remove from the set
-					// the only remaining reference to this CbArray is in the ops that used it
-					// it will be overwritten and eventually destroyed automatically
-				}
+			int cancel(std::shared_ptr<IAsyncIop> ia) {
+				if (!started) assert(!"IOManager not started!");
 
-				// update return and error fields
-				op->result = (int)event.res;
+				std::shared_ptr<_KernelAsyncIop> a = std::static_pointer_cast<_KernelAsyncIop>(ia);
 
-				return op;
+				groups_mutex.lock();
+				auto group = groups[a->group_id];
+				groups_mutex.unlock();
+
+				io_event event = {0};
+				int err = io_cancel(group->ctx, &a->cb, &event);
+
+				// newer kernels complete a cancelled op through io_getevents as usual
+				if (err == -EINPROGRESS) {
+					return 0;
+				}
+				if (err) {
+					return -err;
+				}
+
+				// older ones hand its event back here, and it never reaches io_getevents
+				event.data = a->cb.data;
+				event.res = -ECANCELED;
+				group->cancelled.push(complete(*group, event));
+				return 0;
 			}
 
 		private:
@@ -308,12 +330,41 @@ namespace diskspd {
 				// map of in_flight ids (stored in iocb's aio_data while in flight) to the _KernelAsyncIop
 				std::map<void *, std::shared_ptr<_KernelAsyncIop>> in_flight;
 				void * next_flight = 0;
+
+				// ops cancelled by cancel(), waiting to be returned by wait()
+				std::queue<std::shared_ptr<_KernelAsyncIop>> cancelled;
 			};
 
 			// map of group number to group
 			std::map<int, std::shared_ptr<Group>> groups;
 			std::mutex groups_mutex;
 
+			/**
+			 *	Take a finished op out of the in flight map and fill in its results
+			 */
+			std::shared_ptr<_KernelAsyncIop> complete(Group& group, const io_event& event) {
+
+				// get the op
+				void * in_flight_id = event.data;
+				auto op = group.in_flight[in_flight_id];
+				group.in_flight.erase(in_flight_id);
+
+				// remove from cbarray, destroy array if need be
+				auto array = op->cb_array;
+				--array->items_left;
+				if (!array->items_left) {
+					free(array->array); // free the malloc'd memory
+					group.arrays.erase(array); // remove from the set
+					// the only remaining reference to this CbArray is in the ops that used it
+					// it will be overwritten and eventually destroyed automatically
+				}
+
+				// update return and error fields; the kernel returns errors negated in res
+				op->result = (int)event.res;
+				op->err = (long)event.res < 0 ? -(long)event.res : 0;
+
+				return op;
+			}
 	};
 
 	KernelAsyncIOManager::KernelAsyncIOManager() { p = new _KernelAsyncIOManager(); }
@@ -348,7 +399,16 @@ namespace diskspd {
 	}
 
 	std::shared_ptr<IAsyncIop> KernelAsyncIOManager::wait(int group_id) {
-		return p->wait(group_id);
+		return p->wait(group_id, nullptr);
+	}
+
+	std::shared_ptr<IAsyncIop> KernelAsyncIOManager::wait(int group_id, uint64_t timeout_us) {
+		timespec timeout = { (time_t)(timeout_us/1000000), (long)(timeout_us%1000000)*1000 };
+		return p->wait(group_id, &timeout);
+	}
+
+	int KernelAsyncIOManager::cancel(std::shared_ptr<IAsyncIop> a) {
+		return p->cancel(a);
 	}
 
 } // namespace diskspd
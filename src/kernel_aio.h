@@ -47,6 +47,10 @@ namespace diskspd {
 
 			std::shared_ptr<IAsyncIop> wait(int group_id);
 
+			std::shared_ptr<IAsyncIop> wait(int group_id, uint64_t timeout_us);
+
+			int cancel(std::shared_ptr<IAsyncIop> a);
+
 		private:
 			// This class uses a private implementation pattern
 			// We use a private class to do the actual work
@@ -0,0 +1,552 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "lsm.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	// size of the reads and writes done by flushes and compactions
+	static const off_t LSM_IO_SIZE = 1024*1024;
+
+	LsmTable::~LsmTable() {
+		close(fd);
+		unlink(path.c_str());
+	}
+
+	bool LsmTree::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t pos = 0;
+
+		while (pos < settings.size()) {
+			size_t end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --lsm setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			// sizes and rates take K/M/G suffixes, counts are plain numbers (fp may be 0)
+			bool is_count = key == "fanin" || key == "fp";
+			if (is_count ? !value.size() || !Options::is_numeric(value.c_str()) :
+					!Options::valid_byte_size(value.c_str())) {
+				fprintf(stderr, "Invalid value for --lsm setting %s\n", key.c_str());
+				return false;
+			}
+			unsigned long long number = is_count ? strtoull(value.c_str(), nullptr, 10) :
+				Options::byte_size_from_arg(value.c_str(), 1);
+
+			if (key == "table") {
+				table_size = number;
+			} else if (key == "size") {
+				data_size = number;
+			} else if (key == "flush") {
+				flush_rate = number;
+			} else if (key == "compact") {
+				compaction_rate = number;
+			} else if (key == "fanin" && number >= 2) {
+				fanin = number;
+			} else if (key == "fp" && number <= 100) {
+				false_positive_pct = number;
+			} else {
+				fprintf(stderr, "Invalid --lsm setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::shared_ptr<LsmTable> LsmTree::create_table(const Target& target, off_t size,
+			unsigned int level) {
+
+		std::unique_lock<std::mutex> lock(mutex);
+		std::string path = target.path + "/diskspd-lsm-" + std::to_string(next_id++) + ".sst";
+		lock.unlock();
+
+		int fd = open(path.c_str(), target.open_flags | O_CREAT | O_TRUNC, 0664);
+		if (fd == -1) {
+			fprintf(stderr, "Failed to create LSM table %s: %s\n", path.c_str(), strerror(errno));
+			return nullptr;
+		}
+		return std::make_shared<LsmTable>(path, fd, size, level);
+	}
+
+	bool LsmTree::populate(const Target& target) {
+
+		std::shared_ptr<LsmTable> base = create_table(target, data_size, LsmTable::BASE_LEVEL);
+		if (!base) {
+			return false;
+		}
+
+		TargetBuffer buf(LSM_IO_SIZE, target.open_flags & O_DIRECT ? target.sector_size : 1);
+		buf.fill_default();
+
+		v_printf("	Laying out LSM base table \"%s\"\n", base->path.c_str());
+		for (off_t offset = 0; offset < data_size; offset += LSM_IO_SIZE) {
+			size_t nbytes = std::min(LSM_IO_SIZE, data_size - offset);
+			if (pwrite(base->fd, buf.ptr(), nbytes, offset) != (ssize_t)nbytes) {
+				fprintf(stderr, "Failed to lay out LSM table %s\n", base->path.c_str());
+				return false;
+			}
+		}
+		if (fsync(base->fd)) {
+			perror("fsync failed");
+			return false;
+		}
+
+		install(base, LsmVersion());
+		return true;
+	}
+
+	bool LsmTree::pick_compaction(LsmVersion& inputs, std::shared_ptr<LsmTable>& base,
+			unsigned int& output_level, off_t& output_size) {
+
+		std::shared_ptr<const LsmVersion> v = current();
+
+		unsigned int max_level = 0;
+		for (auto& table : *v) {
+			if (table->level != LsmTable::BASE_LEVEL) {
+				max_level = std::max(max_level, table->level);
+			}
+		}
+
+		for (unsigned int level = 0; level <= max_level; ++level) {
+
+			// oldest first
+			inputs.clear();
+			output_size = 0;
+			for (auto it = v->rbegin(); it != v->rend() && inputs.size() < fanin; ++it) {
+				if ((*it)->level == level) {
+					inputs.push_back(*it);
+					output_size += (*it)->size;
+				}
+			}
+			if (inputs.size() < fanin) {
+				continue;
+			}
+
+			// by now the inputs would overwrite most of the base, so merge them into it
+			if (output_size >= data_size) {
+				base = v->back();
+				output_level = LsmTable::BASE_LEVEL;
+				output_size = data_size;
+			} else {
+				base = nullptr;
+				output_level = level + 1;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void LsmTree::install(const std::shared_ptr<LsmTable>& added, const LsmVersion& removed) {
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto next = std::make_shared<LsmVersion>();
+		bool inserted = false;
+
+		// a flushed table is the newest
+		if (removed.empty()) {
+			next->push_back(added);
+			inserted = true;
+		}
+		for (auto& table : *version) {
+			if (std::find(removed.begin(), removed.end(), table) != removed.end()) {
+				// a merged table takes the place of its newest input, as its data is no newer
+				if (!inserted && added->level != LsmTable::BASE_LEVEL) {
+					next->push_back(added);
+					inserted = true;
+				}
+				continue;
+			}
+			next->push_back(table);
+		}
+		// the base is always the oldest
+		if (!inserted) {
+			next->push_back(added);
+		}
+
+		version = next;
+	}
+
+	std::shared_ptr<const LsmVersion> LsmTree::current() {
+		std::lock_guard<std::mutex> lock(mutex);
+		return version;
+	}
+
+	void LsmTree::remove_tables() {
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& table : *version) {
+			++final_tables[table->level];
+		}
+		version = std::make_shared<LsmVersion>();
+	}
+
+	/**
+	 *	Add synchronous background I/O to the thread's results. Background I/O isn't added to the
+	 *	latency histograms, which are left to the foreground lookups
+	 */
+	static void record_background_io(ThreadParams& thread, IAsyncIop::Type type, size_t nbytes) {
+
+		if (!*thread.record_results) return;
+
+		std::shared_ptr<TargetResults>& results = thread.targets[0]->results;
+		uint64_t since_start_ms = PerfClock::get_time_ms() - thread.job_options->start_time_ms;
+
+		results->bytes_count += nbytes;
+		++results->iops_count;
+
+		if (type == IAsyncIop::Type::READ) {
+			results->read_bytes_count += nbytes;
+			++results->read_iops_count;
+			if (thread.job_options->measure_iops_std_dev) {
+				results->read_bucketizer.Add(since_start_ms);
+			}
+		} else {
+			results->write_bytes_count += nbytes;
+			++results->write_iops_count;
+			if (thread.job_options->measure_iops_std_dev) {
+				results->write_bucketizer.Add(since_start_ms);
+			}
+		}
+	}
+
+	/**
+	 *	Sleep until 'bytes' bytes would have been transferred since start_ns at 'rate' bytes per
+	 *	second, waking up at least every 10ms to check for the end of the test. Returns false if
+	 *	the test ended
+	 */
+	static bool pace(ThreadParams& thread, uint64_t start_ns, uint64_t bytes, off_t rate) {
+
+		uint64_t due_ns = start_ns + (uint64_t)((double)bytes*1000000000/rate);
+
+		while (*thread.run_threads) {
+			uint64_t now_ns = PerfClock::get_time_ns();
+			if (now_ns >= due_ns) {
+				return true;
+			}
+			timespec ts = {0, (long)std::min(due_ns - now_ns, (uint64_t)10000000)};
+			nanosleep(&ts, nullptr);
+		}
+		return false;
+	}
+
+	/**
+	 *	Memtable flushes: write tables of table_size to level 0 at the flush rate
+	 */
+	static void lsm_flush(ThreadParams& thread, LsmTree& tree) {
+
+		const Target& target = *thread.targets[0]->target;
+		TargetBuffer buf(LSM_IO_SIZE, target.open_flags & O_DIRECT ? target.sector_size : 1);
+		buf.fill_default();
+
+		thread.signal_initialized();
+
+		// the ingest rate is steady, so flushes are paced from the start rather than per table
+		uint64_t start_ns = PerfClock::get_time_ns();
+		uint64_t flushed = 0;
+
+		while (*thread.run_threads) {
+
+			std::shared_ptr<LsmTable> table = tree.create_table(target, tree.table_size, 0);
+			if (!table) {
+				thread.thread_abort();
+				return;
+			}
+
+			for (off_t offset = 0; offset < table->size && *thread.run_threads; offset += LSM_IO_SIZE) {
+				size_t nbytes = std::min(LSM_IO_SIZE, table->size - offset);
+				if (pwrite(table->fd, buf.ptr(), nbytes, offset) != (ssize_t)nbytes) {
+					perror("LSM flush write failed");
+					thread.thread_abort();
+					return;
+				}
+				record_background_io(thread, IAsyncIop::Type::WRITE, nbytes);
+				flushed += nbytes;
+				pace(thread, start_ns, flushed, tree.flush_rate);
+			}
+			if (!*thread.run_threads) break;
+
+			// make the table and its name durable before it's used
+			if (fsync(table->fd) || fsync(thread.targets[0]->fd)) {
+				perror("LSM flush fsync failed");
+				thread.thread_abort();
+				return;
+			}
+			tree.install(table, LsmVersion());
+
+			if (*thread.record_results) {
+				++tree.flushes;
+			}
+		}
+	}
+
+	/**
+	 *	Compactions: read fanin tables and write them merged into one, within the compaction rate
+	 */
+	static void lsm_compact(ThreadParams& thread, LsmTree& tree) {
+
+		const Target& target = *thread.targets[0]->target;
+		TargetBuffer buf(LSM_IO_SIZE, target.open_flags & O_DIRECT ? target.sector_size : 1);
+		buf.fill_default();
+
+		thread.signal_initialized();
+
+		while (*thread.run_threads) {
+
+			LsmVersion inputs;
+			std::shared_ptr<LsmTable> base;
+			unsigned int output_level;
+			off_t output_size;
+
+			if (!tree.pick_compaction(inputs, base, output_level, output_size)) {
+				timespec ts = {0, 10000000};
+				nanosleep(&ts, nullptr);
+				continue;
+			}
+			if (base) {
+				inputs.push_back(base);
+			}
+
+			std::shared_ptr<LsmTable> output = tree.create_table(target, output_size, output_level);
+			if (!output) {
+				thread.thread_abort();
+				return;
+			}
+
+			off_t input_size = 0;
+			for (auto& input : inputs) input_size += input->size;
+
+			uint64_t start_ns = PerfClock::get_time_ns();
+			off_t read = 0;
+			off_t written = 0;
+
+			// write the output in step with reading the inputs, like a merge
+			for (auto& input : inputs) {
+				for (off_t offset = 0; offset < input->size && *thread.run_threads; offset += LSM_IO_SIZE) {
+
+					size_t nbytes = std::min(LSM_IO_SIZE, input->size - offset);
+					if (pread(input->fd, buf.ptr(), nbytes, offset) != (ssize_t)nbytes) {
+						perror("LSM compaction read failed");
+						thread.thread_abort();
+						return;
+					}
+					record_background_io(thread, IAsyncIop::Type::READ, nbytes);
+					read += nbytes;
+
+					while (written < (off_t)((double)output_size*read/input_size)) {
+						size_t wbytes = std::min(LSM_IO_SIZE, output_size - written);
+						if (pwrite(output->fd, buf.ptr(), wbytes, written) != (ssize_t)wbytes) {
+							perror("LSM compaction write failed");
+							thread.thread_abort();
+							return;
+						}
+						record_background_io(thread, IAsyncIop::Type::WRITE, wbytes);
+						written += wbytes;
+					}
+
+					pace(thread, start_ns, read + written, tree.compaction_rate);
+				}
+			}
+			if (!*thread.run_threads) break;
+
+			if (fsync(output->fd) || fsync(thread.targets[0]->fd)) {
+				perror("LSM compaction fsync failed");
+				thread.thread_abort();
+				return;
+			}
+			tree.install(output, inputs);
+
+			if (*thread.record_results) {
+				++tree.compactions;
+			}
+		}
+	}
+
+	/**
+	 *	State of one -o slot doing point lookups
+	 */
+	struct LookupSlot {
+		std::shared_ptr<IAsyncIop> op;
+		// the version the lookup started on, which keeps its tables open
+		std::shared_ptr<const LsmVersion> version;
+		// the tables the lookup reads, in order
+		std::vector<LsmTable *> probes;
+		size_t step = 0;
+		uint64_t start_us = 0;
+	};
+
+	/**
+	 *	Start a new lookup of a random key. The key is in a table picked in proportion to its size;
+	 *	every newer table is probed first, and costs a read when its bloom filter gives a false
+	 *	positive
+	 */
+	static void start_lookup(ThreadParams& thread, LsmTree& tree, LookupSlot& slot) {
+
+		size_t block_size = thread.targets[0]->target->block_size;
+
+		slot.version = tree.current();
+		slot.probes.clear();
+		slot.step = 0;
+		slot.start_us = PerfClock::get_time_us();
+
+		off_t blocks = 0;
+		for (auto& table : *slot.version) blocks += table->size/block_size;
+
+		off_t key_block = thread.rng_engine->get_rand_offset(blocks);
+		for (auto& table : *slot.version) {
+			off_t table_blocks = table->size/block_size;
+			if (key_block < table_blocks) {
+				slot.probes.push_back(table.get());
+				break;
+			}
+			key_block -= table_blocks;
+			if (thread.rng_engine->get_percentage() <= tree.false_positive_pct) {
+				slot.probes.push_back(table.get());
+			}
+		}
+	}
+
+	/**
+	 *	Enqueue the read for the slot's current probe
+	 */
+	static bool issue_probe(ThreadParams& thread, LookupSlot& slot) {
+
+		size_t block_size = thread.targets[0]->target->block_size;
+		LsmTable * table = slot.probes[slot.step];
+
+		slot.op->set_fd(table->fd);
+		slot.op->set_offset(thread.rng_engine->get_rand_offset(table->size/block_size)*block_size);
+		slot.op->set_time(PerfClock::get_time_us());
+
+		if (thread.io_manager->enqueue(slot.op)) {
+			perror("aio enqueue failed");
+			thread.thread_abort();
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 *	Foreground point lookups; -o at a time, each a chain of dependent reads
+	 */
+	static void lsm_lookups(ThreadParams& thread, LsmTree& tree) {
+
+		std::shared_ptr<TargetData>& t_data = thread.targets[0];
+		std::vector<LookupSlot> slots(t_data->target->overlap);
+
+		for (unsigned int i = 0; i < slots.size(); ++i) {
+			void * buf = static_cast<char *>(t_data->buffer.ptr()) + i*t_data->target->block_size;
+			slots[i].op = thread.io_manager->construct(
+					IAsyncIop::Type::READ,
+					t_data->fd,
+					0,
+					buf,
+					buf,
+					t_data->target->block_size,
+					thread.thread_id,
+					t_data,
+					0
+					);
+			start_lookup(thread, tree, slots[i]);
+			if (!issue_probe(thread, slots[i])) {
+				return;
+			}
+		}
+
+		if (thread.io_manager->submit(thread.thread_id)) {
+			perror("aio submit failed");
+			thread.thread_abort();
+			return;
+		}
+
+		thread.signal_initialized();
+
+		while (*thread.run_threads) {
+
+			std::shared_ptr<IAsyncIop> op = thread.io_manager->wait(thread.thread_id);
+
+			if (!*thread.run_threads) break;
+
+			if (!thread.check_completion(op)) {
+				return;
+			}
+
+			uint64_t abs_time_us = PerfClock::get_time_us();
+			if (*thread.record_results) {
+				thread.record_completion(op, abs_time_us);
+			}
+
+			LookupSlot * slot = nullptr;
+			for (auto& s : slots) {
+				if (s.op == op) slot = &s;
+			}
+
+			// the key was found; this lookup is done
+			if (++slot->step == slot->probes.size()) {
+				if (*thread.record_results) {
+					++t_data->results->chain_count;
+					if (thread.job_options->measure_latency) {
+						t_data->results->chain_latency_histogram.Add(abs_time_us - slot->start_us);
+					}
+				}
+				start_lookup(thread, tree, *slot);
+			}
+
+			if (!issue_probe(thread, *slot)) {
+				return;
+			}
+			if (thread.io_manager->submit(thread.thread_id)) {
+				perror("aio submit failed");
+				thread.thread_abort();
+				return;
+			}
+		}
+	}
+
+	void ThreadParams::lsm_func() {
+
+		LsmTree& tree = *job_options->lsm;
+
+		// the first two threads on the target do the background work
+		if (rel_thread_id == 0) {
+			lsm_flush(*this, tree);
+		} else if (rel_thread_id == 1) {
+			lsm_compact(*this, tree);
+		} else {
+			lsm_lookups(*this, tree);
+		}
+
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <sys/types.h>
+
+#ifndef DISKSPD_LSM_H
+#define DISKSPD_LSM_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	A sorted table file in an emulated LSM tree. The file is closed and removed when the last
+	 *	reference to the table goes, so readers with ops in flight keep it alive after compaction
+	 */
+	struct LsmTable {
+		LsmTable(const std::string& path, int fd, off_t size, unsigned int level) :
+			path(path), fd(fd), size(size), level(level) {}
+		~LsmTable();
+
+		std::string path;
+		int fd;
+		off_t size;
+		unsigned int level;		// 0 for flushed tables; BASE_LEVEL for the base data set
+
+		static const unsigned int BASE_LEVEL = ~0u;
+	};
+
+	/// live tables, newest first. Never modified once installed, so readers can use it unlocked
+	typedef std::vector<std::shared_ptr<LsmTable>> LsmVersion;
+
+	/**
+	 *	Shared state of the --lsm workload: the configuration, and the current set of tables in the
+	 *	target directory.
+	 *
+	 *	The tree is size-tiered: a background thread flushes tables of table_size into level 0,
+	 *	and another merges fanin tables of a level into one table of the next level. Once a merged
+	 *	table would be as big as the base data set, the inputs are merged into the base instead.
+	 *	Every table may contain any key, so a point lookup probes tables newest first until it
+	 *	finds the key, and each bloom filter false positive on the way costs an extra read
+	 */
+	class LsmTree {
+		public:
+			off_t table_size				= 64*1024*1024;		// table=
+			off_t data_size					= 1024*1024*1024;	// size=; the base data set
+			off_t flush_rate				= 16*1024*1024;		// flush=; bytes per second
+			off_t compaction_rate			= 64*1024*1024;		// compact=; read+write bytes per second
+			unsigned int fanin				= 4;				// fanin=
+			unsigned int false_positive_pct	= 1;				// fp=
+
+			// counted during the main duration only
+			std::atomic<uint64_t> flushes;
+			std::atomic<uint64_t> compactions;
+
+			LsmTree() : flushes(0), compactions(0) {}
+
+			/**
+			 *	Parse an --lsm argument: comma separated key=value settings, named as above
+			 */
+			bool parse(const char * arg);
+
+			/**
+			 *	Create the base table in the target directory, before the threads start
+			 */
+			bool populate(const Target& target);
+
+			/**
+			 *	Create a new, empty table file in the target directory. It isn't visible to readers
+			 *	until it's install()ed
+			 */
+			std::shared_ptr<LsmTable> create_table(const Target& target, off_t size, unsigned int level);
+
+			/**
+			 *	Find the next compaction: the oldest fanin tables of the lowest level that has that
+			 *	many. Returns false if there's nothing to compact
+			 */
+			bool pick_compaction(LsmVersion& inputs, std::shared_ptr<LsmTable>& base,
+					unsigned int& output_level, off_t& output_size);
+
+			/**
+			 *	Atomically add a table to the tree and remove others from it
+			 */
+			void install(const std::shared_ptr<LsmTable>& added, const LsmVersion& removed);
+
+			/**
+			 *	The current set of tables
+			 */
+			std::shared_ptr<const LsmVersion> current();
+
+			/**
+			 *	Remove all the tables once the Job is done, counting them in final_tables
+			 */
+			void remove_tables();
+
+			// number of tables in each level when the Job ended
+			std::map<unsigned int, unsigned int> final_tables;
+
+		private:
+			std::mutex mutex;
+			std::shared_ptr<const LsmVersion> version = std::make_shared<LsmVersion>();
+			uint64_t next_id = 0;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_LSM_H
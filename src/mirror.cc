@@ -0,0 +1,449 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <errno.h>
+
+#include "debug.h"
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "mirror.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool MirrorSet::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t pos = 0;
+
+		while (pos < settings.size()) {
+			size_t end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --mirror setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			// the hedge percentile may have a fraction, e.g. 99.9
+			char * value_end = nullptr;
+			double number = strtod(value.c_str(), &value_end);
+			if (!value.size() || *value_end || number < 0) {
+				fprintf(stderr, "Invalid value for --mirror setting %s\n", key.c_str());
+				return false;
+			}
+
+			if (key == "quorum" && number >= 1 && number == (unsigned int)number) {
+				quorum = (unsigned int)number;
+			} else if (key == "hedge" && number < 100) {
+				hedge_percentile = number;
+			} else {
+				fprintf(stderr, "Invalid --mirror setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 *	What a replica op was issued for
+	 */
+	struct MirrorOpOwner {
+		size_t slot;
+		uint64_t generation;	// the slot's logical op
+		size_t member;
+		bool primary;			// a read's first replica
+		bool hedge;
+	};
+
+	/**
+	 *	State of one -o slot of logical ops
+	 */
+	struct MirrorSlot {
+		IAsyncIop::Type type;
+		off_t offset = 0;				// logical offset
+		uint64_t start_us = 0;
+		uint64_t generation = 0;		// incremented for each logical op
+		bool blocked = false;			// the op is waiting for free replica ops to be issued
+		unsigned int acks = 0;			// replicas a write has completed on
+		size_t primary = 0;				// replica a read went to first
+		bool hedged = false;			// past the hedge deadline (even if no hedge could be sent)
+		bool hedge_sent = false;
+
+		// replica ops of the current logical op that haven't completed
+		std::vector<std::shared_ptr<IAsyncIop>> in_flight;
+	};
+
+	/**
+	 *	Per-thread state of the --mirror workload. Ops that lose a hedged read, or that finish a
+	 *	write after its quorum, are left to complete in the background while their slot moves
+	 *	on, so each replica has a pool of twice -o ops to draw from
+	 */
+	class MirrorThread {
+		public:
+			MirrorThread(ThreadParams& thread) :
+				thread(thread),
+				mirror(*thread.job_options->mirror),
+				replicas(thread.targets.size()),
+				quorum(mirror.quorum ? mirror.quorum : replicas),
+				pools(replicas) {}
+
+			/**
+			 *	Create the replica ops and start every slot's first logical op
+			 */
+			bool start() {
+
+				for (size_t m = 0; m < replicas; ++m) {
+					std::shared_ptr<TargetData>& t_data = thread.targets[m];
+					const Target& target = *t_data->target;
+
+					for (size_t i = 0; i < target.overlap; ++i) {
+						void * read_buf = static_cast<char *>(t_data->buffer.ptr()) + i*target.block_size;
+						void * write_buf = target.separate_buffers ? t_data->write_buffer.ptr() : read_buf;
+
+						pools[m].push_back(thread.io_manager->construct(
+								IAsyncIop::Type::READ,
+								t_data->fd,
+								target.base_offset,
+								read_buf,
+								write_buf,
+								target.block_size,
+								thread.thread_id,
+								t_data,
+								0
+								));
+					}
+				}
+
+				logical = std::make_shared<TargetData>();
+				logical->target = mirror.logical;
+				logical->results = thread.results->logical_results;
+				logical->thread = thread.targets[0]->thread;
+				logical->rng_engine = thread.rng_engine;
+
+				slots.resize(mirror.logical->overlap);
+				off_t curr_offset = logical->get_start_offset();
+				for (size_t i = 0; i < slots.size(); ++i) {
+					slots[i].offset = curr_offset;
+					curr_offset = logical->get_next_offset(curr_offset);
+					if (!start_op(i, false)) {
+						return false;
+					}
+				}
+				return submit();
+			}
+
+			/**
+			 *	Wait for the next replica op, or the next hedge deadline. Returns false if the
+			 *	thread has to stop
+			 */
+			bool step() {
+
+				// the earliest deadline of a read that hasn't been hedged
+				uint64_t next_deadline = 0;
+				for (auto& slot : slots) {
+					if (hedgeable(slot) && (!next_deadline || slot.start_us + deadline_us < next_deadline)) {
+						next_deadline = slot.start_us + deadline_us;
+					}
+				}
+
+				std::shared_ptr<IAsyncIop> op;
+				if (next_deadline) {
+					uint64_t now = PerfClock::get_time_us();
+					op = thread.io_manager->wait(thread.thread_id,
+							next_deadline > now ? next_deadline - now : 0);
+				} else {
+					op = thread.io_manager->wait(thread.thread_id);
+				}
+
+				// potentially exit right after waiting for io - improves accuracy of duration
+				if (!*thread.run_threads) return false;
+
+				uint64_t abs_time_us = PerfClock::get_time_us();
+
+				if (op) {
+					if (!complete(op, abs_time_us)) {
+						return false;
+					}
+				}
+
+				// send hedges for the reads that are past their deadline
+				for (size_t i = 0; i < slots.size(); ++i) {
+					MirrorSlot& slot = slots[i];
+					if (!hedgeable(slot) || abs_time_us < slot.start_us + deadline_us) continue;
+
+					slot.hedged = true;
+					for (size_t k = 1; k < replicas; ++k) {
+						size_t m = (slot.primary + k) % replicas;
+						if (pools[m].size()) {
+							if (!issue(i, m, false, true)) {
+								return false;
+							}
+							slot.hedge_sent = true;
+							break;
+						}
+					}
+				}
+
+				return submit();
+			}
+
+			/**
+			 *	Record the hedge deadline the thread ended with
+			 */
+			void finish() {
+				thread.results->mirror_results->deadline_us = deadline_us;
+			}
+
+		private:
+			ThreadParams& thread;
+			const MirrorSet& mirror;
+			const size_t replicas;
+			const unsigned int quorum;
+
+			// the logical op offsets come from a TargetData for the mirror, like any target's
+			std::shared_ptr<TargetData> logical;
+			std::vector<MirrorSlot> slots;
+
+			// free replica ops, for each replica
+			std::vector<std::vector<std::shared_ptr<IAsyncIop>>> pools;
+			std::map<IAsyncIop *, MirrorOpOwner> owners;
+			bool enqueued = false;
+
+			size_t next_primary = 0;
+			uint64_t deadline_us = 0;			// 0 until the first window of reads is done
+			Histogram<uint64_t> window;			// latencies of the first replica reads
+
+			bool hedgeable(const MirrorSlot& slot) const {
+				return deadline_us && !slot.blocked && slot.type == IAsyncIop::Type::READ &&
+					!slot.hedged && slot.in_flight.size();
+			}
+
+			/**
+			 *	Start a slot's next logical op (or, if it's blocked, retry the current one)
+			 */
+			bool start_op(size_t i, bool next) {
+
+				MirrorSlot& slot = slots[i];
+
+				if (!slot.blocked) {
+					if (next) {
+						slot.offset = logical->get_next_offset(slot.offset);
+					}
+					slot.type = thread.rw_rng_engine->get_percentage() <= logical->target->write_percentage ?
+						IAsyncIop::Type::WRITE : IAsyncIop::Type::READ;
+					// ops still in flight from the last logical op carry on in the background
+					++slot.generation;
+					slot.in_flight.clear();
+					slot.acks = 0;
+					slot.hedged = false;
+					slot.hedge_sent = false;
+				}
+
+				if (slot.type == IAsyncIop::Type::WRITE) {
+					// a write needs every replica
+					for (auto& pool : pools) {
+						if (pool.empty()) {
+							slot.blocked = true;
+							return true;
+						}
+					}
+					slot.blocked = false;
+					slot.start_us = PerfClock::get_time_us();
+					for (size_t m = 0; m < replicas; ++m) {
+						if (!issue(i, m, false, false)) {
+							return false;
+						}
+					}
+					return true;
+				}
+
+				// spread reads over the replicas
+				for (size_t k = 0; k < replicas; ++k) {
+					size_t m = (next_primary + k) % replicas;
+					if (pools[m].size()) {
+						next_primary = m + 1;
+						slot.blocked = false;
+						slot.primary = m;
+						slot.start_us = PerfClock::get_time_us();
+						return issue(i, m, true, false);
+					}
+				}
+				slot.blocked = true;
+				return true;
+			}
+
+			/**
+			 *	Enqueue a replica op for a slot's current logical op
+			 */
+			bool issue(size_t i, size_t m, bool primary, bool hedge) {
+
+				MirrorSlot& slot = slots[i];
+				std::shared_ptr<IAsyncIop> op = pools[m].back();
+				pools[m].pop_back();
+
+				op->set_type(slot.type);
+				op->set_offset(thread.targets[m]->target->base_offset + slot.offset);
+				op->set_time(PerfClock::get_time_us());
+				owners[op.get()] = { i, slot.generation, m, primary, hedge };
+
+				if (thread.io_manager->enqueue(op)) {
+					perror("aio enqueue failed");
+					thread.thread_abort();
+					return false;
+				}
+				slot.in_flight.push_back(op);
+				enqueued = true;
+				return true;
+			}
+
+			bool submit() {
+				if (enqueued && thread.io_manager->submit(thread.thread_id)) {
+					perror("aio submit failed");
+					thread.thread_abort();
+					return false;
+				}
+				enqueued = false;
+				return true;
+			}
+
+			/**
+			 *	Handle a finished replica op: record it, complete its logical op if it was the one
+			 *	the logical op was waiting for, and return it to its pool
+			 */
+			bool complete(const std::shared_ptr<IAsyncIop>& op, uint64_t abs_time_us) {
+
+				MirrorOpOwner owner = owners[op.get()];
+				MirrorSlot& slot = slots[owner.slot];
+				MirrorResults& mirror_results = *thread.results->mirror_results;
+				bool record = *thread.record_results;
+
+				bool current = owner.generation == slot.generation;
+				if (current) {
+					for (auto it = slot.in_flight.begin(); it != slot.in_flight.end(); ++it) {
+						if (*it == op) {
+							slot.in_flight.erase(it);
+							break;
+						}
+					}
+				}
+
+				if (op->get_errno() == ECANCELED) {
+					if (record) ++mirror_results.cancelled;
+					pools[owner.member].push_back(op);
+					return retry_blocked();
+				}
+
+				if (!thread.check_completion(op)) {
+					return false;
+				}
+				if (record) {
+					thread.record_completion(op, abs_time_us);
+				}
+				pools[owner.member].push_back(op);
+
+				// the first replica's latency sets the deadline, and shows what reads would see
+				// without hedging
+				if (owner.primary) {
+					uint64_t op_time_us = abs_time_us - op->get_time();
+					if (record && thread.job_options->measure_latency) {
+						mirror_results.primary_latency_histogram.Add(op_time_us);
+					}
+					if (mirror.hedge_percentile) {
+						window.Add(op_time_us);
+						if (window.GetSampleSize() >= MirrorSet::HEDGE_WINDOW) {
+							deadline_us = window.GetPercentile(mirror.hedge_percentile/100);
+							window.Clear();
+						}
+					}
+				}
+
+				if (current && slot.type == IAsyncIop::Type::WRITE && ++slot.acks == quorum) {
+					if (record) {
+						thread.record_logical_completion(true, mirror.logical->block_size,
+								slot.start_us, abs_time_us);
+					}
+					// the remaining replicas finish in the background
+					if (!start_op(owner.slot, true)) {
+						return false;
+					}
+
+				} else if (current && slot.type == IAsyncIop::Type::READ) {
+					if (record) {
+						thread.record_logical_completion(false, mirror.logical->block_size,
+								slot.start_us, abs_time_us);
+						++mirror_results.reads;
+						mirror_results.hedges += slot.hedge_sent;
+						mirror_results.hedge_wins += owner.hedge;
+					}
+					// the loser, if there is one, comes back through wait() whether this works or not
+					for (auto& loser : slot.in_flight) {
+						thread.io_manager->cancel(loser);
+					}
+					if (!start_op(owner.slot, true)) {
+						return false;
+					}
+				}
+
+				return retry_blocked();
+			}
+
+			/**
+			 *	Issue the logical ops that were waiting for replica ops to be free
+			 */
+			bool retry_blocked() {
+				for (size_t i = 0; i < slots.size(); ++i) {
+					if (slots[i].blocked && !start_op(i, false)) {
+						return false;
+					}
+				}
+				return true;
+			}
+	};
+
+	void ThreadParams::mirror_func() {
+
+		MirrorThread mirror(*this);
+
+		if (!mirror.start()) {
+			return;
+		}
+
+		// Unblock main thread (so the job can start the warmup/duration)
+		signal_initialized();
+
+		/************
+		 *	Do Work
+		 ************/
+
+		while (*run_threads) {
+			if (!mirror.step()) {
+				break;
+			}
+		}
+
+		mirror.finish();
+
+		// release resources
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
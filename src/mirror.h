@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <memory>
+#include <cstdint>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_MIRROR_H
+#define DISKSPD_MIRROR_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	A set of replicas made of all of a Job's targets (--mirror). Logical ops are generated on
+	 *	the 'logical' target. A write goes to every replica and completes once 'quorum' of them
+	 *	have; a read goes to one replica, and is hedged to another if it takes longer than the
+	 *	hedge percentile of recent first-replica reads. Whichever finishes first completes the
+	 *	read, and the other one is cancelled
+	 */
+	struct MirrorSet {
+		unsigned int quorum			= 0;	// quorum=; replicas a write waits for, 0 for all
+		double hedge_percentile		= 0;	// hedge=; 0 disables hedged reads
+
+		// the deadline is recomputed after this many first-replica reads, from just those reads
+		static const size_t HEDGE_WINDOW = 1024;
+
+		// the mirror as a single target; holds the offset, -w and -o settings for logical ops
+		std::shared_ptr<Target> logical;
+
+		/**
+		 *	Parse a --mirror argument: comma separated key=value settings, named as above
+		 */
+		bool parse(const char * arg);
+	};
+
+	/**
+	 *	Per-thread hedged read results. Only logical reads are counted
+	 */
+	struct MirrorResults {
+		uint64_t reads				= 0;
+		uint64_t hedges				= 0;	// reads a hedge was sent for
+		uint64_t hedge_wins			= 0;	// reads the hedge completed first
+		uint64_t cancelled			= 0;	// losing reads that were cancelled before finishing
+		uint64_t deadline_us		= 0;	// hedge deadline when the Job ended
+
+		// latency of each read's first replica, i.e. what reads would see without hedging.
+		// A first replica cancelled before finishing isn't included
+		Histogram<uint64_t> primary_latency_histogram;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_MIRROR_H
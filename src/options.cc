@@ -96,6 +96,36 @@ namespace diskspd
 		return static_cast<unsigned long long>(final_offset);
 	}
 
+	std::string Options::option_name(const DiskspdOption& option) {
+		if (option.opt.key < LONG_OPTION_BASE) {
+			return std::string("-") + (char)option.opt.key;
+		}
+		return std::string("--") + option.opt.name;
+	}
+
+	std::vector<OptionType> Options::given() const {
+		std::vector<OptionType> types;
+		for (auto& opt : opts) {
+			types.push_back(opt.first);
+		}
+		for (auto& args : repeated_args) {
+			if (args.second.size()) {
+				types.push_back(args.first);
+			}
+		}
+		return types;
+	}
+
+	std::string Options::option_name(OptionType o) const {
+		for (auto& entry : opt_map) {
+			if (entry.second.type == o) {
+				return option_name(entry.second);
+			}
+		}
+		assert(!"Invalid option passed to option_name!"); // programmer error
+		return "";
+	}
+
 	/*
 	 *	*******************
 	 *	parse_args related
@@ -112,6 +142,18 @@ namespace diskspd
 		return options->parse_arg(key, arg);
 	}
 
+	bool Options::set_arg(OptionType o, const std::string& arg) {
+		for (auto& entry : opt_map) {
+			if (entry.second.type == o) {
+				opts.erase(o);
+				std::string copy(arg);
+				return parse_arg(entry.first, &copy[0]) == 0;
+			}
+		}
+		assert(!"Invalid option passed to set_arg!"); // programmer error
+		return false;
+	}
+
 	/**
 	 *	Argument parser function, mainly just maps the arguments to their type and sticks them in
 	 *	the map that the user has access to
@@ -124,9 +166,16 @@ namespace diskspd
 			// get the option from the opt_map
 			DiskspdOption& option = opt_map[key];
 
+			// some options can be given more than once; keep every argument
+			if (option.flags & OPT_REPEATABLE) {
+				opts[option.type] = key;
+				repeated_args[option.type].push_back(arg ? std::string(arg) : std::string());
+				return 0;
+			}
+
 			// check for duplicate args
 			if (opts.count(option.type)) {
-				fprintf(stderr, "Option -%c already specified!\n", (char)key);
+				fprintf(stderr, "Option %s already specified!\n", option_name(option).c_str());
 				return EINVAL;
 			}
 			// add to map of parsed options
@@ -137,14 +186,14 @@ namespace diskspd
 				option.arg = std::string(arg);
 
 				if ((option.flags & OPT_NUMERIC) && !is_numeric(arg)) {
-					fprintf(stderr, "Argument to option -%c was invalid!\n", (char)key);
+					fprintf(stderr, "Argument to option %s was invalid!\n", option_name(option).c_str());
 					return EINVAL;
 				} else if ((option.flags & OPT_BYTE_SIZE) && !valid_byte_size(arg)) {
-					fprintf(stderr, "Argument to option -%c was invalid!\n", (char)key);
+					fprintf(stderr, "Argument to option %s was invalid!\n", option_name(option).c_str());
 					return EINVAL;
 				} else if ((option.flags & OPT_NON_ZERO) &&
 						(arg[0] == '0' && (arg[1] < '1' || arg[1] > '9'))) {
-					fprintf(stderr, "Argument to option -%c was invalid!\n", (char)key);
+					fprintf(stderr, "Argument to option %s was invalid!\n", option_name(option).c_str());
 					return EINVAL;
 				} // else do nothing - it will have to be validated by profile.cc
 			}
@@ -159,6 +208,8 @@ namespace diskspd
 		return 0;
 	}
 
+	bool Options::exit_on_error = true;
+
 	/**
 	 *	Do the actual argument parsing with argparse
 	 */
@@ -194,7 +245,8 @@ namespace diskspd
 			return false;
 		}
 
-		if(argp_parse((const struct argp *)&the_argp, argc, argv, 0, NULL, (void *)this)) {
+		if(argp_parse((const struct argp *)&the_argp, argc, argv,
+					exit_on_error ? 0 : ARGP_NO_EXIT, NULL, (void *)this)) {
 			return false;
 		}
 
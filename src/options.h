@@ -35,7 +35,69 @@ namespace diskspd {
 		WRITE,
 		WARMUP_TIME,
 		RAND_SEED,
-		IO_BUFFERS
+		IO_BUFFERS,
+		REPLAY,
+		RANDOM_DIST,
+		SYNTHESIZE,
+		SCALE_RATE,
+		CHAIN,
+		LSM,
+		WAL,
+		STRIPE,
+		MIRROR,
+		ERASURE,
+		CACHE,
+		GROUP,
+		IDLE,
+		AGE,
+		WEIGHTS,
+		RATE,
+		QD_TARGET,
+		SWEEP,
+		RAMP,
+		STEADY,
+		PRECONDITION,
+		WORK,
+		SCAN,
+		PROFILE,
+		DAEMON,
+		CONNECT,
+		PROCESSES
+	};
+
+	/**
+	 *	Keys for options that only have a long name. argp treats printable keys as short options,
+	 *	so these start above the printable range
+	 */
+	enum LongOptionKey {
+		LONG_OPTION_BASE = 0x100,
+		KEY_REPLAY = LONG_OPTION_BASE,
+		KEY_RANDOM_DIST,
+		KEY_SYNTHESIZE,
+		KEY_SCALE_RATE,
+		KEY_CHAIN,
+		KEY_LSM,
+		KEY_WAL,
+		KEY_STRIPE,
+		KEY_MIRROR,
+		KEY_ERASURE,
+		KEY_CACHE,
+		KEY_GROUP,
+		KEY_IDLE,
+		KEY_AGE,
+		KEY_WEIGHTS,
+		KEY_RATE,
+		KEY_QD_TARGET,
+		KEY_SWEEP,
+		KEY_RAMP,
+		KEY_STEADY,
+		KEY_PRECONDITION,
+		KEY_WORK,
+		KEY_SCAN,
+		KEY_PROFILE,
+		KEY_DAEMON,
+		KEY_CONNECT,
+		KEY_PROCESSES
 	};
 
 	/**
@@ -51,16 +113,43 @@ namespace diskspd {
 			 */
 			bool parse_args(int argc, char ** argv);
 
+			/**
+			 *	Whether a parse error (or --help) ends the process, as argp does by default. A
+			 *	--daemon turns this off, so a bad request doesn't end it
+			 */
+			static bool exit_on_error;
+
 			/**
 			 *	Parse a single argument and add it to the map or vector
 			 */
 			error_t parse_arg(int key, char *arg);
 
+			/**
+			 *	Set an option's argument as if it had been given on the command line instead of
+			 *	any it was given there. Returns false if it's invalid
+			 */
+			bool set_arg(OptionType o, const std::string& arg);
+
 			/**
 			 *	Get an argument if it was parsed. return null if not
 			 */
 			inline const char * get_arg(OptionType o) { return opts.count(o) ? opt_map[opts[o]].arg.c_str() : nullptr; }
 
+			/**
+			 *	Get every argument of an option that can be given more than once, in order
+			 */
+			inline std::vector<std::string> get_args(OptionType o) { return repeated_args[o]; }
+
+			/**
+			 *	Every option that was given, including those that can be given more than once
+			 */
+			std::vector<OptionType> given() const;
+
+			/**
+			 *	Name of an option for error messages, i.e. "-x" or "--long-name"
+			 */
+			std::string option_name(OptionType o) const;
+
 			/**
 			 *	Get the vector of non-option arguments
 			 */
@@ -114,7 +203,7 @@ namespace diskspd {
 					assert(!"Invalid argument passed to arg_to_number!"); // programmer error
 				}
 				if (result > std::numeric_limits<T>::max()) {
-					fprintf(stderr, "Argument to -%c too large\n", (char)option.opt.key);
+					fprintf(stderr, "Argument to %s too large\n", option_name(option).c_str());
 					exit(1);
 				}
 				*ret = static_cast<T>(result);
@@ -123,9 +212,18 @@ namespace diskspd {
 			}
 
 		private:
+			struct DiskspdOption;
+
+			/**
+			 *	Name of an option for error messages, i.e. "-x" or "--long-name"
+			 */
+			static std::string option_name(const DiskspdOption& option);
+
 			// map of OptionType enum to the integer 'key' of the option in the opt_map
 			std::map<OptionType, int> opts;
 			std::vector<std::string> non_opts;
+			// arguments of OPT_REPEATABLE options
+			std::map<OptionType, std::vector<std::string>> repeated_args;
 
 			// diskspd usage string
 			const char * non_opt_doc = "FILE [FILE...]";
@@ -141,6 +239,7 @@ namespace diskspd {
 			const uint32_t OPT_NUMERIC		= 0x1;
 			const uint32_t OPT_BYTE_SIZE	= 0x2;
 			const uint32_t OPT_NON_ZERO		= 0x4;
+			const uint32_t OPT_REPEATABLE	= 0x8;
 
 			struct DiskspdOption {
 				OptionType type;		// enum describing which option this represents
@@ -248,7 +347,8 @@ namespace diskspd {
 								flags:0,
 								doc:
 									"Duration of measurement period in seconds, not including "
-									"cooldown or warmup time (default=10)\n",
+									"cooldown or warmup time (default=10). With --work, the "
+									"longest the measurement can take.\n",
 								group:0
 							}
 						}
@@ -330,8 +430,8 @@ namespace diskspd {
 								doc:
 									"Throughput per-thread per-target is throttled to the given "
 									"number of bytes, KiB(K), MiB(M), GiB(G) or blocks(b) per "
-									"millisecond. NOTE: this option has varying accuracy depending "
-									"on number of threads (-t/-F) and cpu usage.\n",
+									"millisecond. Ops are paced with a token bucket; see also "
+									"--rate.\n",
 								group:0
 							}
 						}
@@ -558,7 +658,8 @@ namespace diskspd {
 								flags:0,
 								doc:
 									"Duration in seconds to run the test before results start "
-									"being recorded (default = 5 seconds).\n",
+									"being recorded (default = 5 seconds). With --steady, the "
+									"longest the warm up can take.\n",
 								group:0
 							}
 						}
@@ -624,6 +725,725 @@ namespace diskspd {
 									group:0
 							}
 						}
+					},
+					{
+						KEY_REPLAY,
+						{
+							type: REPLAY,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"replay",
+								key:KEY_REPLAY,
+								arg:"TRACE_FILE",
+								flags:0,
+								doc:
+									"Replay an I/O trace recorded with libdiskspd_capture.so. "
+									"Each traced thread is replayed by a thread of its own, which "
+									"issues the traced ops no earlier than their traced times, "
+									"with at most -o ops in flight. The trace is looped until the "
+									"test ends. FILEs, if given, replace the traced paths in the "
+									"order they first appear in the trace; otherwise the traced "
+									"paths are used. Conflicts with -t and -F.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_RANDOM_DIST,
+						{
+							type: RANDOM_DIST,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"random-dist",
+								key:KEY_RANDOM_DIST,
+								arg:"IO%/TARGET%[,IO%/TARGET%...]",
+								flags:0,
+								doc:
+									"Skew the offsets of random I/O (-r). Each pair sends IO% of "
+									"the I/O to the next TARGET% of the target, starting at the "
+									"base offset. Both the IO% and TARGET% values must add up to "
+									"100, e.g. \"--random-dist=90/10,10/90\" sends 90% of the I/O "
+									"to the first 10% of the target.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_SYNTHESIZE,
+						{
+							type: SYNTHESIZE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"synthesize",
+								key:KEY_SYNTHESIZE,
+								arg:"TRACE_FILE",
+								flags:0,
+								doc:
+									"Fit a workload model to each path in a trace recorded with "
+									"libdiskspd_capture.so, print it along with an equivalent "
+									"diskspd command line, and exit without doing any I/O. FILEs, "
+									"if given, replace the traced paths in the command lines, "
+									"and -c sets the target size for them.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_SCALE_RATE,
+						{
+							type: SCALE_RATE,
+							flags: OPT_NUMERIC | OPT_NON_ZERO,
+							arg: "",
+							opt:
+							{
+								name:"scale-rate",
+								key:KEY_SCALE_RATE,
+								arg:"PERCENT",
+								flags:0,
+								doc:
+									"With --synthesize, scale the throughput and outstanding I/O "
+									"of the generated command lines to PERCENT of the traced "
+									"workload (default 100)\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_CHAIN,
+						{
+							type: CHAIN,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"chain",
+								key:KEY_CHAIN,
+								arg:"STEPS",
+								flags:0,
+								doc:
+									"Make each of the -o slots issue a chain of dependent ops, "
+									"starting each step only when the previous one has completed. "
+									"Steps are r (read at the next offset), w (write at the next "
+									"offset), R (read the previous op's offset again), W (write "
+									"back to the previous op's offset) and f (fsync), each "
+									"optionally followed by a repeat count. e.g. \"--chain=rWf\" "
+									"is a read-modify-write followed by an fsync, \"--chain=r4\" "
+									"is 4 dependent reads like a B-tree lookup. Reports the "
+									"chains completed and, with -L, their latency. Conflicts "
+									"with -w, -g and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_LSM,
+						{
+							type: LSM,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"lsm",
+								key:KEY_LSM,
+								arg:"SETTINGS",
+								flags:OPTION_ARG_OPTIONAL,
+								doc:
+									"Emulate an LSM tree in the target directory. A flush thread "
+									"writes new tables sequentially, a compaction thread merges "
+									"them within a bandwidth limit, and -t threads do point "
+									"lookups of -b bytes with -o outstanding. SETTINGS are comma "
+									"separated key=value pairs: table (flushed table size, default "
+									"64M), size (base data set, default 1G), flush (flush bytes per "
+									"second, default 16M), compact (compaction read+write bytes per "
+									"second, default 64M), fanin (tables merged per compaction, "
+									"default 4) and fp (bloom filter false positive percentage, "
+									"default 1). e.g. \"--lsm=table=16M,fp=5\". Conflicts with -c, "
+									"-F, -w, -g, --chain and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_WAL,
+						{
+							type: WAL,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"wal",
+								key:KEY_WAL,
+								arg:"MIN_SIZE-MAX_SIZE",
+								flags:OPTION_ARG_OPTIONAL,
+								doc:
+									"Write-ahead log with group commit. Each thread commits "
+									"records of random size (default 256-4K) to the target one at "
+									"a time; a leader thread writes all pending records at the "
+									"tail of the log in one write, then fdatasyncs. Reports commit "
+									"latency (with -L), commit throughput and records per batch. "
+									"Needs a single target. Conflicts with -r, -s, -w, -g, "
+									"--chain, --lsm and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_STRIPE,
+						{
+							type: STRIPE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"stripe",
+								key:KEY_STRIPE,
+								arg:"UNIT",
+								flags:0,
+								doc:
+									"Treat all the targets as one RAID0 stripe set with a stripe "
+									"unit of UNIT bytes. Each thread issues -o logical ops of -b "
+									"bytes on the stripe set (-r, -s, -T and -w apply to it), each "
+									"split into an op on every member it covers, and completing "
+									"when they all have. Every thread uses every target; -t gives "
+									"the total number of threads. Reports the stripe set as well "
+									"as each member. Conflicts with -g, --chain, --lsm, --wal and "
+									"--replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_MIRROR,
+						{
+							type: MIRROR,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"mirror",
+								key:KEY_MIRROR,
+								arg:"SETTINGS",
+								flags:OPTION_ARG_OPTIONAL,
+								doc:
+									"Treat all the targets as replicas of each other. Each thread "
+									"issues -o logical ops of -b bytes (-r, -s, -T and -w apply to "
+									"them). A write goes to every replica and completes when a "
+									"quorum has; a read goes to one replica, and if it's slower "
+									"than the hedge deadline, a hedge is sent to another and the "
+									"loser is cancelled. SETTINGS are comma separated key=value "
+									"pairs: quorum (replicas a write waits for, default all) and "
+									"hedge (the deadline as a percentile of recent first replica "
+									"read latency, e.g. 95 or 99.9; default no hedging). Every "
+									"thread uses every target; -t gives the total number of "
+									"threads. Reports the mirror and each replica, and what "
+									"hedging does to read latency. Conflicts with -g, --stripe, "
+									"--chain, --lsm, --wal and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_ERASURE,
+						{
+							type: ERASURE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"erasure",
+								key:KEY_ERASURE,
+								arg:"K+M[,SETTINGS]",
+								flags:0,
+								doc:
+									"Treat the targets (there must be K+M) as an erasure coded "
+									"set of K data and M parity members, using Reed-Solomon over "
+									"GF(2^8); with M=1 this is XOR parity. Each thread issues -o "
+									"logical ops, each covering one -b block on every member "
+									"(-r, -s, -T and -w apply to them). A write computes the "
+									"parity and writes all K+M blocks; a read reads K of them "
+									"and rebuilds the data blocks it didn't read. SETTINGS are "
+									"comma separated key=value pairs: simd (scalar, avx2 or "
+									"avx512; default the best this CPU has) and read (any: a "
+									"random K, the default; data: the data blocks, as with no "
+									"failures). Every thread uses every target; -t gives the "
+									"total number of threads. Reports the set and each member, "
+									"and CPU cycles per byte of encoding and decoding. "
+									"Conflicts with -g, -Zs, --stripe, --mirror, --chain, "
+									"--lsm, --wal and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_CACHE,
+						{
+							type: CACHE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"cache",
+								key:KEY_CACHE,
+								arg:"SIZE[,SETTINGS]",
+								flags:0,
+								doc:
+									"Put an emulated application buffer cache of SIZE bytes "
+									"(K|M|G|b) in front of the targets, shared by all threads. "
+									"A read whose pages are all cached completes from memory; "
+									"a miss is read from the target with O_DIRECT. Writes go "
+									"to the target and leave their pages cached. SETTINGS are "
+									"comma separated key=value pairs: policy (clock, lru or "
+									"2q; default clock) and page (the page size; default -b). "
+									"Reports the hit ratio and the latency of hits and misses; "
+									"the target results only count what reached the targets. "
+									"Combine with --random-dist to size a device for a cache. "
+									"Conflicts with --chain, --lsm, --wal, --stripe, --mirror, "
+									"--erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_GROUP,
+						{
+							type: GROUP,
+							flags: OPT_REPEATABLE,
+							arg: "",
+							opt:
+							{
+								name:"group",
+								key:KEY_GROUP,
+								arg:"\"OPTIONS TARGET...\"",
+								flags:0,
+								doc:
+									"Run another workload group at the same time as the one "
+									"on the command line, with its own threads and targets, "
+									"e.g. --group=\"-b1M -o32 -s -w100 bg1\". Can be given "
+									"more than once. OPTIONS are separated by spaces, and can "
+									"be -b, -B, -c, -f, -g, -o, -r, -s, -S, -t, -T, -w, -Z and "
+									"--random-dist; everything else is shared with the command "
+									"line. Each group gets its own results and latency "
+									"sections. Conflicts with -F, --cache, --chain, --lsm, "
+									"--wal, --stripe, --mirror, --erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_IDLE,
+						{
+							type: IDLE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"idle",
+								key:KEY_IDLE,
+								arg:"GAP[,SETTINGS]",
+								flags:0,
+								doc:
+									"Leave the targets idle now and then, to measure the "
+									"latency of the first I/O after an idle period (e.g. with "
+									"power management putting the device to sleep). Threads "
+									"drain all their I/O, wait GAP, and then issue probe ops "
+									"one at a time before going back to -o outstanding. "
+									"SETTINGS are comma separated key=value pairs: every (the "
+									"time between gaps; default 1s) and probes (ops after each "
+									"gap; default 1). Times are in ms, or seconds with an s "
+									"suffix. Probes are reported apart from the target "
+									"results. Conflicts with --chain, --lsm, --wal, --stripe, "
+									"--mirror, --erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_AGE,
+						{
+							type: AGE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"age",
+								key:KEY_AGE,
+								arg:"EXTENT_SIZE[,SETTINGS]",
+								flags:0,
+								doc:
+									"Age the targets after -c lays them out, until their "
+									"average extent is no bigger than EXTENT_SIZE (K|M). Each "
+									"round deletes a target, fills the free space with filler "
+									"files in interleaved pieces, punches holes in some and "
+									"deletes the rest, then rewrites the target in pieces "
+									"between appends to the fillers. SETTINGS are comma separated "
+									"key=value pairs: rounds (default 8), files (fillers per "
+									"round; default 16), fill (percent of the free space "
+									"filled per round; default 90) and keep (percent of "
+									"fillers kept with holes; default 90). Writes most of the "
+									"filesystem's free space every round. Reports FIEMAP "
+									"extent counts before and after. Needs -c and regular "
+									"files; conflicts with --lsm.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_WEIGHTS,
+						{
+							type: WEIGHTS,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"weights",
+								key:KEY_WEIGHTS,
+								arg:"WEIGHT[:MAX],...",
+								flags:0,
+								doc:
+									"With -F, give each target (in order) a weight, and "
+									"optionally a cap of MAX outstanding ops per thread. Each "
+									"thread then has -o outstanding ops in all, rather than -o "
+									"per target, and sends each new op to a target picked in "
+									"proportion to the weights among those under their cap, "
+									"e.g. --weights=8,1,1:2. Conflicts with --cache, --chain, "
+									"--lsm, --wal, --stripe, --mirror, --erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_RATE,
+						{
+							type: RATE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"rate",
+								key:KEY_RATE,
+								arg:"SCOPE:LIMIT,...",
+								flags:0,
+								doc:
+									"Pace ops with token buckets. SCOPE is target (each "
+									"target, across all threads), thread (each thread) or job "
+									"(the whole Job). LIMIT is N iops, e.g. 5000iops, or bytes "
+									"per second (K|M|G), e.g. 100M. A scope can have both, "
+									"e.g. --rate=job:20000iops,job:200M,target:5000iops. Up to "
+									"1ms of tokens can build up; an op waits for all of the "
+									"buckets it's in. Conflicts with --chain, --lsm, --wal, "
+									"--stripe, --mirror, --erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_QD_TARGET,
+						{
+							type: QD_TARGET,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"qd-target",
+								key:KEY_QD_TARGET,
+								arg:"LATENCY[,SETTINGS]",
+								flags:0,
+								doc:
+									"Find the largest queue depth that keeps the latency "
+									"percentile under LATENCY ms (fractions allowed), e.g. "
+									"--qd-target=2 for a 2ms 99th percentile. Each thread keeps "
+									"between 1 and its -o ops outstanding, starting at 1 and "
+									"doubling every window until one goes over the target, then "
+									"adding one op for every window under it and cutting back "
+									"for every window over it. SETTINGS are comma separated "
+									"key=value pairs: pct (the percentile; default 99), window "
+									"(ms; default 100) and decrease (the factor the queue depth "
+									"is cut by; default 0.5). Reports the queue depth each "
+									"thread converged on. Conflicts with --idle, --chain, --lsm, "
+									"--wal, --stripe, --mirror, --erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_SWEEP,
+						{
+							type: SWEEP,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"sweep",
+								key:KEY_SWEEP,
+								arg:"SETTINGS",
+								flags:0,
+								doc:
+									"Run the job once for every combination of the given "
+									"values of -b, -o, -t (or -F, if it was used) and -w, "
+									"laying the targets out only once, and print one table "
+									"with a row per combination. SETTINGS are comma separated "
+									"key=value pairs: b, o, t and w (lists of values separated "
+									"by slashes, e.g. b=4K/64K,o=1/8/32,w=0/30), settle (ms of "
+									"idle between points; default 500) and csv (a file to "
+									"write the table to as CSV). Lists for scheduler, "
+									"nr_requests, read_ahead_kb, rq_affinity and nomerges "
+									"(e.g. scheduler=none/mq-deadline/kyber/bfq) change those "
+									"/sys/block/DEV/queue settings of the targets' devices "
+									"for each point, which needs root, and put them back "
+									"afterwards. Each point has its own -W warm up. Conflicts "
+									"with --replay and --age.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_RAMP,
+						{
+							type: RAMP,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"ramp",
+								key:KEY_RAMP,
+								arg:"SECONDS[,SETTINGS]",
+								flags:0,
+								doc:
+									"Ramp the thread count up during the run: only the first "
+									"threads do I/O at first, and every SECONDS more of them "
+									"start, in thread id order, until all of them have. Each "
+									"step's throughput, latency and CPU usage is reported "
+									"apart. SETTINGS are comma separated key=value pairs: "
+									"start (threads in the first step, which is also the "
+									"warm up; default 1) and step (threads added per step; "
+									"default 1). The duration is a step per thread count, so "
+									"-d is ignored. Conflicts with --idle, --chain, --lsm, "
+									"--wal, --stripe, --mirror, --erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_STEADY,
+						{
+							type: STEADY,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"steady",
+								key:KEY_STEADY,
+								arg:"SETTINGS",
+								flags:OPTION_ARG_OPTIONAL,
+								doc:
+									"End the warm up at steady state rather than after -W, "
+									"which becomes the longest it can take. The warm up is cut "
+									"into windows, and it's steady once, over the last few, "
+									"the throughput's coefficient of variation and the change "
+									"along its trend line are under their limits (and with -L, "
+									"so is the 99th percentile's coefficient of variation). "
+									"SETTINGS are comma separated key=value pairs: window (ms; "
+									"default 1000), windows (default 5), cv (percent; default "
+									"5), slope (percent over the windows; default 10) and "
+									"latency (the 99th percentile's cv in percent; default "
+									"10). Each warm up window is reported. Conflicts with "
+									"--ramp, --chain, --lsm, --wal, --stripe, --mirror, "
+									"--erasure and --replay.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_PRECONDITION,
+						{
+							type: PRECONDITION,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"precondition",
+								key:KEY_PRECONDITION,
+								arg:"SETTINGS",
+								flags:OPTION_ARG_OPTIONAL,
+								doc:
+									"Precondition the targets before the test, as the SNIA "
+									"Solid State Storage Performance Test Specification does: "
+									"write each target's whole range sequentially, then in "
+									"rounds of random writes until the IOPS are steady, "
+									"reporting every round. The writes are O_DIRECT, of random "
+									"data, on kernel aio. SETTINGS are comma separated "
+									"key=value pairs: passes (sequential passes; default 2), "
+									"seq (their block size; default 128K), block (the random "
+									"block size; default 4K), qd (writes in flight; default "
+									"32), round (seconds per round; default 60), rounds (the "
+									"most rounds; default 25), window (rounds that have to be "
+									"steady; default 5), range (percent of the average the "
+									"rounds can span; default 20) and slope (percent of the "
+									"average their trend line can move; default 10). This "
+									"overwrites everything on the targets.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_WORK,
+						{
+							type: WORK,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"work",
+								key:KEY_WORK,
+								arg:"WORK",
+								flags:0,
+								doc:
+									"End the test once a fixed amount of work is done rather "
+									"than after -d, which becomes the longest it can take, and "
+									"report how long it took. WORK is ops=N, bytes=SIZE or "
+									"pass (the bytes from -B to -f or the end of the target), "
+									"then optionally per=thread (the default; each thread "
+									"does that much across its targets) or per=target (each "
+									"target gets that much from all of its threads; use -si "
+									"for a single pass). Work starts being counted after the "
+									"warm up. Conflicts with --replay, --chain, --lsm, --wal, "
+									"--stripe, --mirror, --erasure, --cache, --weights, "
+									"--idle, --qd-target and --ramp.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_SCAN,
+						{
+							type: SCAN,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"scan",
+								key:KEY_SCAN,
+								arg:"SETTINGS",
+								flags:OPTION_ARG_OPTIONAL,
+								doc:
+									"Scan every block of every target once, in parallel, and "
+									"report how long it took; -d becomes the longest it can "
+									"take. The targets are cut into chunks (chunk=SIZE; "
+									"default 1M), and each thread starts with an even share "
+									"of them; a thread that runs out steals chunks from the "
+									"one with the most left, so no thread sits idle while "
+									"there's scanning to do. Each thread has -o ops in flight "
+									"on its current chunk, read or written as -w says. Needs "
+									"-F, has no warm up, and conflicts with -r, -si, -T, "
+									"--random-dist and the other workload options.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_PROFILE,
+						{
+							type: PROFILE,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"profile",
+								key:KEY_PROFILE,
+								arg:"FILE",
+								flags:0,
+								doc:
+									"Run the Jobs in a JSON profile, one after the other, "
+									"instead of one from the command line; no other options "
+									"or targets can be given. The profile is "
+									"{\"jobs\": [JOB, ...]}, where a JOB is an object of "
+									"options named without their dashes (\"b\": \"4K\", "
+									"\"block-size\": \"4K\", \"L\": true) and a \"targets\" "
+									"array of objects, each with a \"path\" and any of the "
+									"per-target options allowed in --group; those given for "
+									"the Job are the defaults for its targets. A target laid "
+									"out by an earlier Job isn't created again.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_DAEMON,
+						{
+							type: DAEMON,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"daemon",
+								key:KEY_DAEMON,
+								arg:"SOCKET",
+								flags:0,
+								doc:
+									"Keep running, serving runs requested over a UNIX domain "
+									"socket at SOCKET one at a time, instead of doing one; no "
+									"other options or targets can be given. A request is a "
+									"line of diskspd's arguments, split on spaces; the run's "
+									"output is streamed back, followed by a NUL byte and its "
+									"exit status. The system info is only read once, and I/O "
+									"buffers are kept for the next run that has the same size "
+									"of them. Use --connect to make requests.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_CONNECT,
+						{
+							type: CONNECT,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"connect",
+								key:KEY_CONNECT,
+								arg:"SOCKET",
+								flags:0,
+								doc:
+									"Have the --daemon listening at SOCKET do this run, with "
+									"the rest of the command line, printing its output and "
+									"exiting with its status.\n",
+								group:0
+							}
+						}
+					},
+					{
+						KEY_PROCESSES,
+						{
+							type: PROCESSES,
+							flags: 0,
+							arg: "",
+							opt:
+							{
+								name:"processes",
+								key:KEY_PROCESSES,
+								arg:nullptr,
+								flags:0,
+								doc:
+									"Run each thread in a worker process of its own rather "
+									"than as a thread of diskspd's, so they don't share an "
+									"address space (and its locks, such as the one taken to "
+									"pin pages for O_DIRECT). Workers are started, stopped "
+									"and report their results through shared memory. "
+									"Conflicts with -si, --rate and the workload options "
+									"whose threads share state (--replay, --chain, --lsm, "
+									"--wal, --stripe, --mirror, --erasure, --cache, "
+									"--weights, --idle, --qd-target, --ramp, --steady, "
+									"--work and --scan).\n",
+								group:0
+							}
+						}
 					}
 			};
 	};
@@ -70,6 +70,14 @@ namespace diskspd {
 				return get_time_ns()/1000000;
 			}
 
+			/**
+			 *	Sleep until abs time t_ns, as returned by get_time_ns
+			 */
+			static inline void sleep_until_ns(uint64_t t_ns) {
+				timespec t = { (time_t)(t_ns/1000000000), (long)(t_ns%1000000000) };
+				clock_nanosleep(get_clock(), TIMER_ABSTIME, &t, nullptr);
+			}
+
 		private:
 			PerfClock(){}
 			~PerfClock(){}
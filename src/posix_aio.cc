@@ -12,6 +12,8 @@
 #include <aio.h>
 #include <assert.h>
 #include <unistd.h>
+#include <errno.h>
+#include <time.h>
 
 #include "debug.h"
 #include "target.h"
@@ -42,6 +44,7 @@ namespace diskspd {
 
 				this->read_buf = read_buf;
 				this->write_buf = write_buf;
+				time = time_stamp;
 
 				memset(&cb, 0, sizeof(cb));
 				type = t;
@@ -222,7 +225,7 @@ namespace diskspd {
 				return 0;
 			}
 
-			std::shared_ptr<IAsyncIop> wait(int group_id) {
+			std::shared_ptr<IAsyncIop> wait(int group_id, const timespec * timeout) {
 				if (!started) assert(!"IOManager not started!");
 
 				// suspending
@@ -230,8 +233,11 @@ namespace diskspd {
 				auto vec = suspend_vecs[group_id];
 				suspend_mutex.unlock();
 
-				int err = aio_suspend((const aiocb * const *)&((*vec)[0]), (int)vec->size(), NULL);
+				int err = aio_suspend((const aiocb * const *)&((*vec)[0]), (int)vec->size(), timeout);
 
+				if (err && errno == EAGAIN && timeout) {
+					return nullptr;
+				}
 				if (err) {
 					perror("IOManager error! aio_suspend");
 					exit(1);
@@ -262,6 +268,14 @@ namespace diskspd {
 				exit(1);
 			}
 
+			int cancel(std::shared_ptr<IAsyncIop> ia) {
+				if (!started) assert(!"IOManager not started!");
+
+				// glibc's aio_cancel can leave the requests queued behind a cancelled one on the
+				// same file stranded, so requests here always run to completion
+				return ENOTSUP;
+			}
+
 		private:
 
 			bool started = false;
@@ -311,6 +325,15 @@ namespace diskspd {
 	}
 
 	std::shared_ptr<IAsyncIop> PosixSuspendAsyncIOManager::wait(int group_id) {
-		return p->wait(group_id);
+		return p->wait(group_id, nullptr);
+	}
+
+	std::shared_ptr<IAsyncIop> PosixSuspendAsyncIOManager::wait(int group_id, uint64_t timeout_us) {
+		timespec timeout = { (time_t)(timeout_us/1000000), (long)(timeout_us%1000000)*1000 };
+		return p->wait(group_id, &timeout);
+	}
+
+	int PosixSuspendAsyncIOManager::cancel(std::shared_ptr<IAsyncIop> a) {
+		return p->cancel(a);
 	}
 } // namespace diskspd
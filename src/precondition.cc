@@ -0,0 +1,249 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "debug.h"
+#include "options.h"
+#include "target.h"
+#include "perf_clock.h"
+#include "kernel_aio.h"
+#include "precondition.h"
+
+namespace diskspd {
+
+	bool Precondition::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t pos = 0;
+		while (pos < settings.size()) {
+			size_t end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --precondition setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+			int number = Options::is_numeric(value.c_str()) ? atoi(value.c_str()) : -1;
+			bool size = (key == "seq" || key == "block") && Options::valid_byte_size(value.c_str()) &&
+				value.back() != 'b';
+
+			if (key == "passes" && number >= 0) {
+				passes = number;
+			} else if (key == "seq" && size) {
+				seq_size = Options::byte_size_from_arg(value.c_str(), 0);
+			} else if (key == "block" && size) {
+				block_size = Options::byte_size_from_arg(value.c_str(), 0);
+			} else if (key == "qd" && number > 0) {
+				qd = number;
+			} else if (key == "round" && number > 0) {
+				round_s = number;
+			} else if (key == "rounds" && number >= 0) {
+				rounds = number;
+			} else if (key == "window" && number >= 2) {
+				window = number;
+			} else if (key == "range" && number > 0) {
+				range = number;
+			} else if (key == "slope" && number > 0) {
+				slope = number;
+			} else {
+				fprintf(stderr, "Invalid --precondition setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+
+		// the writes are O_DIRECT
+		if (!seq_size || seq_size % 512 || !block_size || block_size % 512) {
+			fprintf(stderr, "--precondition block sizes must be multiples of 512 bytes\n");
+			return false;
+		}
+		return true;
+	}
+
+	bool Precondition::steady(const std::vector<double>& round_iops) const {
+		if (round_iops.size() < window) {
+			return false;
+		}
+		auto first = round_iops.end() - window;
+		double mean = 0;
+		for (auto it = first; it != round_iops.end(); ++it) mean += *it;
+		mean /= window;
+		if (mean <= 0) {
+			return false;
+		}
+
+		// the data excursion: the highest round to the lowest
+		auto minmax = std::minmax_element(first, round_iops.end());
+		if ((*minmax.second - *minmax.first)*100 > range*mean) {
+			return false;
+		}
+
+		// the slope excursion: where the trend line starts to where it ends
+		double x_mean = (window - 1)/2.0;
+		double sxy = 0;
+		double sxx = 0;
+		for (unsigned int x = 0; x < window; ++x) {
+			sxy += (x - x_mean)*(first[x] - mean);
+			sxx += (x - x_mean)*(x - x_mean);
+		}
+		return fabs(sxy/sxx)*(window - 1)*100 <= slope*mean;
+	}
+
+	/**
+	 *	Keep up to qd writes of buf in flight on fd, at the offsets next() gives, until it
+	 *	gives -1 or deadline_ns passes. Counts the writes that completed in ops. Every write
+	 *	is waited for, even after one fails
+	 */
+	static bool write_all(int fd, char * buf, size_t nbytes, off_t end, unsigned int qd,
+			const std::function<off_t()>& next, uint64_t deadline_ns, uint64_t& ops) {
+
+		KernelAsyncIOManager io_manager;
+		if (!io_manager.start(qd) || !io_manager.create_group(0, qd)) {
+			fprintf(stderr, "--precondition failed to start its io engine\n");
+			return false;
+		}
+
+		// the last write of a sequential pass can be short
+		auto issue = [&](std::shared_ptr<IAsyncIop> op, off_t offset) {
+			op->set_offset(offset);
+			op->set_nbytes(std::min((off_t)nbytes, end - offset));
+			return !io_manager.enqueue(op);
+		};
+
+		bool ok = true;
+		unsigned int in_flight = 0;
+		for (unsigned int i = 0; i < qd; ++i) {
+			off_t offset = next();
+			if (offset < 0) break;
+			auto op = io_manager.construct(IAsyncIop::WRITE, fd, offset, nullptr, buf, nbytes, 0,
+					nullptr, 0);
+			if (!issue(op, offset)) {
+				perror("--precondition failed to queue a write");
+				ok = false;
+				break;
+			}
+			++in_flight;
+		}
+		if (in_flight && io_manager.submit(0)) {
+			perror("--precondition failed to submit writes");
+			return false;
+		}
+
+		while (in_flight) {
+			std::shared_ptr<IAsyncIop> op = io_manager.wait(0);
+			--in_flight;
+			if (op->get_ret() != (int)op->get_nbytes()) {
+				if (ok) {
+					errno = op->get_errno();
+					perror("--precondition write failed");
+				}
+				ok = false;
+				continue;
+			}
+			++ops;
+
+			off_t offset;
+			if (!ok || PerfClock::get_time_ns() >= deadline_ns || (offset = next()) < 0) {
+				continue;
+			}
+			if (!issue(op, offset) || io_manager.submit(0)) {
+				perror("--precondition failed to submit a write");
+				ok = false;
+				continue;
+			}
+			++in_flight;
+		}
+		return ok;
+	}
+
+	bool Precondition::precondition(const Target& target, uint64_t seed) {
+
+		Result& result = results[&target];
+		off_t begin = target.base_offset;
+		off_t end = target.max_size;
+		if (end - begin < (off_t)std::max(seq_size, block_size)) {
+			fprintf(stderr, "--precondition needs targets bigger than its block sizes\n");
+			return false;
+		}
+
+		int fd = open(target.path.c_str(), O_WRONLY | O_DIRECT);
+		if (fd == -1) {
+			fprintf(stderr, "--precondition failed to open %s with O_DIRECT\n", target.path.c_str());
+#ifdef ENABLE_DEBUG
+			perror("open failed");
+#endif
+			return false;
+		}
+
+		// random data, so compression and deduplication don't make the device's job easier
+		size_t buf_size = std::max(seq_size, block_size);
+		char * buf = nullptr;
+		if (posix_memalign((void **)&buf, 4096, buf_size)) {
+			perror("--precondition failed to allocate a buffer");
+			close(fd);
+			return false;
+		}
+		std::mt19937_64 rng(seed);
+		for (size_t i = 0; i < buf_size; i += sizeof(uint64_t)) {
+			uint64_t r = rng();
+			memcpy(buf + i, &r, std::min(sizeof(r), buf_size - i));
+		}
+
+		bool ok = true;
+		for (unsigned int pass = 0; pass < passes && ok; ++pass) {
+			v_printf("	Preconditioning \"%s\", sequential pass %u\n", target.path.c_str(), pass + 1);
+			off_t offset = begin;
+			auto next = [&]() -> off_t {
+				if (offset >= end) return -1;
+				off_t o = offset;
+				offset += seq_size;
+				return o;
+			};
+			uint64_t ops = 0;
+			uint64_t start_ns = PerfClock::get_time_ns();
+			ok = write_all(fd, buf, seq_size, end, qd, next, std::numeric_limits<uint64_t>::max(), ops);
+			result.pass_ms.push_back((PerfClock::get_time_ns() - start_ns)/1000000);
+		}
+
+		// random writes aligned to their size, anywhere in the range
+		std::uniform_int_distribution<off_t> block_dist(0, (end - begin)/block_size - 1);
+		auto next = [&]() -> off_t {
+			return begin + block_dist(rng)*block_size;
+		};
+		while (ok && result.round_iops.size() < rounds && !result.reached) {
+			uint64_t ops = 0;
+			uint64_t start_ns = PerfClock::get_time_ns();
+			ok = write_all(fd, buf, block_size, end, qd, next, start_ns + (uint64_t)round_s*1000000000, ops);
+			double seconds = (double)(PerfClock::get_time_ns() - start_ns)/1000000000;
+			result.round_iops.push_back(ops/seconds);
+			result.reached = steady(result.round_iops);
+			v_printf("	Preconditioning \"%s\", round %lu: %.0lf IOPS\n", target.path.c_str(),
+					result.round_iops.size(), result.round_iops.back());
+		}
+
+		free(buf);
+		close(fd);
+		return ok;
+	}
+
+} // namespace diskspd
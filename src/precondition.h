@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+#ifndef DISKSPD_PRECONDITION_H
+#define DISKSPD_PRECONDITION_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	Preconditions the targets before the Job runs (--precondition), the way the SNIA Solid
+	 *	State Storage Performance Test Specification does: 'passes' sequential writes of the
+	 *	target's whole range in seq_size blocks, then rounds of round_s seconds of random
+	 *	block_size writes until steady state, or until 'rounds' rounds have run. Steady state
+	 *	is when, over the last 'window' rounds, the IOPS stay within range percent of their
+	 *	average, and their least squares trend line moves less than slope percent of it.
+	 *
+	 *	Writes are O_DIRECT, of random data, with qd of them in flight on a kernel aio manager
+	 *	of its own, whatever the Job's engine is
+	 */
+	struct Precondition {
+		unsigned int passes			= 2;			// passes=
+		size_t seq_size				= 128*1024;		// seq=
+		size_t block_size			= 4096;			// block=
+		unsigned int qd				= 32;			// qd=
+		unsigned int round_s		= 60;			// round=
+		unsigned int rounds			= 25;			// rounds=; the most rounds per target
+		unsigned int window			= 5;			// window=
+		double range				= 20;			// range=
+		double slope				= 10;			// slope=
+
+		struct Result {
+			std::vector<uint64_t> pass_ms;
+			std::vector<double> round_iops;
+			bool reached			= false;
+		};
+		std::map<const Target *, Result> results;
+
+		/**
+		 *	Parse a --precondition argument: comma separated key=value settings, named as
+		 *	above, or nothing for the defaults
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	Precondition a target. seed seeds the data and the random offsets
+		 */
+		bool precondition(const Target& target, uint64_t seed);
+
+		/**
+		 *	Whether the last 'window' rounds of round_iops are steady
+		 */
+		bool steady(const std::vector<double>& round_iops) const;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_PRECONDITION_H
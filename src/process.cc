@@ -0,0 +1,381 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "process.h"
+
+namespace diskspd {
+
+	static bool write_all(int fd, const char * buf, size_t len) {
+		while (len) {
+			ssize_t n = write(fd, buf, len);
+			if (n == -1 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			buf += n;
+			len -= n;
+		}
+		return true;
+	}
+
+	/*
+	 *	A worker's results are its ThreadResults' TargetResults in order, each as its counts,
+	 *	then its histograms as value/count pairs, then its bucketizers' buckets, all as
+	 *	uint64_ts preceded by how many there are where that varies
+	 */
+
+	static void put(std::string& out, uint64_t value) {
+		out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+
+	static void put_histogram(std::string& out, const Histogram<uint64_t>& histogram) {
+		std::map<uint64_t, unsigned> data = histogram.GetSortedData();
+		put(out, data.size());
+		for (auto& bucket : data) {
+			put(out, bucket.first);
+			put(out, bucket.second);
+		}
+	}
+
+	static void put_bucketizer(std::string& out, const IoBucketizer& bucketizer) {
+		put(out, bucketizer.GetNumberOfBuckets());
+		for (size_t i = 0; i < bucketizer.GetNumberOfBuckets(); ++i) {
+			put(out, bucketizer.GetIoBucket(i));
+		}
+	}
+
+	/**
+	 *	Reads back what put() wrote; once it's read past the end, every value is 0 and ok is
+	 *	false
+	 */
+	struct ResultsReader {
+		const char * pos;
+		const char * end;
+		bool ok;
+
+		uint64_t get() {
+			uint64_t value = 0;
+			if (end - pos < (ptrdiff_t)sizeof(value)) {
+				ok = false;
+				return 0;
+			}
+			memcpy(&value, pos, sizeof(value));
+			pos += sizeof(value);
+			return value;
+		}
+
+		void get_histogram(Histogram<uint64_t>& histogram) {
+			for (uint64_t n = get(); n && ok; --n) {
+				uint64_t value = get();
+				histogram.Add(value, (unsigned)get());
+			}
+		}
+
+		void get_bucketizer(IoBucketizer& bucketizer, uint64_t bucket_duration) {
+			uint64_t n = get();
+			for (uint64_t i = 0; i < n && ok; ++i) {
+				uint64_t count = get();
+				if (count && bucket_duration) {
+					bucketizer.Add(i*bucket_duration, (unsigned int)count);
+				}
+			}
+		}
+	};
+
+	static std::string serialize_results(const ThreadResults& results) {
+		std::string out;
+		for (auto& t_results : results.target_results) {
+			put(out, t_results->bytes_count);
+			put(out, t_results->read_bytes_count);
+			put(out, t_results->write_bytes_count);
+			put(out, t_results->iops_count);
+			put(out, t_results->read_iops_count);
+			put(out, t_results->write_iops_count);
+			put(out, t_results->chain_count);
+			put_histogram(out, t_results->read_latency_histogram);
+			put_histogram(out, t_results->write_latency_histogram);
+			put_histogram(out, t_results->chain_latency_histogram);
+			put_bucketizer(out, t_results->read_bucketizer);
+			put_bucketizer(out, t_results->write_bucketizer);
+		}
+		return out;
+	}
+
+	/**
+	 *	Fill in a thread's results from what its worker wrote to fd
+	 */
+	static bool read_results(ThreadParams& thread, int fd) {
+
+		struct stat buf;
+		if (fstat(fd, &buf) || !buf.st_size) {
+			return false;
+		}
+		void * data = mmap(nullptr, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (data == MAP_FAILED) {
+			perror("mmap worker results");
+			return false;
+		}
+		ResultsReader reader = { static_cast<const char *>(data),
+			static_cast<const char *>(data) + buf.st_size, true };
+
+		// the bucketizers are set up as thread_setup() does in the worker
+		const JobOptions& options = *thread.job_options;
+		uint64_t bucket_duration = 0;
+		if (options.measure_iops_std_dev) {
+			bucket_duration = (uint64_t)options.io_bucket_duration_ms;
+		}
+
+		for (auto& t_results : thread.results->target_results) {
+			if (bucket_duration) {
+				size_t valid_buckets =
+					(size_t)std::ceil((double)(options.duration * 1000) / (double)bucket_duration);
+				t_results->read_bucketizer.Initialize(bucket_duration, valid_buckets);
+				t_results->write_bucketizer.Initialize(bucket_duration, valid_buckets);
+			}
+			t_results->bytes_count			= reader.get();
+			t_results->read_bytes_count		= reader.get();
+			t_results->write_bytes_count	= reader.get();
+			t_results->iops_count			= reader.get();
+			t_results->read_iops_count		= reader.get();
+			t_results->write_iops_count		= reader.get();
+			t_results->chain_count			= reader.get();
+			reader.get_histogram(t_results->read_latency_histogram);
+			reader.get_histogram(t_results->write_latency_histogram);
+			reader.get_histogram(t_results->chain_latency_histogram);
+			reader.get_bucketizer(t_results->read_bucketizer, bucket_duration);
+			reader.get_bucketizer(t_results->write_bucketizer, bucket_duration);
+		}
+
+		munmap(data, buf.st_size);
+		return reader.ok && reader.pos == reader.end;
+	}
+
+	ProcessWorkers::~ProcessWorkers() {
+		reap();
+		for (auto& worker : workers) {
+			close(worker.event_fd);
+			close(worker.results_fd);
+		}
+		if (control) {
+			munmap(control, sizeof(Control));
+		}
+	}
+
+	bool ProcessWorkers::create() {
+		void * block = mmap(nullptr, sizeof(Control), PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (block == MAP_FAILED) {
+			perror("Couldn't map the worker control block");
+			return false;
+		}
+		control = static_cast<Control *>(block);
+		control->run_threads = true;
+		control->record_results = false;
+		control->thread_error = false;
+		control->start_time_us = 0;
+		return true;
+	}
+
+	bool ProcessWorkers::start(const std::shared_ptr<ThreadParams>& thread, int cpu) {
+
+		int events[2];
+		if (pipe2(events, O_CLOEXEC)) {
+			perror("Couldn't create a worker pipe");
+			return false;
+		}
+		int results_fd = memfd_create("diskspd-worker", MFD_CLOEXEC);
+		if (results_fd == -1) {
+			perror("Couldn't create worker results");
+			close(events[0]);
+			close(events[1]);
+			return false;
+		}
+
+		// or the worker would print what's buffered again
+		fflush(stdout);
+		fflush(stderr);
+
+		pid_t parent = getpid();
+		pid_t pid = fork();
+		if (pid == -1) {
+			perror("Couldn't fork a worker");
+			close(events[0]);
+			close(events[1]);
+			close(results_fd);
+			return false;
+		}
+
+		if (!pid) {
+			// the worker; it goes when the Job's process does, however that ends
+			prctl(PR_SET_PDEATHSIG, SIGKILL);
+			if (getppid() != parent) {
+				_exit(1);
+			}
+			close(events[0]);
+
+			if (cpu != -1) {
+				cpu_set_t * cpu_set = CPU_ALLOC(cpu + 1);
+				size_t cpu_set_size = CPU_ALLOC_SIZE(cpu + 1);
+				CPU_ZERO_S(cpu_set_size, cpu_set);
+				CPU_SET_S(cpu, cpu_set_size, cpu_set);
+				if (sched_setaffinity(0, cpu_set_size, cpu_set)) {
+					perror("Couldn't affinitize worker");
+					send(events[1], ABORTED);
+					_exit(1);
+				}
+				CPU_FREE(cpu_set);
+			}
+
+			thread->run_threads = &control->run_threads;
+			thread->record_results = &control->record_results;
+			thread->thread_error = &control->thread_error;
+			thread->start_time_us = &control->start_time_us;
+			thread->event_fd = events[1];
+			thread->thread_func();
+
+			std::string results = serialize_results(*thread->results);
+			bool reported = write_all(results_fd, results.data(), results.size());
+			if (reported) {
+				send(events[1], DONE);
+			}
+			fflush(stdout);
+			fflush(stderr);
+			_exit(reported ? 0 : 1);
+		}
+
+		close(events[1]);
+		workers.push_back({ thread, pid, events[0], results_fd, false });
+		return true;
+	}
+
+	void ProcessWorkers::listen() {
+		listener = std::thread(&ProcessWorkers::relay, this);
+	}
+
+	void ProcessWorkers::start_recording(uint64_t start_time_us) {
+		control->start_time_us = start_time_us;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		control->record_results = true;
+	}
+
+	void ProcessWorkers::stop_recording() {
+		control->record_results = false;
+	}
+
+	bool ProcessWorkers::finish() {
+		reap();
+		bool reported = true;
+		for (auto& worker : workers) {
+			if (!worker.exited) {
+				fprintf(stderr, "The worker for thread %u died\n", worker.thread->thread_id);
+				reported = false;
+			} else if (!read_results(*worker.thread, worker.results_fd)) {
+				fprintf(stderr, "The worker for thread %u didn't report its results\n",
+						worker.thread->thread_id);
+				reported = false;
+			}
+		}
+		return reported;
+	}
+
+	void ProcessWorkers::send(int fd, Event event) {
+		char byte = event;
+		write_all(fd, &byte, 1);
+	}
+
+	void ProcessWorkers::relay() {
+
+		std::vector<struct pollfd> fds;
+		for (auto& worker : workers) {
+			fds.push_back({ worker.event_fd, POLLIN, 0 });
+		}
+		std::vector<bool> done(workers.size(), false);
+
+		size_t open = fds.size();
+		while (open) {
+			if (poll(fds.data(), fds.size(), -1) == -1) {
+				if (errno == EINTR) continue;
+				perror("poll workers");
+				abort();
+				return;
+			}
+			for (size_t i = 0; i < fds.size(); ++i) {
+				if (!fds[i].revents) continue;
+
+				char events[64];
+				ssize_t n = read(fds[i].fd, events, sizeof(events));
+				if (n == -1 && errno == EINTR) continue;
+				if (n <= 0) {
+					// the worker's end is closed, so it's exited; if it wasn't done, it died
+					if (!done[i]) {
+						abort();
+					}
+					fds[i].fd = -1;
+					--open;
+					continue;
+				}
+
+				for (ssize_t e = 0; e < n; ++e) {
+					if (events[e] == INITIALIZED) {
+						// as the thread's signal_initialized() would have
+						std::unique_lock<std::mutex> thread_lock(job.thread_mutex);
+						job.thread_counter++;
+						thread_lock.unlock();
+						job.thread_cv.notify_one();
+					} else if (events[e] == ABORTED) {
+						abort();
+					} else if (events[e] == DONE) {
+						done[i] = true;
+					}
+				}
+			}
+		}
+	}
+
+	void ProcessWorkers::abort() {
+		// as the thread's thread_abort() would have
+		control->run_threads = false;
+		control->thread_error = true;
+		*run_threads = false;
+		*thread_error = true;
+		job.thread_error_cv.notify_one();
+	}
+
+	void ProcessWorkers::reap() {
+		if (control) {
+			control->run_threads = false;
+		}
+		for (auto& worker : workers) {
+			if (worker.pid <= 0) continue;
+			int status = 0;
+			while (waitpid(worker.pid, &status, 0) == -1 && errno == EINTR);
+			worker.exited = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+			worker.pid = 0;
+		}
+		if (listener.joinable()) {
+			listener.join();
+		}
+	}
+
+} // namespace diskspd
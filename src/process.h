@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <sys/types.h>
+
+#ifndef DISKSPD_PROCESS_H
+#define DISKSPD_PROCESS_H
+
+namespace diskspd {
+
+	class Job;
+	struct ThreadParams;
+
+	/**
+	 *	Worker processes for a Job's threads (--processes). Each thread's thread_func() runs in a
+	 *	process forked for it, so every worker has an address space of its own, and pinning
+	 *	pages for one worker's I/O doesn't contend with the others' on a single mm's locks.
+	 *
+	 *	The Job and its workers share a control block mapped before they're forked, which holds
+	 *	the run_threads, record_results and thread_error flags the workers' ThreadParams point
+	 *	at, and the start of the measured duration, which the Job only knows after the fork.
+	 *	A worker tells the Job it's initialized, has failed or is done with a byte on a pipe of
+	 *	its own; a thread of the Job's turns those into what a thread would have done to the
+	 *	Job directly, so the Job waits for workers just as it does for threads. A pipe that
+	 *	closes without the worker being done means it died, which fails the Job too.
+	 *
+	 *	A worker that's done writes its results to a memfd, which the Job maps once the worker
+	 *	has exited and reads into the thread's ThreadResults, so they're formatted as usual
+	 */
+	class ProcessWorkers {
+		public:
+			/// what a worker tells the Job
+			enum Event : char {
+				INITIALIZED		= 'i',
+				ABORTED			= 'a',
+				DONE			= 'd'
+			};
+
+			ProcessWorkers(Job& job, volatile bool * run_threads, volatile bool * thread_error) :
+				job(job), run_threads(run_threads), thread_error(thread_error) {}
+
+			/**
+			 *	Stops and reaps any workers still running
+			 */
+			~ProcessWorkers();
+
+			/**
+			 *	Map the control block. Must be called before the first start()
+			 */
+			bool create();
+
+			/**
+			 *	Fork a worker to run a thread, pinned to cpu if it isn't -1
+			 */
+			bool start(const std::shared_ptr<ThreadParams>& thread, int cpu);
+
+			/**
+			 *	Start passing the workers' events on to the Job, once they've all been started
+			 */
+			void listen();
+
+			/**
+			 *	Start the measured duration, which started at start_time_us, in the workers
+			 */
+			void start_recording(uint64_t start_time_us);
+			void stop_recording();
+
+			/**
+			 *	Stop the workers, wait for them to exit, and read their results. Returns false if
+			 *	any of them couldn't report them
+			 */
+			bool finish();
+
+			/**
+			 *	Tell the Job about a worker's progress, from the worker
+			 */
+			static void send(int fd, Event event);
+
+		private:
+			Job& job;
+			volatile bool * run_threads;
+			volatile bool * thread_error;
+
+			struct Control {
+				volatile bool run_threads;
+				volatile bool record_results;
+				volatile bool thread_error;
+				volatile uint64_t start_time_us;
+			};
+			Control * control = nullptr;
+
+			struct Worker {
+				std::shared_ptr<ThreadParams> thread;
+				pid_t pid;
+				int event_fd;		// the read end of the worker's pipe
+				int results_fd;		// memfd
+				bool exited;		// with status 0, once it's been reaped
+			};
+			std::vector<Worker> workers;
+
+			std::thread listener;
+
+			/// the body of the listener thread
+			void relay();
+
+			/// a worker failed; stop the others and wake the Job
+			void abort();
+
+			/// stop the workers and wait for them, and the listener, to be done
+			void reap();
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_PROCESS_H
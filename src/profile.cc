@@ -1,11 +1,14 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
 #include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <inttypes.h>
+#include <sstream>
+#include <iterator>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -18,6 +21,7 @@
 #include "options.h"
 #include "posix_aio.h"
 #include "kernel_aio.h"
+#include "profile_file.h"
 
 namespace diskspd
 {
@@ -26,6 +30,154 @@ namespace diskspd
 	bool verbose(false);
 	bool debug(false);
 
+	/**
+	 *	Parse a --random-dist argument: comma separated IO%/TARGET% pairs, whose IO% and TARGET%
+	 *	values must each add up to 100
+	 */
+	static bool parse_random_dist(const char * arg, std::vector<RandomDistRange>& dist) {
+
+		unsigned long io_total = 0;
+		unsigned long target_total = 0;
+
+		while (*arg) {
+			char * end;
+			unsigned long io_percent = strtoul(arg, &end, 10);
+			if (end == arg || *end != '/') {
+				fprintf(stderr, "Invalid --random-dist range \"%s\"\n", arg);
+				return false;
+			}
+			const char * target_arg = end + 1;
+			unsigned long target_percent = strtoul(target_arg, &end, 10);
+			if (end == target_arg || (*end && *end != ',') || !target_percent) {
+				fprintf(stderr, "Invalid --random-dist range \"%s\"\n", arg);
+				return false;
+			}
+			io_total += io_percent;
+			target_total += target_percent;
+			if (io_total > 100 || target_total > 100) break;
+
+			dist.push_back({(unsigned int)io_percent, (unsigned int)target_percent});
+			arg = *end ? end + 1 : end;
+		}
+
+		if (io_total != 100 || target_total != 100) {
+			fprintf(stderr, "--random-dist IO%% and TARGET%% values must each add up to 100\n");
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 *	The modes that can't be used together, each with the ones that can't be used with it.
+	 *	A pair only has to be listed under one of the two
+	 */
+	static const struct {
+		OptionType mode;
+		std::vector<OptionType> excludes;
+	} exclusive_modes[] = {
+		{ SYNTHESIZE,	{ REPLAY } },
+		{ SWEEP,		{ SYNTHESIZE, REPLAY, AGE } },
+		{ CHAIN,		{ REPLAY } },
+		{ LSM,			{ REPLAY, CHAIN } },
+		{ WAL,			{ REPLAY, CHAIN, LSM } },
+		{ STRIPE,		{ REPLAY, CHAIN, LSM, WAL } },
+		{ MIRROR,		{ REPLAY, CHAIN, LSM, WAL, STRIPE } },
+		{ ERASURE,		{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR } },
+		{ CACHE,		{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE } },
+		{ GROUP,		{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, CACHE } },
+		{ AGE,			{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, CACHE } },
+		{ PRECONDITION,	{ SYNTHESIZE, REPLAY, LSM, WAL } },
+		{ WEIGHTS,		{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, CACHE } },
+		{ RATE,			{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE } },
+		{ IDLE,			{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE } },
+		{ QD_TARGET,	{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, IDLE } },
+		{ RAMP,			{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, IDLE } },
+		{ STEADY,		{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, RAMP } },
+		{ WORK,			{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, CACHE, WEIGHTS, IDLE,
+						  QD_TARGET, RAMP } },
+		{ SCAN,			{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, CACHE, WEIGHTS, IDLE,
+						  QD_TARGET, RAMP, STEADY, WORK } },
+		{ PROCESSES,	{ REPLAY, CHAIN, LSM, WAL, STRIPE, MIRROR, ERASURE, CACHE, WEIGHTS, IDLE,
+						  QD_TARGET, RAMP, STEADY, WORK, SCAN, RATE } },
+	};
+
+	/**
+	 *	Check that no two of the modes given exclude each other
+	 */
+	static bool check_exclusive_modes(const Options& options) {
+		std::vector<OptionType> given = options.given();
+		auto is_given = [&](OptionType type) {
+			return std::find(given.begin(), given.end(), type) != given.end();
+		};
+		for (auto& entry : exclusive_modes) {
+			if (!is_given(entry.mode)) continue;
+			for (OptionType other : entry.excludes) {
+				if (is_given(other)) {
+					fprintf(stderr, "Can't use %s with %s!\n", options.option_name(entry.mode).c_str(),
+							options.option_name(other).c_str());
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/**
+	 *	The usable size of the smallest of a Job's targets, from its base offset to its max size
+	 */
+	static off_t smallest_target(const JobOptions& job_options) {
+		off_t size = job_options.targets[0]->max_size - job_options.targets[0]->base_offset;
+		for (auto& target : job_options.targets) {
+			size = std::min(size, target->max_size - target->base_offset);
+		}
+		return size;
+	}
+
+	/**
+	 *	Create the Target that stands for all of a Job's targets together (--stripe, --mirror,
+	 *	--erasure), named NAME(PATH,PATH...). Its offset, -w and -o settings are the ones in
+	 *	dummy, and -T then only applies to it. Returns nullptr if it's too small for them
+	 */
+	static std::shared_ptr<Target> logical_target(const char * name, off_t size, const Target& dummy,
+			JobOptions& job_options) {
+
+		std::string path = std::string(name) + "(";
+		for (auto& target : job_options.targets) {
+			path += (path.back() == '(' ? "" : ",") + target->path;
+		}
+
+		auto logical = std::make_shared<Target>(path + ")");
+		logical->size					= size;
+		logical->max_size				= size;
+		logical->block_size				= dummy.block_size;
+		logical->overlap				= dummy.overlap;
+		logical->thread_offset			= dummy.thread_offset;
+		logical->stride					= dummy.stride;
+		logical->use_random_alignment	= dummy.use_random_alignment;
+		logical->random_dist			= dummy.random_dist;
+		logical->use_interlocked		= dummy.use_interlocked;
+		logical->write_percentage		= dummy.write_percentage;
+		logical->open_flags				= dummy.open_flags;
+		logical->threads_per_target		= 0;
+
+		if (logical->max_size < logical->block_size) {
+			fprintf(stderr, "--%s is too small for block size of %lu bytes\n", name,
+					logical->block_size);
+			return nullptr;
+		}
+		if (logical->max_size - logical->block_size <
+				logical->thread_offset*(job_options.total_threads - 1)) {
+			fprintf(stderr, "--%s is too small for a thread stride of %lu bytes\n", name,
+					logical->thread_offset);
+			return nullptr;
+		}
+
+		for (auto& target : job_options.targets) {
+			target->thread_offset = 0;
+		}
+		return logical;
+	}
+
 	bool Profile::parse_options(int argc, char ** argv) {
 
 		assert(argc >= 1);
@@ -49,13 +201,184 @@ namespace diskspd
 			return false;
 		}
 
-		// TODO JSON/XML input options would be checked here, possibly producing a number of Jobs
+		// --daemon; nothing else can be given, as every run is a request of its own
+		if (const char * daemon_arg = options.get_arg(DAEMON)) {
+			for (OptionType type : options.given()) {
+				if (type != DAEMON) {
+					fprintf(stderr, "Can't give other options with --daemon!\n");
+					return false;
+				}
+			}
+			if (options.get_non_opts().size()) {
+				fprintf(stderr, "Targets come from the requests with --daemon!\n");
+				return false;
+			}
+			socket = daemon_arg;
+			mode = Mode::DAEMON;
+			return true;
+		}
+
+		// --connect; the rest of the command line is the daemon's to parse
+		if (const char * connect_arg = options.get_arg(CONNECT)) {
+			socket = connect_arg;
+			for (int i = 1; i < argc; ++i) {
+				std::string arg(argv[i]);
+				if (arg == "--connect") {
+					++i;
+				} else if (arg.compare(0, strlen("--connect="), "--connect=")) {
+					request.push_back(arg);
+				}
+			}
+			mode = Mode::CONNECT;
+			return true;
+		}
+
+		// --profile; a Job for every one in the file, each parsed from a command line of its own
+		if (const char * profile_arg = options.get_arg(PROFILE)) {
+			// every other option, --processes included, is given per Job in the file
+			for (OptionType type : options.given()) {
+				if (type != PROFILE) {
+					fprintf(stderr, "Can't use %s with --profile; give it to the profile's Jobs!\n",
+							options.option_name(type).c_str());
+					return false;
+				}
+			}
+			if (options.get_non_opts().size()) {
+				fprintf(stderr, "Targets come from the profile with --profile!\n");
+				return false;
+			}
+
+			ProfileFile file;
+			if (!file.load(profile_arg)) {
+				return false;
+			}
+			for (auto& words : file.jobs) {
+				std::vector<char *> job_argv;
+				for (auto& word : words) {
+					job_argv.push_back(&word[0]);
+				}
+				Options job_options;
+				if (!job_options.parse_args(job_argv.size(), job_argv.data())) {
+					return false;
+				}
+				if (job_options.get_arg(PROFILE) || job_options.get_arg(SWEEP) ||
+						job_options.get_arg(SYNTHESIZE)) {
+					fprintf(stderr, "Can't use --profile, --sweep or --synthesize in a profile!\n");
+					return false;
+				}
+				if (!parse_job(job_options)) {
+					return false;
+				}
+
+				// a target an earlier Job lays out big enough is left as it is
+				for (auto& target : jobs.back()->get_options()->targets) {
+					for (size_t j = 0; j + 1 < jobs.size() && target->create_file; ++j) {
+						for (auto& earlier : jobs[j]->get_options()->targets) {
+							if (earlier->create_file && earlier->path == target->path &&
+									earlier->size >= target->size) {
+								target->create_file = false;
+								break;
+							}
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		// --sweep; a Job for every point, each parsed as if its -b, -o, -t and -w had been given
+		if (const char * sweep_arg = options.get_arg(SWEEP)) {
+			sweep = std::make_shared<ParamSweep>();
+			if (!sweep->parse(sweep_arg)) {
+				return false;
+			}
+			for (size_t point = 0; point < sweep->size(); ++point) {
+				Options point_options = options;
+				if (!sweep->apply(point, point_options) || !parse_job(point_options)) {
+					return false;
+				}
+				jobs.back()->get_options()->sweep = sweep;
+				jobs.back()->get_options()->sweep_point = point;
+
+				// the first point lays the targets out, and preconditions them, for all of them
+				if (point) {
+					for (auto& target : jobs.back()->get_options()->targets) {
+						target->create_file = false;
+					}
+					jobs.back()->get_options()->precondition = nullptr;
+				}
+			}
+			return true;
+		}
+
+		return parse_job(options);
+	}
+
+	bool Profile::parse_job(Options& options) {
 
 		// Otherwise, there is a single Job, which will be populated by the rest of this function
 		std::shared_ptr<JobOptions> job_options = std::make_shared<JobOptions>();
 
+		const char * curr_arg = nullptr;
+
+		if (!check_exclusive_modes(options)) {
+			return false;
+		}
+
+		// --synthesize
+		// no Jobs are created; the trace is only modelled, so the other options don't apply
+		if (curr_arg = options.get_arg(SYNTHESIZE)) {
+			synthesis.trace = std::make_shared<Trace>();
+			if (!synthesis.trace->load(curr_arg)) {
+				return false;
+			}
+			synthesis.targets = options.get_non_opts();
+			if (synthesis.targets.size() == 0) {
+				synthesis.targets = synthesis.trace->paths;
+			} else if (synthesis.targets.size() != synthesis.trace->paths.size()) {
+				fprintf(stderr, "Trace has %lu paths but %lu targets were specified!\n",
+						synthesis.trace->paths.size(), synthesis.targets.size());
+				return false;
+			}
+			options.arg_to_number<off_t>(CREATE_FILES, 1, &synthesis.size);
+			options.arg_to_number<unsigned int>(SCALE_RATE, 0, &synthesis.rate_percent);
+
+			mode = Mode::SYNTHESIZE;
+			return true;
+
+		} else if (options.get_arg(SCALE_RATE)) {
+			fprintf(stderr, "--scale-rate only applies to --synthesize!\n");
+			return false;
+		}
+
+		// --replay
+		// this is checked first as the trace can provide the targets and decides the thread count
+		if (curr_arg = options.get_arg(REPLAY)) {
+			if (options.get_arg(THREADS_PER_TARGET) || options.get_arg(TOTAL_THREADS)) {
+				fprintf(stderr, "Can't use -t or -F with --replay; the trace decides the threads!\n");
+				return false;
+			}
+			job_options->replay_trace = std::make_shared<Trace>();
+			if (!job_options->replay_trace->load(curr_arg)) {
+				return false;
+			}
+			// every replay thread can issue I/O to every target, like -F
+			job_options->use_total_threads = true;
+			job_options->total_threads = job_options->replay_trace->thread_ops.size();
+		}
+
 		// Get targets
 		std::vector<std::string> non_opts = options.get_non_opts();
+		if (job_options->replay_trace) {
+			const std::vector<std::string>& traced_paths = job_options->replay_trace->paths;
+			if (non_opts.size() == 0) {
+				non_opts = traced_paths;
+			} else if (non_opts.size() != traced_paths.size()) {
+				fprintf(stderr, "Trace has %lu paths but %lu targets were specified!\n",
+						traced_paths.size(), non_opts.size());
+				return false;
+			}
+		}
 		if (non_opts.size() == 0) {
 			fprintf(stderr, "No targets specified!\n");
 			return false;
@@ -64,22 +387,28 @@ namespace diskspd
 			job_options->targets.push_back(std::make_shared<Target>(s));
 		}
 
-		const char * curr_arg = nullptr;
-
 		// since we can't specify options per-target in the command line, we'll store everything in
 		// this dummy and then apply it to all the targets at the end
 		Target dummy("");
 
+		// the threads_per_target option isn't relevant if the trace decides the threads
+		if (job_options->replay_trace) {
+			dummy.threads_per_target = 0;
+		}
+
 		// -a
 
-		// initialize SysInfo struct
-		sys_info = std::make_shared<SysInfo>();
+		// initialize SysInfo struct; it can only be initialized once, so the points of a
+		// --sweep share it
+		if (!sys_info) {
+			sys_info = std::make_shared<SysInfo>();
 
-		// use the argument to create an affinity set if there is one
-		if (curr_arg = options.get_arg(CPU_AFFINITY)) {
-			sys_info->init_sys_info(curr_arg);
-		} else {
-			sys_info->init_sys_info(nullptr);
+			// use the argument to create an affinity set if there is one
+			if (curr_arg = options.get_arg(CPU_AFFINITY)) {
+				sys_info->init_sys_info(curr_arg);
+			} else {
+				sys_info->init_sys_info(nullptr);
+			}
 		}
 
 		// -b
@@ -169,6 +498,28 @@ namespace diskspd
 			dummy.stride = dummy.block_size;
 		}
 
+		// --random-dist
+		if (curr_arg = options.get_arg(RANDOM_DIST)) {
+			if (!dummy.use_random_alignment) {
+				fprintf(stderr, "--random-dist only applies to random I/O (-r)!\n");
+				return false;
+			}
+			if (!parse_random_dist(curr_arg, dummy.random_dist)) {
+				return false;
+			}
+		}
+
+		// --chain
+		if (curr_arg = options.get_arg(CHAIN)) {
+			if (options.get_arg(WRITE) || options.get_arg(MAX_THROUGHPUT)) {
+				fprintf(stderr, "Can't use -w or -g with --chain; the chain decides the ops!\n");
+				return false;
+			}
+			if (!parse_chain(curr_arg, job_options->chain)) {
+				return false;
+			}
+		}
+
 		// -S
 		if (curr_arg = options.get_arg(CACHING_OPTIONS)) {
 
@@ -280,8 +631,303 @@ namespace diskspd
 			}
 		}
 
+		// --lsm
+		if (options.get_arg(LSM)) {
+			if (options.get_arg(CREATE_FILES) || options.get_arg(TOTAL_THREADS) ||
+					options.get_arg(WRITE) || options.get_arg(MAX_THROUGHPUT)) {
+				fprintf(stderr, "Can't use -c, -F, -w or -g with --lsm!\n");
+				return false;
+			}
+			if (job_options->targets.size() != 1) {
+				fprintf(stderr, "--lsm needs a single target directory!\n");
+				return false;
+			}
+			struct stat buf = {0};
+			if (stat(non_opts[0].c_str(), &buf) || !S_ISDIR(buf.st_mode)) {
+				fprintf(stderr, "--lsm target \"%s\" isn't a directory!\n", non_opts[0].c_str());
+				return false;
+			}
+
+			job_options->lsm = std::make_shared<LsmTree>();
+			if (!job_options->lsm->parse(options.get_arg(LSM))) {
+				return false;
+			}
+			const LsmTree& lsm = *job_options->lsm;
+			if (lsm.table_size < dummy.block_size || lsm.table_size % dummy.block_size ||
+					lsm.data_size < dummy.block_size || lsm.data_size % dummy.block_size) {
+				fprintf(stderr, "--lsm table and data set sizes must be multiples of the block size\n");
+				return false;
+			}
+
+			// -t counts the lookup threads; the flush and compaction threads come on top
+			dummy.threads_per_target += 2;
+		}
+
+		// --wal
+		if (options.get_arg(WAL)) {
+			if (options.get_arg(RANDOM_ALIGN) || options.get_arg(SEQUENTIAL_STRIDE) ||
+					options.get_arg(WRITE) || options.get_arg(MAX_THROUGHPUT)) {
+				fprintf(stderr, "Can't use -r, -s, -w or -g with --wal!\n");
+				return false;
+			}
+			if (job_options->targets.size() != 1) {
+				fprintf(stderr, "--wal needs a single target!\n");
+				return false;
+			}
+
+			job_options->wal = std::make_shared<WalLog>();
+			curr_arg = options.get_arg(WAL);
+			if (*curr_arg && !job_options->wal->parse(curr_arg)) {
+				return false;
+			}
+
+			// records are copied out of the I/O buffers, which have to hold the largest one
+			size_t align = dummy.open_flags & O_DIRECT ? dummy.sector_size : 1;
+			dummy.block_size = (job_options->wal->max_record_size + align - 1) & ~(align - 1);
+			dummy.stride = dummy.block_size;
+		}
+
+		// --stripe
+		if (curr_arg = options.get_arg(STRIPE)) {
+			if (options.get_arg(MAX_THROUGHPUT)) {
+				fprintf(stderr, "Can't use -g with --stripe!\n");
+				return false;
+			}
+			if (!Options::valid_byte_size(curr_arg)) {
+				fprintf(stderr, "Invalid --stripe unit\n");
+				return false;
+			}
+			job_options->stripe = std::make_shared<StripeSet>();
+			job_options->stripe->unit = Options::byte_size_from_arg(curr_arg, dummy.block_size);
+			if (!job_options->stripe->unit) {
+				fprintf(stderr, "--stripe unit can't be 0\n");
+				return false;
+			}
+			if (dummy.open_flags & O_DIRECT && job_options->stripe->unit % dummy.sector_size) {
+				fprintf(stderr, "O_DIRECT specified, but the --stripe unit isn't block aligned!\n");
+				return false;
+			}
+
+			// every thread does I/O on every member, so -t is the total number of threads
+			if (!job_options->use_total_threads) {
+				job_options->total_threads = dummy.threads_per_target;
+				job_options->use_total_threads = true;
+				dummy.threads_per_target = 0;
+			}
+		}
+
+		// --mirror
+		if (options.get_arg(MIRROR)) {
+			if (options.get_arg(MAX_THROUGHPUT)) {
+				fprintf(stderr, "Can't use -g with --mirror!\n");
+				return false;
+			}
+			if (job_options->targets.size() < 2) {
+				fprintf(stderr, "--mirror needs at least two targets!\n");
+				return false;
+			}
+			job_options->mirror = std::make_shared<MirrorSet>();
+			if (!job_options->mirror->parse(options.get_arg(MIRROR))) {
+				return false;
+			}
+			if (job_options->mirror->quorum > job_options->targets.size()) {
+				fprintf(stderr, "--mirror quorum is larger than the number of targets\n");
+				return false;
+			}
+
+			// every thread does I/O on every replica, so -t is the total number of threads
+			if (!job_options->use_total_threads) {
+				job_options->total_threads = dummy.threads_per_target;
+				job_options->use_total_threads = true;
+				dummy.threads_per_target = 0;
+			}
+		}
+
+		// --erasure
+		if (curr_arg = options.get_arg(ERASURE)) {
+			if (options.get_arg(MAX_THROUGHPUT)) {
+				fprintf(stderr, "Can't use -g with --erasure!\n");
+				return false;
+			}
+			// parity is computed in each op's own buffer, so there's no sharing a write buffer
+			if (dummy.separate_buffers) {
+				fprintf(stderr, "Can't use -Zs with --erasure!\n");
+				return false;
+			}
+			job_options->erasure = std::make_shared<ErasureSet>();
+			if (!job_options->erasure->parse(curr_arg)) {
+				return false;
+			}
+			if (job_options->targets.size() != job_options->erasure->members()) {
+				fprintf(stderr, "--erasure=%u+%u needs %u targets\n", job_options->erasure->data,
+						job_options->erasure->parity, job_options->erasure->members());
+				return false;
+			}
+
+			// every thread does I/O on every member, so -t is the total number of threads
+			if (!job_options->use_total_threads) {
+				job_options->total_threads = dummy.threads_per_target;
+				job_options->use_total_threads = true;
+				dummy.threads_per_target = 0;
+			}
+		}
+
+		// --cache
+		if (curr_arg = options.get_arg(CACHE)) {
+			job_options->cache = std::make_shared<BufferCache>();
+			if (!job_options->cache->parse(curr_arg, dummy.block_size)) {
+				return false;
+			}
+			// the cache stands in for the page cache, so misses bypass it
+			dummy.open_flags |= O_DIRECT;
+		}
+
+		// --age
+		if (curr_arg = options.get_arg(AGE)) {
+			// aging rewrites the targets, so it's only for files diskspd makes
+			if (!dummy.create_file) {
+				fprintf(stderr, "--age needs -c!\n");
+				return false;
+			}
+			job_options->age = std::make_shared<FsAging>();
+			if (!job_options->age->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --precondition
+		if (curr_arg = options.get_arg(PRECONDITION)) {
+			job_options->precondition = std::make_shared<Precondition>();
+			if (!job_options->precondition->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --weights
+		if (curr_arg = options.get_arg(WEIGHTS)) {
+			if (!job_options->use_total_threads) {
+				fprintf(stderr, "--weights needs -F, so every thread uses every target\n");
+				return false;
+			}
+			job_options->weights = std::make_shared<TargetWeights>();
+			TargetWeights& weights = *job_options->weights;
+			if (!weights.parse(curr_arg)) {
+				return false;
+			}
+			if (weights.weights.size() != job_options->targets.size()) {
+				fprintf(stderr, "--weights needs a weight for each of the %lu targets\n",
+						job_options->targets.size());
+				return false;
+			}
+
+			// every slot has to have somewhere to go
+			unsigned int total_weight = 0;
+			unsigned int room = 0;
+			bool capped = true;
+			for (size_t t = 0; t < weights.weights.size(); ++t) {
+				if (!weights.weights[t]) continue;
+				total_weight += weights.weights[t];
+				room += weights.max_overlap[t];
+				capped &= weights.max_overlap[t] != 0;
+			}
+			if (!total_weight) {
+				fprintf(stderr, "--weights needs a target with a weight above 0\n");
+				return false;
+			}
+			if (capped && room < dummy.overlap) {
+				fprintf(stderr, "--weights caps leave room for %u outstanding ops, but -o is %u\n",
+						room, dummy.overlap);
+				return false;
+			}
+		}
+
+		// --rate
+		if (curr_arg = options.get_arg(RATE)) {
+			job_options->rate = std::make_shared<RateLimits>();
+			if (!job_options->rate->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --qd-target
+		if (curr_arg = options.get_arg(QD_TARGET)) {
+			job_options->qd_target = std::make_shared<QdTarget>();
+			if (!job_options->qd_target->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --ramp
+		if (curr_arg = options.get_arg(RAMP)) {
+			job_options->ramp = std::make_shared<RampSchedule>();
+			if (!job_options->ramp->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --steady
+		if (curr_arg = options.get_arg(STEADY)) {
+			job_options->steady = std::make_shared<SteadyState>();
+			SteadyState& steady = *job_options->steady;
+			if (!steady.parse(curr_arg)) {
+				return false;
+			}
+			if (job_options->warmup_time*1000 < steady.window_ms*steady.windows) {
+				fprintf(stderr, "--steady needs a -W of at least %lums for %u windows of %lums\n",
+						steady.window_ms*steady.windows, steady.windows, steady.window_ms);
+				return false;
+			}
+		}
+
+		// --idle
+		if (curr_arg = options.get_arg(IDLE)) {
+			job_options->idle = std::make_shared<IdleGaps>();
+			if (!job_options->idle->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --work
+		if (curr_arg = options.get_arg(WORK)) {
+			job_options->work = std::make_shared<FixedWork>();
+			if (!job_options->work->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --scan
+		if (curr_arg = options.get_arg(SCAN)) {
+			if (!job_options->use_total_threads) {
+				fprintf(stderr, "--scan needs -F, so every thread can scan every target\n");
+				return false;
+			}
+			// the chunks are the partitioning; a scan has no other offsets
+			if (dummy.use_random_alignment || dummy.use_interlocked || dummy.thread_offset ||
+					dummy.random_dist.size()) {
+				fprintf(stderr, "Can't use --scan with -r, -si, -T or --random-dist!\n");
+				return false;
+			}
+			// it scans from the start of the measured duration
+			if (job_options->warmup_time && options.get_arg(WARMUP_TIME)) {
+				fprintf(stderr, "--scan has no warm up; every block is scanned once, measured\n");
+				return false;
+			}
+			job_options->warmup_time = 0;
+			job_options->scan = std::make_shared<TargetScan>();
+			if (!job_options->scan->parse(curr_arg)) {
+				return false;
+			}
+		}
+
+		// --processes
+		if (options.get_arg(PROCESSES)) {
+			job_options->processes = true;
+		}
+
 		// now apply all the dummy options to the targets, and do createfile stuff
-		for (auto& target : job_options->targets) {
+		for (size_t target_index = 0; target_index < job_options->targets.size(); ++target_index) {
+
+			auto& target = job_options->targets[target_index];
 
 			target->create_file			= dummy.create_file;
 			target->block_size			= dummy.block_size;
@@ -292,6 +938,7 @@ namespace diskspd
 			target->thread_offset		= dummy.thread_offset;
 			target->stride				= dummy.stride;
 			target->use_random_alignment= dummy.use_random_alignment;
+			target->random_dist			= dummy.random_dist;
 
 			target->open_flags			= dummy.open_flags;
 
@@ -310,6 +957,13 @@ namespace diskspd
 			target->rand_buffers		= dummy.rand_buffers;
 			target->separate_buffers	= dummy.separate_buffers;
 
+			// a replayed target's buffers must be able to hold the largest op traced on it
+			if (job_options->replay_trace) {
+				size_t align = target->open_flags & O_DIRECT ? target->sector_size : 1;
+				size_t largest = job_options->replay_trace->max_op_size[target_index];
+				target->block_size = largest ? (largest + align - 1) & ~(align - 1) : align;
+			}
+
 			// add up the total threads, if -F wasn't specified
 			if (!job_options->use_total_threads) {
 				job_options->total_threads += target->threads_per_target;
@@ -357,6 +1011,11 @@ namespace diskspd
 				target->size = dummy.size;
 			}
 
+			// an --lsm target is a directory; its size is the size of the data set
+			if (job_options->lsm) {
+				target->size = job_options->lsm->data_size;
+			}
+
 			// default max_size to size if the option wasn't specified
 			if (!dummy.max_size) {
 				target->max_size = target->size;
@@ -379,6 +1038,81 @@ namespace diskspd
 			}
 		}
 
+		// --group
+		std::vector<std::string> groups = options.get_args(GROUP);
+		if (groups.size()) {
+			// each group's threads only use the group's own targets
+			if (job_options->use_total_threads) {
+				fprintf(stderr, "Can't use -F with --group!\n");
+				return false;
+			}
+			for (auto& group : groups) {
+				if (!parse_group(group, *job_options)) {
+					return false;
+				}
+			}
+		}
+
+		// --ramp; now that the thread count is known, the duration is a step per thread count
+		if (job_options->ramp) {
+			RampSchedule& ramp = *job_options->ramp;
+			if (ramp.start > job_options->total_threads) {
+				fprintf(stderr, "--ramp starts with %u threads, but there are only %u\n", ramp.start,
+						job_options->total_threads);
+				return false;
+			}
+			job_options->duration = ramp.steps(job_options->total_threads)*ramp.step_s;
+		}
+
+		// --processes; -si shares each target's offset between its threads, which workers can't
+		if (job_options->processes) {
+			for (auto& target : job_options->targets) {
+				if (target->use_interlocked) {
+					fprintf(stderr, "Can't use --processes with -si!\n");
+					return false;
+				}
+			}
+		}
+
+		// --rate; now that all the targets are known
+		if (job_options->rate) {
+			job_options->rate->set_targets(job_options->targets);
+		}
+
+		// the stripe set is as big as its smallest member allows, in whole stripe units
+		if (job_options->stripe) {
+			off_t unit = job_options->stripe->unit;
+			off_t member_size = smallest_target(*job_options);
+			job_options->stripe->logical = logical_target("stripe",
+					job_options->targets.size()*(member_size - member_size % unit), dummy, *job_options);
+			if (!job_options->stripe->logical) {
+				return false;
+			}
+		}
+
+		// the mirror is as big as its smallest replica
+		if (job_options->mirror) {
+			job_options->mirror->logical = logical_target("mirror", smallest_target(*job_options),
+					dummy, *job_options);
+			if (!job_options->mirror->logical) {
+				return false;
+			}
+			// a slot's replica ops may still be in flight when it moves on to its next op
+			for (auto& target : job_options->targets) {
+				target->overlap = 2*dummy.overlap;
+			}
+		}
+
+		// a logical op covers the same block on every member, so the set is as big as the
+		// smallest member too, but holds K times as much data
+		if (job_options->erasure) {
+			job_options->erasure->logical = logical_target("erasure", smallest_target(*job_options),
+					dummy, *job_options);
+			if (!job_options->erasure->logical) {
+				return false;
+			}
+		}
+
 		// set the result formatter
 		result_formatter = std::make_shared<ResultFormatterText>();
 
@@ -393,19 +1127,106 @@ namespace diskspd
 		return true;
 	}
 
+	bool Profile::parse_group(const std::string& group, JobOptions& job_options) {
+
+		// the group is a command line of its own, split on spaces
+		std::vector<std::string> words = { "diskspd" };
+		std::istringstream stream(group);
+		for (std::string word; stream >> word; ) {
+			words.push_back(word);
+		}
+		std::vector<char *> argv;
+		for (auto& word : words) {
+			argv.push_back(&word[0]);
+		}
+
+		Options options;
+		if (!options.parse_args(argv.size(), argv.data())) {
+			return false;
+		}
+
+		// only the options that are kept per target make sense for a group
+		const OptionType per_target[] = {
+			BLOCK_SIZE, BASE_OFFSET, CREATE_FILES, MAX_SIZE, MAX_THROUGHPUT, OVERLAP,
+			RANDOM_ALIGN, SEQUENTIAL_STRIDE, CACHING_OPTIONS, THREADS_PER_TARGET, THREAD_STRIDE,
+			WRITE, IO_BUFFERS, RANDOM_DIST
+		};
+		for (OptionType type : options.given()) {
+			if (std::find(std::begin(per_target), std::end(per_target), type) == std::end(per_target)) {
+				fprintf(stderr, "Only -b, -B, -c, -f, -g, -o, -r, -s, -S, -t, -T, -w, -Z and "
+						"--random-dist can be given in a --group\n");
+				return false;
+			}
+		}
+
+		if (job_options.age && !options.get_arg(CREATE_FILES)) {
+			fprintf(stderr, "--age needs -c in every --group!\n");
+			return false;
+		}
+
+		// parse it into targets just as the command line's are, then move them to this Job
+		Profile group_profile;
+		if (!group_profile.parse_options(argv.size(), argv.data())) {
+			return false;
+		}
+		job_options.groups.push_back(group);
+		for (auto& target : group_profile.jobs[0]->get_options()->targets) {
+			target->group = job_options.groups.size();
+			job_options.total_threads += target->threads_per_target;
+			job_options.targets.push_back(target);
+		}
+		return true;
+	}
+
 	bool Profile::run_jobs() {
 		unsigned i = 0;
 		for (auto& job : jobs) {
+			// --sweep; give the targets a moment to go idle between points
+			if (sweep && i) {
+				usleep(sweep->settle_ms*1000);
+			}
+			if (sweep) {
+				v_printf("Sweep point %u of %lu\n", i + 1, jobs.size());
+			}
 			if (!job->run_job()) {
 				fprintf(stderr, "Job %u failed, exiting\n", i);
+				if (sweep) {
+					sweep->restore_queues(*sys_info);
+				}
 				return false;
 			}
 			++i;
 		}
+
+		// --sweep; put the devices' queue settings back the way they were
+		if (sweep) {
+			sweep->restore_queues(*sys_info);
+		}
 		return true;
 	}
 
 	void Profile::get_results() {
 		result_formatter->output_results(*this);
 	}
+
+	bool Profile::synthesize() {
+
+		printf("\nCommand Line: %s\n\n", cmd_line.c_str());
+		printf("Workload models for trace %s:\n\n", synthesis.trace->file.c_str());
+
+		for (unsigned int i = 0; i < synthesis.trace->paths.size(); ++i) {
+			WorkloadModel model = WorkloadModel::fit(*synthesis.trace, i);
+			model.print(stdout);
+
+			// a path that only saw syncs has no I/O to generate
+			if (model.reads + model.writes) {
+				printf("\t\tequivalent job (%u%% of traced rate):\n\t\t\t%s\n",
+						synthesis.rate_percent,
+						model.command_line(synthesis.targets[i], synthesis.size,
+							synthesis.rate_percent).c_str());
+			}
+			printf("\n");
+		}
+		return true;
+	}
 } // namespace
@@ -12,6 +12,8 @@
 #include "result_formatter.h"
 #include "target.h"
 #include "thread.h"
+#include "workload_model.h"
+#include "sweep.h"
 
 #ifndef DISKSPD_PROFILE_H
 #define DISKSPD_PROFILE_H
@@ -24,6 +26,8 @@ namespace diskspd {
 	 *	Updated by JobRunner as Jobs are run
 	 *	Finally used by ResultParser to output results
 	 */
+	class Options;
+
 	class Profile {
 
 		/// The ResultFormatter needs to access most of Profile
@@ -32,6 +36,14 @@ namespace diskspd {
 
 		public:
 
+			/// What the Profile does once its options are parsed
+			enum class Mode {
+				RUN_JOBS,		// run the Jobs and output their results
+				SYNTHESIZE,		// --synthesize; print workload models fitted to a trace
+				DAEMON,			// --daemon; serve runs over a socket
+				CONNECT			// --connect; have a daemon do the run
+			};
+
 			/// record of what the user typed
 			std::string cmd_line;
 
@@ -51,17 +63,60 @@ namespace diskspd {
 			 */
 			void get_results();
 
+			/**
+			 *	Print the workload model of each path in the --synthesize trace, with a command
+			 *	line that reproduces it
+			 */
+			bool synthesize();
+
+			inline Mode get_mode() const { return mode; }
+
+			/**
+			 *	Use a SysInfo that's already been initialized (by a --daemon) instead of one of
+			 *	the Profile's own
+			 */
+			inline void set_sys_info(const std::shared_ptr<SysInfo>& info) { sys_info = info; }
+
+			/// --daemon and --connect; the socket
+			inline const std::string& get_socket() const { return socket; }
+
+			/// --connect; the command line for the daemon, without --connect
+			inline const std::vector<std::string>& get_request() const { return request; }
+
 		private:
 
+			Mode mode = Mode::RUN_JOBS;
+
+			/// Used instead of Jobs with --synthesize
+			SynthesisOptions synthesis;
+
+			/// --daemon and --connect
+			std::string socket;
+			std::vector<std::string> request;
+
 			/// Jobs to run
 			std::vector<std::shared_ptr<Job>> jobs;
 
+			/// --sweep; if set, each Job is a point of this sweep
+			std::shared_ptr<ParamSweep> sweep;
+
 			/// An interface defining a class that formats and outputs the results of the profile
 			std::shared_ptr<IResultFormatter> result_formatter;
 
 			/// Info about the system (cpus etc)
 			std::shared_ptr<SysInfo> sys_info;
 
+			/**
+			 *	Parse the options of a Job, adding it to jobs (or, with --synthesize, setting up
+			 *	the synthesis instead)
+			 */
+			bool parse_job(Options& options);
+
+			/**
+			 *	Parse a --group's options and targets, adding the targets to job_options
+			 */
+			bool parse_group(const std::string& group, JobOptions& job_options);
+
 	};
 
 } //namespace diskspd
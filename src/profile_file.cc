@@ -0,0 +1,383 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "profile_file.h"
+
+namespace diskspd {
+
+	/**
+	 *	A recursive descent JSON parser over a whole file, which reports the line of the first
+	 *	error
+	 */
+	class JsonParser {
+		public:
+			JsonParser(const std::string& file, const std::string& text) : file(file), text(text) {}
+
+			bool parse(JsonValue& value) {
+				if (!parse_value(value)) {
+					return false;
+				}
+				skip_space();
+				if (pos != text.size()) {
+					return error("expected the end of the file");
+				}
+				return true;
+			}
+
+		private:
+			const std::string& file;
+			const std::string& text;
+			size_t pos = 0;
+
+			bool error(const char * what) {
+				size_t line = 1 + std::count(text.begin(), text.begin() + std::min(pos, text.size()), '\n');
+				fprintf(stderr, "%s:%lu: %s\n", file.c_str(), line, what);
+				return false;
+			}
+
+			void skip_space() {
+				while (pos < text.size() && strchr(" \t\r\n", text[pos])) ++pos;
+			}
+
+			bool literal(const char * word) {
+				size_t len = strlen(word);
+				if (text.compare(pos, len, word)) {
+					return false;
+				}
+				pos += len;
+				return true;
+			}
+
+			bool parse_value(JsonValue& value) {
+				skip_space();
+				if (pos == text.size()) {
+					return error("expected a value");
+				}
+				char c = text[pos];
+				if (c == '{') {
+					return parse_object(value);
+				} else if (c == '[') {
+					return parse_array(value);
+				} else if (c == '"') {
+					value.type = JsonValue::STRING;
+					return parse_string(value.text);
+				} else if (c == '-' || (c >= '0' && c <= '9')) {
+					size_t start = pos;
+					while (pos < text.size() && strchr("+-.eE0123456789", text[pos])) ++pos;
+					value.type = JsonValue::NUMBER;
+					value.text = text.substr(start, pos - start);
+					char * end;
+					strtod(value.text.c_str(), &end);
+					return *end == '\0' || error("invalid number");
+				} else if (literal("true")) {
+					value.type = JsonValue::BOOLEAN;
+					value.boolean = true;
+					return true;
+				} else if (literal("false")) {
+					value.type = JsonValue::BOOLEAN;
+					return true;
+				} else if (literal("null")) {
+					value.type = JsonValue::NUL;
+					return true;
+				}
+				return error("expected a value");
+			}
+
+			bool parse_string(std::string& out) {
+				// the opening quote
+				++pos;
+				while (pos < text.size() && text[pos] != '"') {
+					char c = text[pos++];
+					if (c != '\\') {
+						out += c;
+						continue;
+					}
+					if (pos == text.size()) break;
+					c = text[pos++];
+					switch (c) {
+						case 'n': out += '\n'; break;
+						case 't': out += '\t'; break;
+						case 'r': out += '\r'; break;
+						case 'b': out += '\b'; break;
+						case 'f': out += '\f'; break;
+						case 'u': {
+							// only ASCII is of any use in a profile
+							unsigned long code = pos + 4 <= text.size() ?
+								strtoul(text.substr(pos, 4).c_str(), nullptr, 16) : 0x100;
+							if (code >= 0x80) {
+								return error("only ASCII \\u escapes are supported");
+							}
+							out += (char)code;
+							pos += 4;
+							break;
+						}
+						default: out += c; break;
+					}
+				}
+				if (pos == text.size()) {
+					return error("unterminated string");
+				}
+				// the closing quote
+				++pos;
+				return true;
+			}
+
+			bool parse_array(JsonValue& value) {
+				value.type = JsonValue::ARRAY;
+				++pos;
+				skip_space();
+				if (pos < text.size() && text[pos] == ']') {
+					++pos;
+					return true;
+				}
+				while (true) {
+					value.array.emplace_back();
+					if (!parse_value(value.array.back())) {
+						return false;
+					}
+					skip_space();
+					if (pos < text.size() && text[pos] == ',') {
+						++pos;
+					} else if (pos < text.size() && text[pos] == ']') {
+						++pos;
+						return true;
+					} else {
+						return error("expected , or ]");
+					}
+				}
+			}
+
+			bool parse_object(JsonValue& value) {
+				value.type = JsonValue::OBJECT;
+				++pos;
+				skip_space();
+				if (pos < text.size() && text[pos] == '}') {
+					++pos;
+					return true;
+				}
+				while (true) {
+					skip_space();
+					if (pos == text.size() || text[pos] != '"') {
+						return error("expected a member name");
+					}
+					std::string name;
+					if (!parse_string(name)) {
+						return false;
+					}
+					skip_space();
+					if (pos == text.size() || text[pos] != ':') {
+						return error("expected :");
+					}
+					++pos;
+					value.object.emplace_back(name, JsonValue());
+					if (!parse_value(value.object.back().second)) {
+						return false;
+					}
+					skip_space();
+					if (pos < text.size() && text[pos] == ',') {
+						++pos;
+					} else if (pos < text.size() && text[pos] == '}') {
+						++pos;
+						return true;
+					} else {
+						return error("expected , or }");
+					}
+				}
+			}
+	};
+
+	bool ProfileFile::per_target(const std::string& name) {
+		static const char * names[] = {
+			"b", "block-size", "B", "base-offset", "c", "create-files", "f", "target-size",
+			"g", "throttle-throughput", "o", "overlap", "r", "random-align", "s",
+			"sequential-stride", "S", "caching-options", "t", "threads-per-target", "T",
+			"thread-stride", "w", "write", "Z", "io-buffers", "random-dist"
+		};
+		return std::find(std::begin(names), std::end(names), name) != std::end(names);
+	}
+
+	/**
+	 *	The command line word for an option, or "" if it's left out
+	 */
+	static bool option_word(const std::string& file, const std::string& name, const JsonValue& value,
+			std::string& word) {
+		word.clear();
+		if (value.type == JsonValue::NUL || (value.type == JsonValue::BOOLEAN && !value.boolean)) {
+			return true;
+		}
+		if (value.type == JsonValue::ARRAY || value.type == JsonValue::OBJECT || name.empty()) {
+			fprintf(stderr, "%s: invalid value for option \"%s\"\n", file.c_str(), name.c_str());
+			return false;
+		}
+		word = name.size() == 1 ? "-" + name : "--" + name;
+		if (value.type != JsonValue::BOOLEAN) {
+			word += (name.size() == 1 ? "" : "=") + value.text;
+		}
+		return true;
+	}
+
+	bool ProfileFile::load(const std::string& file) {
+
+		this->file = file;
+
+		FILE * f = fopen(file.c_str(), "rb");
+		if (!f) {
+			fprintf(stderr, "Couldn't open profile %s\n", file.c_str());
+			return false;
+		}
+		std::string text;
+		char buf[4096];
+		for (size_t n; (n = fread(buf, 1, sizeof(buf), f)); ) {
+			text.append(buf, n);
+		}
+		fclose(f);
+
+		JsonValue root;
+		JsonParser parser(file, text);
+		if (!parser.parse(root)) {
+			return false;
+		}
+
+		const JsonValue * job_list = nullptr;
+		if (root.type == JsonValue::OBJECT) {
+			for (auto& member : root.object) {
+				if (member.first == "jobs") {
+					job_list = &member.second;
+				} else {
+					fprintf(stderr, "%s: unknown member \"%s\"\n", file.c_str(), member.first.c_str());
+					return false;
+				}
+			}
+		}
+		if (!job_list || job_list->type != JsonValue::ARRAY || job_list->array.empty()) {
+			fprintf(stderr, "%s: a profile needs a \"jobs\" array with at least one Job\n", file.c_str());
+			return false;
+		}
+
+		for (auto& job : job_list->array) {
+			size_t number = jobs.size() + 1;
+			if (job.type != JsonValue::OBJECT) {
+				fprintf(stderr, "%s: Job %lu isn't an object\n", file.c_str(), number);
+				return false;
+			}
+
+			std::vector<std::string> words = { "diskspd" };
+			// the per-target options every target starts with
+			std::vector<std::pair<std::string, std::string>> defaults;
+			const JsonValue * targets = nullptr;
+
+			for (auto& member : job.object) {
+				if (member.first == "targets") {
+					targets = &member.second;
+					continue;
+				}
+				std::string word;
+				if (!option_word(file, member.first, member.second, word)) {
+					return false;
+				}
+				if (word.empty()) continue;
+				if (per_target(member.first)) {
+					defaults.push_back({ member.first, word });
+				} else {
+					words.push_back(word);
+				}
+			}
+
+			if (!targets || targets->type != JsonValue::ARRAY || targets->array.empty()) {
+				fprintf(stderr, "%s: Job %lu needs a \"targets\" array with at least one target\n",
+						file.c_str(), number);
+				return false;
+			}
+
+			// each target's settings: its own on top of the Job's, in the Job's order
+			std::vector<std::vector<std::string>> settings;
+			std::vector<std::string> paths;
+			for (auto& target : targets->array) {
+				if (target.type != JsonValue::OBJECT) {
+					fprintf(stderr, "%s: Job %lu has a target that isn't an object\n", file.c_str(), number);
+					return false;
+				}
+				std::vector<std::pair<std::string, std::string>> options = defaults;
+				std::string path;
+				for (auto& member : target.object) {
+					if (member.first == "path") {
+						if (member.second.type != JsonValue::STRING || member.second.text.empty()) {
+							fprintf(stderr, "%s: Job %lu has a target whose path isn't a string\n",
+									file.c_str(), number);
+							return false;
+						}
+						path = member.second.text;
+						continue;
+					}
+					if (!per_target(member.first)) {
+						fprintf(stderr, "%s: \"%s\" isn't a per-target option; only -b, -B, -c, -f, -g, "
+								"-o, -r, -s, -S, -t, -T, -w, -Z and --random-dist are\n",
+								file.c_str(), member.first.c_str());
+						return false;
+					}
+					std::string word;
+					if (!option_word(file, member.first, member.second, word)) {
+						return false;
+					}
+					auto it = std::find_if(options.begin(), options.end(),
+							[&](const std::pair<std::string, std::string>& o) { return o.first == member.first; });
+					if (it != options.end()) {
+						options.erase(it);
+					}
+					if (!word.empty()) {
+						options.push_back({ member.first, word });
+					}
+				}
+				if (path.empty()) {
+					fprintf(stderr, "%s: Job %lu has a target without a path\n", file.c_str(), number);
+					return false;
+				}
+				std::vector<std::string> target_words;
+				for (auto& option : options) {
+					target_words.push_back(option.second);
+				}
+				settings.push_back(target_words);
+				paths.push_back(path);
+			}
+
+			// the first run of targets with the same settings goes on the command line itself,
+			// and every other run in a group
+			words.insert(words.end(), settings[0].begin(), settings[0].end());
+			size_t t = 0;
+			for (; t < paths.size() && settings[t] == settings[0]; ++t) {
+				words.push_back(paths[t]);
+			}
+			while (t < paths.size()) {
+				std::string group;
+				for (auto& word : settings[t]) {
+					group += word + " ";
+				}
+				size_t run = t;
+				for (; t < paths.size() && settings[t] == settings[run]; ++t) {
+					// a group is split on spaces
+					if (paths[t].find_first_of(" \t\r\n") != std::string::npos ||
+							group.find_first_of("\t\r\n") != std::string::npos) {
+						fprintf(stderr, "%s: only the first targets of a Job can have spaces in their "
+								"path or settings\n", file.c_str());
+						return false;
+					}
+					group += paths[t] + " ";
+				}
+				group.pop_back();
+				words.push_back("--group=" + group);
+			}
+
+			jobs.push_back(words);
+		}
+		return true;
+	}
+
+} // namespace diskspd
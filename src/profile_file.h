@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#ifndef DISKSPD_PROFILE_FILE_H
+#define DISKSPD_PROFILE_FILE_H
+
+namespace diskspd {
+
+	/**
+	 *	A JSON value, as much of one as a profile needs. Numbers keep the text they were
+	 *	written as, and objects keep their members in order
+	 */
+	struct JsonValue {
+		enum Type {
+			NUL,
+			BOOLEAN,
+			NUMBER,
+			STRING,
+			ARRAY,
+			OBJECT
+		};
+		Type type					= NUL;
+		bool boolean				= false;
+		std::string text;			// NUMBER and STRING
+		std::vector<JsonValue> array;
+		std::vector<std::pair<std::string, JsonValue>> object;
+	};
+
+	/**
+	 *	A JSON job profile (--profile): Jobs to run one after the other, each with targets of
+	 *	its own settings. It looks like
+	 *
+	 *		{ "jobs": [ { "d": 10, "L": true, "b": "4K",
+	 *			"targets": [ { "path": "a", "c": "1G", "r": "4K", "t": 4 },
+	 *				{ "path": "b", "c": "1G", "b": "1M", "w": 100 } ] } ] }
+	 *
+	 *	Members are named as the command line's options, short or long, without dashes. A
+	 *	string or number is the option's argument, true gives it without one and false or null
+	 *	leaves it out. The per-target options a Job has are its targets' defaults.
+	 *
+	 *	Each Job becomes a command line: its own options, then its first target's, with the
+	 *	targets after that in --groups, runs of them with the same settings sharing one
+	 */
+	struct ProfileFile {
+		std::string file;
+
+		// each Job's command line, starting with the program name
+		std::vector<std::vector<std::string>> jobs;
+
+		/**
+		 *	Read and check a profile, filling in jobs
+		 */
+		bool load(const std::string& file);
+
+		/**
+		 *	Whether an option (named as in a profile) is kept per target, i.e. can be given in
+		 *	a --group
+		 */
+		static bool per_target(const std::string& name);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_PROFILE_FILE_H
@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <assert.h>
+
+#include "options.h"
+#include "qd.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	/**
+	 *	Parse a positive decimal number, fractions allowed
+	 */
+	static bool positive_from_arg(const std::string& arg, double& value) {
+		char * end = nullptr;
+		value = strtod(arg.c_str(), &end);
+		return !arg.empty() && *end == '\0' && std::isfinite(value) && value > 0;
+	}
+
+	uint64_t QdTarget::min_samples() const {
+		return std::max<uint64_t>(20, (uint64_t)ceil(100/(100 - pct)));
+	}
+
+	bool QdTarget::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t end = settings.find(',');
+		if (end == std::string::npos) end = settings.size();
+
+		double latency_ms;
+		if (!positive_from_arg(settings.substr(0, end), latency_ms) || latency_ms*1000 < 1) {
+			fprintf(stderr, "Invalid --qd-target latency\n");
+			return false;
+		}
+		latency_us = (uint64_t)(latency_ms*1000);
+
+		size_t pos = end + 1;
+		while (pos < settings.size()) {
+			end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --qd-target setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			bool valid = false;
+			if (key == "pct") {
+				valid = positive_from_arg(value, pct) && pct < 100;
+			} else if (key == "window") {
+				valid = Options::is_numeric(value.c_str()) && atoi(value.c_str()) > 0;
+				window_ms = atoi(value.c_str());
+			} else if (key == "decrease") {
+				valid = positive_from_arg(value, decrease) && decrease < 1;
+			}
+			if (!valid) {
+				fprintf(stderr, "Invalid --qd-target setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	QdController::QdController(const QdTarget& target, unsigned int max_qd, QdResults& results) :
+			target(target),
+			max_qd(max_qd),
+			results(results),
+			// the ops already started went out at the full -o
+			changed_us(PerfClock::get_time_us()) {
+		results.final_qd = qd_limit;
+	}
+
+	void QdController::completed(uint64_t issue_us, uint64_t now_us, bool record) {
+
+		if (!window_start_us) {
+			window_start_us = now_us;
+		}
+		if (issue_us >= changed_us) {
+			window_histogram.Add(now_us - issue_us);
+		}
+		if (now_us - window_start_us < target.window_ms*1000 ||
+				window_histogram.GetSampleSize() < target.min_samples()) {
+			return;
+		}
+
+		uint64_t latency_us = window_histogram.GetPercentile(target.pct/100);
+		bool over = latency_us > target.latency_us;
+		if (record) {
+			++results.windows;
+			results.windows_over += over;
+			results.qd_sum += qd_limit;
+			results.last_latency_us = latency_us;
+		}
+
+		unsigned int qd = qd_limit;
+		if (over) {
+			slow_start = false;
+			qd = std::max(1u, (unsigned int)(qd_limit*target.decrease));
+		} else {
+			qd = std::min(max_qd, slow_start ? qd_limit*2 : qd_limit + 1);
+		}
+		if (qd != qd_limit) {
+			qd_limit = qd;
+			changed_us = now_us;
+		}
+		results.final_qd = qd_limit;
+
+		window_start_us = now_us;
+		window_histogram.Clear();
+	}
+
+} // namespace diskspd
@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_QD_H
+#define DISKSPD_QD_H
+
+namespace diskspd {
+
+	class IAsyncIop;
+
+	/**
+	 *	A latency target for --qd-target: each thread adjusts how many of its -o ops it keeps
+	 *	outstanding so that the pct'th percentile latency of each window stays under latency_us
+	 */
+	struct QdTarget {
+		uint64_t latency_us			= 0;
+		double pct					= 99;		// pct=
+		uint64_t window_ms			= 100;		// window=
+		double decrease				= 0.5;		// decrease=
+
+		// a window also has to have enough samples for the percentile to mean something
+		uint64_t min_samples() const;
+
+		/**
+		 *	Parse a --qd-target argument: LATENCY in ms (fractions allowed), then optional
+		 *	comma separated key=value settings, named as above
+		 */
+		bool parse(const char * arg);
+	};
+
+	/**
+	 *	Per-thread queue depth results, over the windows that ended in the measured duration
+	 */
+	struct QdResults {
+		uint64_t windows			= 0;
+		uint64_t windows_over		= 0;	// windows whose percentile was over the target
+		uint64_t qd_sum				= 0;	// sum of the limits the windows ran at
+		unsigned int final_qd		= 0;
+		uint64_t last_latency_us	= 0;	// the percentile in the last window
+	};
+
+	/**
+	 *	A thread's side of --qd-target. The queue depth limit starts at 1 and doubles every
+	 *	window until a window goes over the target; from then on it's AIMD, going up by one op
+	 *	for every window under the target and down by the decrease factor for every window over
+	 *	it. Ops over the limit are held back as spares until the limit goes up.
+	 *
+	 *	Ops that were issued before the limit last changed aren't counted, so every window
+	 *	only sees the queue depth it's judging
+	 */
+	class QdController {
+		public:
+			QdController(const QdTarget& target, unsigned int max_qd, QdResults& results);
+
+			/**
+			 *	Count an op issued at issue_us that completed at now_us, ending the window if it's
+			 *	due. record is whether the Job is in the measured duration
+			 */
+			void completed(uint64_t issue_us, uint64_t now_us, bool record);
+
+			inline unsigned int limit() const { return qd_limit; }
+
+			inline void hold(const std::shared_ptr<IAsyncIop>& op) { spares.push_back(op); }
+			inline size_t spare_ops() const { return spares.size(); }
+
+			inline std::shared_ptr<IAsyncIop> pop() {
+				std::shared_ptr<IAsyncIop> op = spares.back();
+				spares.pop_back();
+				return op;
+			}
+
+		private:
+			const QdTarget& target;
+			const unsigned int max_qd;
+			QdResults& results;
+
+			unsigned int qd_limit = 1;
+			bool slow_start = true;
+
+			uint64_t changed_us;
+			uint64_t window_start_us = 0;
+			Histogram<uint64_t> window_histogram;
+
+			std::vector<std::shared_ptr<IAsyncIop>> spares;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_QD_H
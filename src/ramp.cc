@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <assert.h>
+
+#include "options.h"
+#include "ramp.h"
+
+namespace diskspd {
+
+	bool RampSchedule::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t end = settings.find(',');
+		if (end == std::string::npos) end = settings.size();
+
+		std::string seconds = settings.substr(0, end);
+		if (!Options::is_numeric(seconds.c_str()) || !(step_s = atoi(seconds.c_str()))) {
+			fprintf(stderr, "Invalid --ramp step time\n");
+			return false;
+		}
+
+		size_t pos = end + 1;
+		while (pos < settings.size()) {
+			end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --ramp setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			bool valid = Options::is_numeric(value.c_str()) && atoi(value.c_str()) > 0;
+			if (key == "start") {
+				start = atoi(value.c_str());
+			} else if (key == "step") {
+				step = atoi(value.c_str());
+			} else {
+				valid = false;
+			}
+			if (!valid) {
+				fprintf(stderr, "Invalid --ramp setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	unsigned int RampSchedule::steps(unsigned int total_threads) const {
+		if (start >= total_threads) {
+			return 1;
+		}
+		return 1 + (total_threads - start + step - 1)/step;
+	}
+
+	unsigned int RampSchedule::threads(unsigned int s, unsigned int total_threads) const {
+		return std::min(start + s*step, total_threads);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_RAMP_H
+#define DISKSPD_RAMP_H
+
+namespace diskspd {
+
+	/**
+	 *	A thread count ramp (--ramp). Every thread is set up before the warm up as usual, but
+	 *	only the first 'start' do I/O; every step_s seconds of the measured duration, 'step'
+	 *	more (in thread id order) start theirs, until all of them are. Each step is measured
+	 *	apart, so one run gives the scaling curve
+	 */
+	struct RampSchedule {
+		unsigned int step_s			= 0;
+		unsigned int start			= 1;		// start=
+		unsigned int step			= 1;		// step=
+
+		// threads with ids below this do I/O; set by the Job
+		std::atomic<unsigned int> active{0};
+
+		// the step being measured; set by the Job
+		std::atomic<unsigned int> current{0};
+
+		/**
+		 *	Parse a --ramp argument: SECONDS, then optional comma separated key=value settings,
+		 *	named as above
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	The number of steps it takes to get to total_threads
+		 */
+		unsigned int steps(unsigned int total_threads) const;
+
+		/**
+		 *	The number of threads doing I/O in a step
+		 */
+		unsigned int threads(unsigned int s, unsigned int total_threads) const;
+	};
+
+	/**
+	 *	Per-thread ramp results: the ops that completed in each step. Latencies are in
+	 *	microseconds, and only kept with -L
+	 */
+	struct RampResults {
+		struct Step {
+			uint64_t ops			= 0;
+			uint64_t bytes			= 0;
+			Histogram<uint64_t> latency_histogram;
+		};
+		std::vector<Step> steps;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_RAMP_H
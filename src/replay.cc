@@ -0,0 +1,280 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <assert.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "async_io.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "replay.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool Trace::load(const std::string& file) {
+
+		this->file = file;
+
+		FILE * f = fopen(file.c_str(), "rb");
+		if (!f) {
+			fprintf(stderr, "Couldn't open trace file %s\n", file.c_str());
+			return false;
+		}
+
+		TraceHeader header;
+		if (fread(&header, sizeof(header), 1, f) != 1 ||
+				memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) ||
+				header.version != TRACE_VERSION ||
+				header.record_size != sizeof(TraceRecord)) {
+			fprintf(stderr, "%s is not a diskspd trace file\n", file.c_str());
+			fclose(f);
+			return false;
+		}
+
+		// the capture library's ids and thread ids, mapped to our indexes
+		std::map<uint32_t, unsigned int> path_index;
+		std::map<uint32_t, unsigned int> thread_index;
+
+		uint64_t first_ns = std::numeric_limits<uint64_t>::max();
+		uint64_t last_ns = 0;
+		size_t total_ops = 0;
+
+		TraceRecord rec;
+		// a partial record at the end (e.g. the traced application was killed) is ignored
+		while (fread(&rec, sizeof(rec), 1, f) == 1) {
+
+			if (rec.op == TRACE_OP_PATH) {
+				std::string path(rec.size, '\0');
+				if (rec.size && fread(&path[0], 1, rec.size, f) != rec.size) {
+					break;
+				}
+				path_index[rec.path_id] = paths.size();
+				paths.push_back(path);
+				max_op_size.push_back(0);
+				continue;
+			}
+
+			if (rec.op > TRACE_OP_SYNC || !path_index.count(rec.path_id)) {
+				fprintf(stderr, "Trace file %s is corrupt\n", file.c_str());
+				fclose(f);
+				return false;
+			}
+
+			if (!thread_index.count(rec.tid)) {
+				thread_index[rec.tid] = thread_ops.size();
+				thread_ops.push_back(std::vector<ReplayOp>());
+			}
+
+			ReplayOp op;
+			op.time_ns = rec.time_ns;
+			op.offset = (off_t)rec.offset;
+			op.size = rec.size;
+			op.target = path_index[rec.path_id];
+			op.op = (TraceOp)rec.op;
+
+			if (op.size > max_op_size[op.target]) {
+				max_op_size[op.target] = op.size;
+			}
+			if (op.time_ns < first_ns) first_ns = op.time_ns;
+			if (op.time_ns > last_ns) last_ns = op.time_ns;
+
+			thread_ops[thread_index[rec.tid]].push_back(op);
+			++total_ops;
+		}
+		fclose(f);
+
+		if (!total_ops) {
+			fprintf(stderr, "Trace file %s contains no I/O\n", file.c_str());
+			return false;
+		}
+
+		// make times relative to the first op in the trace
+		for (auto& ops : thread_ops) {
+			for (auto& op : ops) {
+				op.time_ns -= first_ns;
+			}
+		}
+		span_ns = last_ns - first_ns;
+		// leave roughly one mean inter-arrival time between the end of the trace and its restart
+		loop_ns = span_ns + span_ns/total_ops;
+
+		return true;
+	}
+
+	/**
+	 *	Fit a traced op onto a target: align it if the target uses O_DIRECT, and wrap offsets that
+	 *	don't fit in [base_offset, max_size) back into that interval
+	 */
+	static void fit_to_target(const Target& target, const ReplayOp& r, off_t& offset, size_t& nbytes) {
+
+		size_t align = target.open_flags & O_DIRECT ? target.sector_size : 1;
+
+		nbytes = (r.size + align - 1) & ~(align - 1);
+		offset = r.offset;
+
+		// nbytes is never more than the block size, which the Profile checked fits in the target
+		if (offset < target.base_offset || offset + (off_t)nbytes > target.max_size) {
+			off_t range = target.max_size - target.base_offset - nbytes + 1;
+			offset = target.base_offset + offset % range;
+		}
+		offset -= (offset - target.base_offset) % align;
+	}
+
+	void ThreadParams::replay_func() {
+
+		const std::shared_ptr<Trace>& trace = job_options->replay_trace;
+		const std::vector<ReplayOp>& ops = trace->thread_ops[thread_id];
+
+		int aio_result = 0;
+
+		// each target has -o ops of its own; they're handed out as the trace needs them
+		std::map<TargetData *, std::vector<std::shared_ptr<IAsyncIop>>> free_ops;
+
+		for (auto& t_data : targets) {
+			for (unsigned int i = 0; i < t_data->target->overlap; ++i) {
+
+				void * read_buf = static_cast<char *>(t_data->buffer.ptr()) + i*t_data->target->block_size;
+				void * write_buf =
+					t_data->target->separate_buffers ? t_data->write_buffer.ptr() : read_buf;
+
+				free_ops[t_data.get()].push_back(io_manager->construct(
+							IAsyncIop::Type::READ,
+							t_data->fd,
+							t_data->target->base_offset,
+							read_buf,
+							write_buf,
+							t_data->target->block_size,
+							thread_id,
+							t_data,
+							0
+							));
+			}
+		}
+
+		// -o limits the ops in flight for the whole thread, as the traced thread had one queue
+		unsigned int max_in_flight = targets[0]->target->overlap;
+		unsigned int in_flight = 0;
+
+		// Unblock main thread (so the job can start the warmup/duration)
+		signal_initialized();
+
+		/************
+		 *	Do Work
+		 ************/
+
+		size_t next = 0;
+		uint64_t loop_start_ns = PerfClock::get_time_ns();
+
+		while(*run_threads) {
+
+			const ReplayOp& r = ops[next];
+			std::shared_ptr<TargetData>& t_data = targets[r.target];
+
+			// can the next traced op be issued now? no op, sync or not, goes before it's due
+			bool ready = false;
+
+			uint64_t due_ns = loop_start_ns + r.time_ns;
+			uint64_t now_ns = PerfClock::get_time_ns();
+
+			if (now_ns < due_ns) {
+				if (!in_flight) {
+					// nothing to reap - sleep until the op is due, but check for the end of the
+					// test at least once a millisecond
+					timespec ts = {0, (long)std::min(due_ns - now_ns, (uint64_t)1000000)};
+					nanosleep(&ts, nullptr);
+					continue;
+				}
+
+			} else if (r.op == TRACE_OP_SYNC) {
+				// a sync waits for all the ops issued before it
+				ready = !in_flight;
+
+			} else {
+				ready = in_flight < max_in_flight;
+			}
+
+			if (ready) {
+
+				if (r.op == TRACE_OP_SYNC) {
+					if (fsync(t_data->fd)) {
+						perror("fsync failed");
+						thread_abort();
+						return;
+					}
+
+				} else {
+					auto& pool = free_ops[t_data.get()];
+					assert(!pool.empty());
+					std::shared_ptr<IAsyncIop> op = pool.back();
+					pool.pop_back();
+
+					off_t offset;
+					size_t nbytes;
+					fit_to_target(*t_data->target, r, offset, nbytes);
+
+					op->set_type(r.op == TRACE_OP_WRITE ? IAsyncIop::Type::WRITE : IAsyncIop::Type::READ);
+					op->set_offset(offset);
+					op->set_nbytes(nbytes);
+					op->set_time(PerfClock::get_time_us());
+
+					aio_result = io_manager->enqueue(op);
+					if (aio_result) {
+						perror("aio enqueue failed");
+						thread_abort();
+						return;
+					}
+					aio_result = io_manager->submit(thread_id);
+					if (aio_result) {
+						perror("aio submit failed");
+						thread_abort();
+						return;
+					}
+					++in_flight;
+				}
+
+				// move on to the next traced op, starting the trace over at the end
+				if (++next == ops.size()) {
+					next = 0;
+					loop_start_ns += trace->loop_ns;
+				}
+				continue;
+			}
+
+			// block until an operation completes
+			std::shared_ptr<IAsyncIop> op = io_manager->wait(thread_id);
+			--in_flight;
+
+			// potentially exit right after waiting for io - improves accuracy of duration
+			if (!*run_threads) break;
+
+			if (!check_completion(op)) {
+				return;
+			}
+
+			if (*record_results) {
+				record_completion(op, PerfClock::get_time_us());
+			}
+
+			free_ops[op->get_target_data().get()].push_back(op);
+		}
+
+		// release resources
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "trace.h"
+
+#ifndef DISKSPD_REPLAY_H
+#define DISKSPD_REPLAY_H
+
+namespace diskspd {
+
+	/**
+	 *	A single traced op, with its time relative to the start of the trace
+	 */
+	struct ReplayOp {
+		uint64_t time_ns;
+		off_t offset;
+		size_t size;
+		unsigned int target;	// index into Trace::paths, which is also the index of the target
+		TraceOp op;
+	};
+
+	/**
+	 *	A trace recorded by libdiskspd_capture.so, loaded for --replay
+	 *	Each traced thread is replayed by one diskspd thread
+	 */
+	struct Trace {
+		std::string file;
+
+		// traced paths, in the order they first appear in the trace
+		std::vector<std::string> paths;
+		// size of the largest op on each path
+		std::vector<size_t> max_op_size;
+
+		// ops for each traced thread, in time order
+		std::vector<std::vector<ReplayOp>> thread_ops;
+
+		// time between the first and last op in the trace
+		uint64_t span_ns = 0;
+		// time between the starts of two iterations of the trace, when it's looped
+		uint64_t loop_ns = 0;
+
+		/**
+		 *	Read a trace file. Prints an error and returns false if it isn't valid
+		 */
+		bool load(const std::string& file);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_REPLAY_H
@@ -2,7 +2,9 @@
 // Licensed under the MIT License.
 
 #include <memory>
+#include <vector>
 #include <utility>
+#include <algorithm>
 #include <cstdio>
 #include <assert.h>
 #include <inttypes.h>
@@ -14,6 +16,53 @@
 
 namespace diskspd {
 
+	/**
+	 *	The results a thread has in a table: one row per target (only the targets in group, if
+	 *	it isn't -1), or the stripe set's, mirror's or erasure coded set's (--stripe, --mirror,
+	 *	--erasure)
+	 */
+	static std::vector<std::shared_ptr<TargetResults>> result_rows(const ThreadResults& thread_result,
+			bool logical, int group) {
+		if (logical) {
+			return { thread_result.logical_results };
+		}
+		if (group < 0) {
+			return thread_result.target_results;
+		}
+		std::vector<std::shared_ptr<TargetResults>> rows;
+		for (auto& t_result : thread_result.target_results) {
+			if (t_result->target->group == (unsigned int)group) {
+				rows.push_back(t_result);
+			}
+		}
+		return rows;
+	}
+
+	/**
+	 *	The seconds the results were measured over: the duration, or with --work, how long
+	 *	the work took
+	 */
+	static double test_seconds(const JobOptions& options, const JobResults& results) {
+		if (options.work || options.scan) {
+			return (double)std::max<uint64_t>(results.work_time_us, 1)/1000000;
+		}
+		return (double)options.duration;
+	}
+
+	/**
+	 *	The groups to print results for: each --group, or -1 for all targets if there are none
+	 */
+	static std::vector<int> result_groups(const JobOptions& options) {
+		if (options.groups.empty()) {
+			return { -1 };
+		}
+		std::vector<int> groups;
+		for (unsigned int g = 0; g <= options.groups.size(); ++g) {
+			groups.push_back(g);
+		}
+		return groups;
+	}
+
 	void ResultFormatterText::output_results(const Profile& profile) {
 		printf("\nCommand Line: %s\n\n", profile.cmd_line.c_str());
 
@@ -24,6 +73,15 @@ namespace diskspd {
 		}
 		printf("\n");
 
+		// --sweep; one table for all the points rather than every Job's results
+		if (profile.sweep) {
+			if (profile.jobs[0]->get_options()->precondition) {
+				print_precondition(profile.jobs[0]);
+			}
+			print_sweep(profile);
+			return;
+		}
+
 		unsigned int jobnum = 1;
 		for (auto& job : profile.jobs) {
 			std::shared_ptr<JobOptions> options = job->get_options();
@@ -32,7 +90,17 @@ namespace diskspd {
 			printf ("\tjob:   %u\n", jobnum);
 			printf ("\t________\n");
 			printf ("\tduration: %us\n", options->duration);
-			printf ("\twarm up time: %us\n", options->warmup_time);
+			if (options->steady) {
+				const SteadyState& steady = *options->steady;
+				printf ("\twarm up time: until steady, at most %us (%u windows of %lums: cv < %g%%, slope < %g%%",
+						options->warmup_time, steady.windows, steady.window_ms, steady.cv, steady.slope);
+				if (options->measure_latency) {
+					printf (", 99th percentile cv < %g%%", steady.latency_cv);
+				}
+				printf (")\n");
+			} else {
+				printf ("\twarm up time: %us\n", options->warmup_time);
+			}
 			if (options->measure_latency) {
 				printf("\tmeasuring latency\n");
 			}
@@ -51,27 +119,185 @@ namespace diskspd {
 			}
 
 			printf("\ttotal threads: %u\n", all_threads);
+			if (options->replay_trace) {
+				printf("\treplaying trace: %s\n", options->replay_trace->file.c_str());
+			}
+			if (!options->chain.empty()) {
+				const char step_names[] = {'r', 'w', 'R', 'W', 'f'};
+				printf("\tdependent chain: ");
+				for (auto step : options->chain) {
+					printf("%c", step_names[step]);
+				}
+				printf("\n");
+			}
+			if (options->lsm) {
+				const LsmTree& lsm = *options->lsm;
+				printf("\temulating LSM tree: table size %lu, data set %lu, fan-in %u\n",
+						lsm.table_size, lsm.data_size, lsm.fanin);
+				printf("\t\tflush rate: %lu B/s, compaction rate: %lu B/s, bloom false positives: %u%%\n",
+						lsm.flush_rate, lsm.compaction_rate, lsm.false_positive_pct);
+			}
+			if (options->stripe) {
+				printf("\tRAID0 striping across %lu targets (stripe unit: %lu, stripe set size: %luB)\n",
+						options->targets.size(), options->stripe->unit, options->stripe->logical->size);
+				printf("\t\toffsets, -w and -o apply to the stripe set\n");
+			}
+			if (options->mirror) {
+				const MirrorSet& mirror = *options->mirror;
+				printf("\tmirroring across %lu targets (write quorum: %lu, mirror size: %luB)\n",
+						options->targets.size(),
+						mirror.quorum ? (size_t)mirror.quorum : options->targets.size(),
+						mirror.logical->size);
+				if (mirror.hedge_percentile) {
+					printf("\t\thedging reads slower than the %gth percentile of first replica reads\n",
+							mirror.hedge_percentile);
+				}
+				printf("\t\toffsets, -w and -o apply to the mirror\n");
+			}
+			if (options->erasure) {
+				const ErasureSet& erasure = *options->erasure;
+				printf("\terasure coding across %lu targets (%u data + %u parity, %s kernels, reading %s)\n",
+						options->targets.size(), erasure.data, erasure.parity,
+						Gf256::simd_name(erasure.simd), erasure.read_any ? "any K" : "the data");
+				printf("\t\toffsets, -w and -o apply to the set; each op covers a block on every member\n");
+			}
+			if (options->groups.size()) {
+				printf("\tworkload groups, running at the same time:\n");
+				printf("\t\tgroup 0: the command line\n");
+				for (size_t g = 0; g < options->groups.size(); ++g) {
+					printf("\t\tgroup %lu: %s\n", g + 1, options->groups[g].c_str());
+				}
+			}
+			if (options->cache) {
+				const BufferCache& cache = *options->cache;
+				printf("\tbuffer cache: %luB (%lu pages of %luB, %s), misses read with O_DIRECT\n",
+						cache.size, cache.size/cache.page_size, cache.page_size,
+						BufferCache::policy_name(cache.policy));
+			}
+			if (options->age) {
+				const FsAging& age = *options->age;
+				printf("\taged to an average extent of %luB or less (up to %u rounds of %u fillers)\n",
+						age.extent_size, age.rounds, age.files);
+			}
+			if (options->work) {
+				const FixedWork& work = *options->work;
+				const char * scope = work.per_target ? "target" : "thread";
+				if (work.unit == FixedWork::PASS) {
+					printf("\tfixed work: a pass over each %s's range%s, in at most %us\n", scope,
+							work.per_target ? "" : "s", options->duration);
+				} else {
+					printf("\tfixed work: %lu %s per %s, in at most %us\n", work.amount,
+							work.unit == FixedWork::OPS ? "ops" : "bytes", scope, options->duration);
+				}
+			}
+			if (options->scan) {
+				printf("\tparallel scan: chunks of %luB, stolen when a thread runs out, in at most %us\n",
+						options->scan->chunk_size, options->duration);
+			}
+			if (options->processes) {
+				printf("\teach thread in a worker process of its own\n");
+			}
+			if (options->precondition) {
+				const Precondition& pre = *options->precondition;
+				printf("\tpreconditioned: %u sequential pass%s of %luB writes, then rounds of %us of "
+						"random %luB writes (up to %u) until %u are steady, at a queue depth of %u\n",
+						pre.passes, pre.passes == 1 ? "" : "es", pre.seq_size, pre.round_s,
+						pre.block_size, pre.rounds, pre.window, pre.qd);
+			}
+			if (options->rate) {
+				const RateLimits& rate = *options->rate;
+				printf("\trate limits:\n");
+				std::pair<const char *, const RateLimits::Limit *> scopes[] = {
+					{ "per target", &rate.target },
+					{ "per thread", &rate.thread },
+					{ "for the job", &rate.job }
+				};
+				for (auto& scope : scopes) {
+					if (scope.second->iops) {
+						printf("\t\t%lu IOPS %s\n", scope.second->iops, scope.first);
+					}
+					if (scope.second->bytes) {
+						printf("\t\t%luB/s %s\n", scope.second->bytes, scope.first);
+					}
+				}
+			}
+			if (options->idle) {
+				const IdleGaps& idle = *options->idle;
+				printf("\tidle gaps: %lums every %lums of I/O, then %u probe op%s one at a time\n",
+						idle.gap_ms, idle.every_ms, idle.probes, idle.probes > 1 ? "s" : "");
+			}
+			if (options->ramp) {
+				const RampSchedule& ramp = *options->ramp;
+				printf("\tthread ramp: %u thread%s, then %u more every %us\n", ramp.start,
+						ramp.start > 1 ? "s" : "", ramp.step, ramp.step_s);
+			}
+			if (options->qd_target) {
+				const QdTarget& qd = *options->qd_target;
+				printf("\tqueue depth target: %g%% of each %lums window under %.3lfms, cut by %g when over\n",
+						qd.pct, qd.window_ms, (double)qd.latency_us/1000, qd.decrease);
+			}
 
 			for (auto& target : options->targets) {
 				printf("\tpath: '%s'\n", target->path.c_str());
 				printf("\t\tsize: %luB\n", target->size);
+				if (options->groups.size()) {
+					printf("\t\tworkload group: %u\n", target->group);
+				}
+				if (options->age && options->age->results.count(target.get())) {
+					const FsAging::Result& aged = options->age->results.at(target.get());
+					printf("\t\taged: %lu extents before, %lu after (average %luB) in %u round%s%s\n",
+							aged.extents_before, aged.extents_after,
+							(target->max_size - target->base_offset)/std::max(aged.extents_after, (uint64_t)1),
+							aged.rounds, aged.rounds == 1 ? "" : "s",
+							aged.reached ? "" : "; not as aged as asked");
+				}
 				if (target->open_flags & O_DIRECT) {
 					printf("\t\tusing O_DIRECT\n");
 				}
 				if (target->open_flags & O_SYNC) {
 					printf("\t\tusing O_SYNC\n");
 				}
-				printf("\t\tperforming mix test (read/write ratio: %u/%u)\n",
-						100-target->write_percentage, target->write_percentage);
-				printf("\t\tblock size: %lu\n", target->block_size);
-				if (target->use_random_alignment) {
-					printf("\t\tusing random I/O (alignment: %lu)\n", target->stride);
-				} else if (target->use_interlocked) {
-					printf("\t\tusing interlocked sequential I/O (stride: %lu)\n", target->stride);
+				if (options->replay_trace) {
+					printf("\t\treplaying traced I/O (largest op: %lu)\n", target->block_size);
+				} else if (options->wal) {
+					printf("\t\twrite-ahead log with group commit (record size: %lu-%lu)\n",
+							options->wal->min_record_size, options->wal->max_record_size);
 				} else {
-					printf("\t\tusing sequential I/O (stride: %lu)\n", target->stride);
+					printf("\t\tperforming mix test (read/write ratio: %u/%u)\n",
+							100-target->write_percentage, target->write_percentage);
+					printf("\t\tblock size: %lu\n", target->block_size);
+					if (target->use_random_alignment) {
+						printf("\t\tusing random I/O (alignment: %lu)\n", target->stride);
+						if (!target->random_dist.empty()) {
+							printf("\t\trandom distribution (IO%%/target%%):");
+							for (auto& range : target->random_dist) {
+								printf(" %u/%u", range.io_percent, range.target_percent);
+							}
+							printf("\n");
+						}
+					} else if (target->use_interlocked) {
+						printf("\t\tusing interlocked sequential I/O (stride: %lu)\n", target->stride);
+					} else {
+						printf("\t\tusing sequential I/O (stride: %lu)\n", target->stride);
+					}
+				}
+				if (options->weights) {
+					const TargetWeights& weights = *options->weights;
+					size_t t = std::find(options->targets.begin(), options->targets.end(), target) -
+						options->targets.begin();
+					printf("\t\tweight: %u", weights.weights[t]);
+					if (weights.max_overlap[t]) {
+						printf(" (up to %u outstanding per thread)", weights.max_overlap[t]);
+					}
+					printf("\n");
+					printf("\t\tnumber of outstanding I/O operations: %u, shared with the other targets)\n",
+							target->overlap);
+				} else {
+					printf("\t\tnumber of outstanding I/O operations: %u)\n", target->overlap);
+				}
+				if (target->max_throughput) {
+					printf("\t\tthroughput limit: %lu bytes/ms per thread\n", target->max_throughput);
 				}
-				printf("\t\tnumber of outstanding I/O operations: %u)\n", target->overlap);
 				if (target->base_offset) {
 					printf("\t\tbase file offset: %lu bytes\n", target->base_offset);
 				}
@@ -98,7 +324,12 @@ namespace diskspd {
 			printf("Results for job %u:\n", jobnum);
 			++jobnum;
 
-			printf("test time:         %us\n", options->duration);
+			if (options->work || options->scan) {
+				printf("test time:         %.3lfs (%s)\n", test_seconds(*options, *results),
+						results->work_done ? "work done" : "work not done in the duration");
+			} else {
+				printf("test time:         %us\n", options->duration);
+			}
 
 			printf("*****************************************************\n\n");
 	
@@ -128,127 +359,935 @@ namespace diskspd {
 
 			/* *************************** IOPs **************************** */
 
-			printf("Total IO\n");
-			print_iops(job, RW);
+			// --group; each workload group has tables of its own
+			for (int group : result_groups(*options)) {
+				std::string prefix = group < 0 ? "" : "Group " + std::to_string(group) + " ";
 
-			printf("Read IO\n");
-			print_iops(job, READ);
+				printf("%sTotal IO\n", prefix.c_str());
+				print_iops(job, RW, false, group);
 
-			printf("Write IO\n");
-			print_iops(job, WRITE);
+				printf("%sRead IO\n", prefix.c_str());
+				print_iops(job, READ, false, group);
 
-			printf("\n");
+				printf("%sWrite IO\n", prefix.c_str());
+				print_iops(job, WRITE, false, group);
+
+				printf("\n");
+			}
+
+			// --stripe, --mirror and --erasure; the same again for the logical ops
+			const char * logical_name = options->stripe ? "stripe set" :
+				options->mirror ? "mirror" : "erasure coded set";
+			bool logical = options->stripe || options->mirror || options->erasure;
+			if (logical) {
+				printf("Logical %s Total IO\n", logical_name);
+				print_iops(job, RW, true);
+
+				printf("Logical %s Read IO\n", logical_name);
+				print_iops(job, READ, true);
+
+				printf("Logical %s Write IO\n", logical_name);
+				print_iops(job, WRITE, true);
+
+				printf("\n");
+			}
+
+			if (options->mirror) {
+				print_mirror(job);
+			}
+
+			if (options->erasure) {
+				print_erasure(job);
+			}
+
+			if (options->cache) {
+				print_cache(job);
+			}
+
+			if (options->idle) {
+				print_idle(job);
+			}
+
+			if (options->qd_target) {
+				print_qd(job);
+			}
+
+			if (options->work) {
+				print_work(job);
+			}
+
+			if (options->scan) {
+				print_scan(job);
+			}
+
+			if (options->precondition) {
+				print_precondition(job);
+			}
+
+			if (options->steady) {
+				print_steady(job);
+			}
+
+			if (options->ramp) {
+				print_ramp(job);
+			}
+
+			if (!options->chain.empty()) {
+				print_chains(job);
+			}
+
+			if (options->lsm) {
+				print_lsm(job);
+			}
+
+			if (options->wal) {
+				print_wal(job);
+			}
 
 			/* *************************** Latency %-iles **************************** */
 
 			if (!options->measure_latency) return;
-			// create histograms accumulating all reads and write
-			Histogram<uint64_t> read_histogram;
-			Histogram<uint64_t> write_histogram;
-			Histogram<uint64_t> total_histogram;
-
-			for (auto& thread_result : results->thread_results) {
-				for (auto& t_result : thread_result->target_results) {
-					read_histogram.Merge(t_result->read_latency_histogram);
-					write_histogram.Merge(t_result->write_latency_histogram);
 
-					total_histogram.Merge(read_histogram);
-					total_histogram.Merge(write_histogram);
+			for (int group : result_groups(*options)) {
+				if (group >= 0) {
+					printf("Group %d\n", group);
 				}
+				print_percentiles(job, false, group);
 			}
 
-			// make sure there are reads/writes to get
-			bool has_reads = read_histogram.GetSampleSize() > 0;
-			bool has_writes = write_histogram.GetSampleSize() > 0;
+			if (logical) {
+				printf("Logical %s\n", logical_name);
+				print_percentiles(job, true);
+			}
+		}
+	}
+
+	void ResultFormatterText::print_percentiles(const std::shared_ptr<Job>& job, bool logical,
+			int group) {
+
+		std::shared_ptr<JobResults> results = job->get_results();
+
+		// create histograms accumulating all reads and write
+		Histogram<uint64_t> read_histogram;
+		Histogram<uint64_t> write_histogram;
+		Histogram<uint64_t> total_histogram;
+
+		for (auto& thread_result : results->thread_results) {
+			for (auto& t_result : result_rows(*thread_result, logical, group)) {
+				read_histogram.Merge(t_result->read_latency_histogram);
+				write_histogram.Merge(t_result->write_latency_histogram);
+
+				total_histogram.Merge(t_result->read_latency_histogram);
+				total_histogram.Merge(t_result->write_latency_histogram);
+			}
+		}
 
-			// buffers for snprintf
-			char readbuf[11] = {0};
-			char writebuf[11] = {0};
-			char * na = (char*)"N/A";
+		// make sure there are reads/writes to get
+		bool has_reads = read_histogram.GetSampleSize() > 0;
+		bool has_writes = write_histogram.GetSampleSize() > 0;
 
-			// pointers that either point to the buffer or na at any given time
-			char * readstr = na;
-			char * writestr = na;
+		// buffers for snprintf
+		char readbuf[11] = {0};
+		char writebuf[11] = {0};
+		char * na = (char*)"N/A";
 
-			printf("  %%-ile |	Read (ms) | Write (ms) | Total (ms)\n");
-			printf("----------------------------------------------\n");
+		// pointers that either point to the buffer or na at any given time
+		char * readstr = na;
+		char * writestr = na;
+
+		printf("  %%-ile |	Read (ms) | Write (ms) | Total (ms)\n");
+		printf("----------------------------------------------\n");
+
+		readstr = has_reads ?
+			snprintf(readbuf, 11, "%10.3lf", (double)read_histogram.GetMin()/1000), readbuf :
+			na;
+
+		writestr = has_writes ?
+			snprintf(writebuf, 11, "%10.3lf", (double)write_histogram.GetMin()/1000), writebuf :
+			na;
+
+
+		printf("    min | %10s | %10s | %10.3lf\n",
+				readstr,
+				writestr,
+				(double)total_histogram.GetMin()/1000
+			  );
+
+		std::pair<double, std::string> percentiles[] = {
+			{		0.25, "25th"	},
+			{		0.50, "50th"	},
+			{		0.75, "75th"	},
+			{		0.90, "90th"	},
+			{		0.95, "95th"	},
+			{		0.99, "99th"	},
+			{	   0.999, "3-nines" },
+			{	  0.9999, "4-nines" },
+			{	 0.99999, "5-nines" },
+			{	0.999999, "6-nines" },
+			{  0.9999999, "7-nines" },
+			{ 0.99999999, "8-nines" },
+			{ 0.999999999, "9-nines"}
+		};
+
+		for (auto& p : percentiles)
+		{
 
 			readstr = has_reads ?
-				snprintf(readbuf, 11, "%10.3lf", (double)read_histogram.GetMin()/1000), readbuf :
+				snprintf(
+						readbuf,
+						11,
+						"%10.3lf",
+						(double)read_histogram.GetPercentile(p.first)/1000
+						), readbuf :
 				na;
 
 			writestr = has_writes ?
-				snprintf(writebuf, 11, "%10.3lf", (double)write_histogram.GetMin()/1000), writebuf :
+				snprintf(
+						writebuf,
+						11,
+						"%10.3lf",
+						(double)write_histogram.GetPercentile(p.first)/1000
+						), writebuf :
 				na;
 
-
-			printf("    min | %10s | %10s | %10.3lf\n",
+			printf("%7s | %10s | %10s | %10.3lf\n",
+					p.second.c_str(),
 					readstr,
 					writestr,
-					(double)total_histogram.GetMin()/1000
+					(double)total_histogram.GetPercentile(p.first)/1000
 				  );
+		}
+
+		readstr = has_reads ?
+			snprintf(readbuf, 11, "%10.3lf", (double)read_histogram.GetMax()/1000), readbuf :
+			na;
+
+		writestr = has_writes ?
+			snprintf(writebuf, 11, "%10.3lf", (double)write_histogram.GetMax()/1000), writebuf :
+			na;
+
+		printf("    max | %10s | %10s | %10.3lf\n",
+				readstr,
+				writestr,
+				(double)total_histogram.GetMax()/1000
+			  );
+
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_chains(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+
+		printf("Chains\n");
+		printf("thread |       chains |  chains per s |%s file\n",
+				options->measure_latency ? " AvgLat(ms) | LatStdDev  |" : "");
+		printf("-----------------------------------------------%s\n",
+				options->measure_latency ? "--------------------------" : "");
+
+		uint64_t total_chains = 0;
+		Histogram<uint64_t> total_histogram;
+
+		for (auto& thread_result : results->thread_results) {
+			for (auto& t_result : thread_result->target_results) {
+
+				printf("%6d | %12lu | %13.2lf ",
+						thread_result->thread_id,
+						t_result->chain_count,
+						(double)t_result->chain_count/(double)options->duration);
+
+				if (options->measure_latency) {
+					const Histogram<uint64_t>& h = t_result->chain_latency_histogram;
+					if (h.GetSampleSize() > 0) {
+						printf("|    %8.3lf |    %8.3lf ",
+								(double)h.GetAvg()/1000.0, (double)h.GetStdDev()/1000.0);
+					} else {
+						printf("|        N/A |        N/A ");
+					}
+					total_histogram.Merge(h);
+				}
+				total_chains += t_result->chain_count;
+
+				printf("| %s (%luB)\n", t_result->target->path.c_str(), t_result->target->size);
+			}
+		}
+
+		printf("-----------------------------------------------%s\n",
+				options->measure_latency ? "--------------------------" : "");
+		printf("total: %14lu | %13.2lf ",
+				total_chains, (double)total_chains/(double)options->duration);
+		if (options->measure_latency && total_histogram.GetSampleSize() > 0) {
+			printf("|    %8.3lf |    %8.3lf ",
+					(double)total_histogram.GetAvg()/1000.0, (double)total_histogram.GetStdDev()/1000.0);
+		}
+		printf("\n");
+
+		// the tail of dependent chains is what the individual op latencies can't show
+		if (options->measure_latency && total_histogram.GetSampleSize() > 0) {
+			printf("chain latency (ms): 50th %.3lf | 99th %.3lf | 3-nines %.3lf | max %.3lf\n",
+					(double)total_histogram.GetPercentile(0.50)/1000,
+					(double)total_histogram.GetPercentile(0.99)/1000,
+					(double)total_histogram.GetPercentile(0.999)/1000,
+					(double)total_histogram.GetMax()/1000);
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_lsm(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		LsmTree& lsm = *options->lsm;
+
+		double duration = (double)options->duration;
+
+		// threads 0 and 1 are the flush and compaction threads, the rest do lookups
+		uint64_t flush_bytes = 0;
+		uint64_t compaction_read_bytes = 0;
+		uint64_t compaction_write_bytes = 0;
+		uint64_t lookups = 0;
+		uint64_t lookup_reads = 0;
+		Histogram<uint64_t> lookup_histogram;
+
+		for (auto& thread_result : results->thread_results) {
+			for (auto& t_result : thread_result->target_results) {
+				if (thread_result->thread_id == 0) {
+					flush_bytes += t_result->write_bytes_count;
+				} else if (thread_result->thread_id == 1) {
+					compaction_read_bytes += t_result->read_bytes_count;
+					compaction_write_bytes += t_result->write_bytes_count;
+				} else {
+					lookups += t_result->chain_count;
+					lookup_reads += t_result->read_iops_count;
+					lookup_histogram.Merge(t_result->chain_latency_histogram);
+				}
+			}
+		}
+
+		printf("LSM tree\n");
+		printf("\tbackground:\n");
+		printf("\t\tflushes: %lu (%.2lf MB/s)\n",
+				lsm.flushes.load(), flush_bytes/(1<<20)/duration);
+		printf("\t\tcompactions: %lu (read %.2lf MB/s, write %.2lf MB/s)\n",
+				lsm.compactions.load(),
+				compaction_read_bytes/(1<<20)/duration,
+				compaction_write_bytes/(1<<20)/duration);
+		if (flush_bytes) {
+			printf("\t\twrite amplification: %.2lf\n",
+					(double)(flush_bytes + compaction_write_bytes)/flush_bytes);
+		}
+
+		unsigned int tables = 0;
+		for (auto& level : lsm.final_tables) {
+			tables += level.second;
+		}
+		printf("\t\ttables at end: %u (", tables);
+		for (auto& level : lsm.final_tables) {
+			if (level.first == LsmTable::BASE_LEVEL) {
+				printf("base: %u)\n", level.second);
+			} else {
+				printf("L%u: %u, ", level.first, level.second);
+			}
+		}
+
+		printf("\tforeground:\n");
+		printf("\t\tlookups: %lu (%.2lf per s), reads per lookup: %.3lf\n",
+				lookups, lookups/duration, lookups ? (double)lookup_reads/lookups : 0.0);
+		if (options->measure_latency && lookup_histogram.GetSampleSize() > 0) {
+			printf("\t\tlookup latency (ms): avg %.3lf | 50th %.3lf | 99th %.3lf | 3-nines %.3lf | max %.3lf\n",
+					lookup_histogram.GetAvg()/1000,
+					(double)lookup_histogram.GetPercentile(0.50)/1000,
+					(double)lookup_histogram.GetPercentile(0.99)/1000,
+					(double)lookup_histogram.GetPercentile(0.999)/1000,
+					(double)lookup_histogram.GetMax()/1000);
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_wal(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const WalLog& wal = *options->wal;
+
+		double duration = (double)options->duration;
+
+		Histogram<uint64_t> commit_histogram;
+		for (auto& thread_result : results->thread_results) {
+			for (auto& t_result : thread_result->target_results) {
+				commit_histogram.Merge(t_result->chain_latency_histogram);
+			}
+		}
+
+		printf("Group commit\n");
+		printf("\tcommits: %lu (%.2lf per s, %.2lf MB/s of records)\n",
+				wal.records, wal.records/duration, wal.record_bytes/(1<<20)/duration);
+		printf("\tbatches: %lu (%.2lf per s)\n", wal.batches, wal.batches/duration);
+
+		if (wal.batch_histogram.GetSampleSize() > 0) {
+			printf("\trecords per batch: avg %.2lf | min %lu | 50th %lu | 90th %lu | 99th %lu | max %lu\n",
+					wal.batch_histogram.GetAvg(),
+					wal.batch_histogram.GetMin(),
+					wal.batch_histogram.GetPercentile(0.50),
+					wal.batch_histogram.GetPercentile(0.90),
+					wal.batch_histogram.GetPercentile(0.99),
+					wal.batch_histogram.GetMax());
+		}
+		if (options->measure_latency && commit_histogram.GetSampleSize() > 0) {
+			printf("\tcommit latency (ms): avg %.3lf | 50th %.3lf | 99th %.3lf | 3-nines %.3lf | max %.3lf\n",
+					commit_histogram.GetAvg()/1000,
+					(double)commit_histogram.GetPercentile(0.50)/1000,
+					(double)commit_histogram.GetPercentile(0.99)/1000,
+					(double)commit_histogram.GetPercentile(0.999)/1000,
+					(double)commit_histogram.GetMax()/1000);
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_mirror(const std::shared_ptr<Job>& job) {
 
-			std::pair<double, std::string> percentiles[] = {
-				{		0.25, "25th"	},
-				{		0.50, "50th"	},
-				{		0.75, "75th"	},
-				{		0.90, "90th"	},
-				{		0.95, "95th"	},
-				{		0.99, "99th"	},
-				{	   0.999, "3-nines" },
-				{	  0.9999, "4-nines" },
-				{	 0.99999, "5-nines" },
-				{	0.999999, "6-nines" },
-				{  0.9999999, "7-nines" },
-				{ 0.99999999, "8-nines" },
-				{ 0.999999999, "9-nines"}
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const MirrorSet& mirror = *options->mirror;
+
+		MirrorResults total;
+		Histogram<uint64_t> hedged_histogram;
+		double deadline_ms = 0;
+
+		for (auto& thread_result : results->thread_results) {
+			const MirrorResults& r = *thread_result->mirror_results;
+			total.reads += r.reads;
+			total.hedges += r.hedges;
+			total.hedge_wins += r.hedge_wins;
+			total.cancelled += r.cancelled;
+			total.primary_latency_histogram.Merge(r.primary_latency_histogram);
+			hedged_histogram.Merge(thread_result->logical_results->read_latency_histogram);
+			deadline_ms += (double)r.deadline_us/1000/results->thread_results.size();
+		}
+
+		printf("Hedged reads\n");
+		if (mirror.hedge_percentile) {
+			printf("\tdeadline: %gth percentile of the last %lu first replica reads (%.3lfms per thread at the end)\n",
+					mirror.hedge_percentile, MirrorSet::HEDGE_WINDOW, deadline_ms);
+		} else {
+			printf("\tdeadline: none; reads aren't hedged\n");
+		}
+		printf("\treads: %lu | hedged: %lu (%.2lf%%) | hedge finished first: %lu | losers cancelled: %lu\n",
+				total.reads,
+				total.hedges,
+				total.reads ? 100.0*total.hedges/total.reads : 0.0,
+				total.hedge_wins,
+				total.cancelled);
+		printf("\textra load: %.2lf%% more reads, %.2lf MB/s\n",
+				total.reads ? 100.0*total.hedges/total.reads : 0.0,
+				(double)total.hedges*mirror.logical->block_size/(1<<20)/options->duration);
+
+		if (options->measure_latency && hedged_histogram.GetSampleSize() > 0 &&
+				total.primary_latency_histogram.GetSampleSize() > 0) {
+
+			std::pair<const char *, const Histogram<uint64_t> *> rows[] = {
+				{ "first replica", &total.primary_latency_histogram },
+				{ "with hedging", &hedged_histogram }
 			};
+			printf("\tread latency (ms) |     50th |     90th |     99th |  3-nines |  4-nines |      max\n");
+			for (auto& row : rows) {
+				printf("\t%17s | %8.3lf | %8.3lf | %8.3lf | %8.3lf | %8.3lf | %8.3lf\n",
+						row.first,
+						(double)row.second->GetPercentile(0.50)/1000,
+						(double)row.second->GetPercentile(0.90)/1000,
+						(double)row.second->GetPercentile(0.99)/1000,
+						(double)row.second->GetPercentile(0.999)/1000,
+						(double)row.second->GetPercentile(0.9999)/1000,
+						(double)row.second->GetMax()/1000);
+			}
+			if (total.cancelled) {
+				printf("\t(first replica reads that were cancelled aren't included)\n");
+			}
+		}
+		printf("\n");
+	}
 
-			for (auto& p : percentiles)
-			{
-
-				readstr = has_reads ?
-					snprintf(
-							readbuf,
-							11,
-							"%10.3lf",
-							(double)read_histogram.GetPercentile(p.first)/1000
-							), readbuf :
-					na;
-
-				writestr = has_writes ?
-					snprintf(
-							writebuf,
-							11,
-							"%10.3lf",
-							(double)write_histogram.GetPercentile(p.first)/1000
-							), writebuf :
-					na;
-
-				printf("%7s | %10s | %10s | %10.3lf\n",
-						p.second.c_str(),
-						readstr,
-						writestr,
-						(double)total_histogram.GetPercentile(p.first)/1000
-					  );
+	void ResultFormatterText::print_erasure(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const ErasureSet& erasure = *options->erasure;
+
+		ErasureResults total;
+		for (auto& thread_result : results->thread_results) {
+			const ErasureResults& r = *thread_result->erasure_results;
+			total.encodes += r.encodes;
+			total.encode_bytes += r.encode_bytes;
+			total.encode_cycles += r.encode_cycles;
+			total.reads += r.reads;
+			total.decodes += r.decodes;
+			total.decode_bytes += r.decode_bytes;
+			total.decode_cycles += r.decode_cycles;
+			total.rebuilt_chunks += r.rebuilt_chunks;
+		}
+
+		printf("Erasure coding (%u+%u, %s kernels)\n", erasure.data, erasure.parity,
+				Gf256::simd_name(erasure.simd));
+		printf("\tencode: %lu stripes | %.2lf MiB of data | %.3lf cycles/byte\n",
+				total.encodes,
+				(double)total.encode_bytes/(1<<20),
+				total.encode_bytes ? (double)total.encode_cycles/total.encode_bytes : 0.0);
+		printf("\tdecode: %lu of %lu reads rebuilt data (%.2lf%%), %lu chunks | %.2lf MiB of data | %.3lf cycles/byte\n",
+				total.decodes,
+				total.reads,
+				total.reads ? 100.0*total.decodes/total.reads : 0.0,
+				total.rebuilt_chunks,
+				(double)total.decode_bytes/(1<<20),
+				total.decode_bytes ? (double)total.decode_cycles/total.decode_bytes : 0.0);
+		printf("\t(cycles are TSC cycles per byte of data in the stripes encoded or rebuilt)\n");
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_cache(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+
+		CacheResults total;
+		for (auto& thread_result : results->thread_results) {
+			const CacheResults& r = *thread_result->cache_results;
+			total.hits += r.hits;
+			total.misses += r.misses;
+			total.hit_bytes += r.hit_bytes;
+			total.miss_bytes += r.miss_bytes;
+			total.hit_latency_histogram.Merge(r.hit_latency_histogram);
+			total.miss_latency_histogram.Merge(r.miss_latency_histogram);
+		}
+
+		uint64_t reads = total.hits + total.misses;
+		printf("Buffer cache\n");
+		printf("\treads: %lu | hits: %lu | misses: %lu | hit ratio: %.2lf%%\n",
+				reads,
+				total.hits,
+				total.misses,
+				reads ? 100.0*total.hits/reads : 0.0);
+		printf("\tread I/O per s: %.2lf from the application, %.2lf to the targets (%.2lf MB/s)\n",
+				(double)reads/options->duration,
+				(double)total.misses/options->duration,
+				(double)total.miss_bytes/(1<<20)/options->duration);
+
+		if (options->measure_latency) {
+			std::pair<const char *, const Histogram<uint64_t> *> rows[] = {
+				{ "hits", &total.hit_latency_histogram },
+				{ "misses", &total.miss_latency_histogram }
+			};
+			printf("\tread latency (us) |      avg |     50th |     90th |     99th |  3-nines |      max\n");
+			for (auto& row : rows) {
+				if (!row.second->GetSampleSize()) continue;
+				printf("\t%17s | %8.3lf | %8.3lf | %8.3lf | %8.3lf | %8.3lf | %8.3lf\n",
+						row.first,
+						row.second->GetAvg()/1000,
+						(double)row.second->GetPercentile(0.50)/1000,
+						(double)row.second->GetPercentile(0.90)/1000,
+						(double)row.second->GetPercentile(0.99)/1000,
+						(double)row.second->GetPercentile(0.999)/1000,
+						(double)row.second->GetMax()/1000);
 			}
+		}
+		printf("\n");
+	}
 
-			readstr = has_reads ?
-				snprintf(readbuf, 11, "%10.3lf", (double)read_histogram.GetMax()/1000), readbuf :
-				na;
+	void ResultFormatterText::print_idle(const std::shared_ptr<Job>& job) {
 
-			writestr = has_writes ?
-				snprintf(writebuf, 11, "%10.3lf", (double)write_histogram.GetMax()/1000), writebuf :
-				na;
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
 
-			printf("    max | %10s | %10s | %10.3lf\n",
-					readstr,
-					writestr,
-					(double)total_histogram.GetMax()/1000
-				  );
+		IdleResults total;
+		Histogram<uint64_t> steady_histogram;
+		for (auto& thread_result : results->thread_results) {
+			const IdleResults& r = *thread_result->idle_results;
+			total.gaps += r.gaps;
+			total.first_latency_histogram.Merge(r.first_latency_histogram);
+			total.later_latency_histogram.Merge(r.later_latency_histogram);
+
+			for (auto& t_result : thread_result->target_results) {
+				steady_histogram.Merge(t_result->read_latency_histogram);
+				steady_histogram.Merge(t_result->write_latency_histogram);
+			}
+		}
+
+		printf("Idle gaps\n");
+		printf("\tgaps: %lu of %lums\n", total.gaps, options->idle->gap_ms);
+
+		std::pair<const char *, const Histogram<uint64_t> *> rows[] = {
+			{ "first after idle", &total.first_latency_histogram },
+			{ "later probes", &total.later_latency_histogram },
+			{ "steady state", &steady_histogram }
+		};
+		printf("\t    latency (ms) |      avg |     50th |     90th |     99th |      max\n");
+		for (auto& row : rows) {
+			// the steady state ops only have latencies with -L
+			if (!row.second->GetSampleSize()) continue;
+			printf("\t%16s | %8.3lf | %8.3lf | %8.3lf | %8.3lf | %8.3lf\n",
+					row.first,
+					row.second->GetAvg()/1000,
+					(double)row.second->GetPercentile(0.50)/1000,
+					(double)row.second->GetPercentile(0.90)/1000,
+					(double)row.second->GetPercentile(0.99)/1000,
+					(double)row.second->GetMax()/1000);
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_qd(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const QdTarget& qd = *options->qd_target;
+
+		printf("Queue depth (%g percentile under %.3lfms)\n", qd.pct, (double)qd.latency_us/1000);
+		printf("\tthread | final QD |   avg QD | windows |     over | last pct (ms) |       I/O per s\n");
+
+		QdResults total;
+		double total_avg_qd = 0;
+		uint64_t total_iops = 0;
+		for (auto& thread_result : results->thread_results) {
+			const QdResults& r = *thread_result->qd_results;
+			uint64_t iops = 0;
+			for (auto& t_result : thread_result->target_results) {
+				iops += t_result->iops_count;
+			}
+			double avg_qd = r.windows ? (double)r.qd_sum/r.windows : 0.0;
+			printf("\t%6u | %8u | %8.2lf | %7lu | %8lu | %13.3lf | %15.2lf\n",
+					thread_result->thread_id,
+					r.final_qd,
+					avg_qd,
+					r.windows,
+					r.windows_over,
+					(double)r.last_latency_us/1000,
+					(double)iops/options->duration);
+			total.final_qd += r.final_qd;
+			total.windows += r.windows;
+			total_avg_qd += avg_qd;
+			total.windows_over += r.windows_over;
+			total_iops += iops;
+		}
+		printf("\t total | %8u | %8.2lf | %7lu | %8lu | %13s | %15.2lf\n",
+				total.final_qd,
+				total_avg_qd,
+				total.windows,
+				total.windows_over,
+				"",
+				(double)total_iops/options->duration);
+		if (!total.windows) {
+			printf("\t(no window ended in the measured duration; try a longer -d or a shorter window)\n");
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_ramp(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const RampSchedule& ramp = *options->ramp;
+
+		printf("Thread ramp (%us per step)\n", ramp.step_s);
+		printf("\t step | threads |       MB/s |  I/O per s |  CPU%%");
+		if (options->measure_latency) {
+			printf(" | AvgLat(ms) |   99th(ms)");
+		}
+		printf("\n");
+
+		for (unsigned int s = 0; s < results->ramp_cpu_usage.size(); ++s) {
+			RampResults::Step total;
+			for (auto& thread_result : results->thread_results) {
+				const RampResults::Step& step = thread_result->ramp_results->steps[s];
+				total.ops += step.ops;
+				total.bytes += step.bytes;
+				total.latency_histogram.Merge(step.latency_histogram);
+			}
+
+			printf("\t%5u | %7u | %10.2lf | %10.2lf | %5.1lf",
+					s + 1,
+					ramp.threads(s, options->total_threads),
+					(double)total.bytes/(1<<20)/ramp.step_s,
+					(double)total.ops/ramp.step_s,
+					results->ramp_cpu_usage[s]*100);
+			if (options->measure_latency) {
+				bool samples = total.latency_histogram.GetSampleSize() != 0;
+				printf(" | %10.3lf | %10.3lf",
+						samples ? total.latency_histogram.GetAvg()/1000 : 0.0,
+						samples ? (double)total.latency_histogram.GetPercentile(0.99)/1000 : 0.0);
+			}
+			printf("\n");
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_steady(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const SteadyResults& steady_results = *results->steady_results;
+
+		printf("Steady state warm up (%lums windows)\n", options->steady->window_ms);
+		printf("\t%s after %.1lfs\n", steady_results.reached ? "reached" : "not reached",
+				(double)steady_results.warmup_ms/1000);
+		printf("\twindow |  I/O per s");
+		if (options->measure_latency) {
+			printf(" |   99th(ms)");
+		}
+		printf("\n");
 
+		for (unsigned int w = 0; w < steady_results.windows.size(); ++w) {
+			printf("\t%6u | %10.2lf", w + 1, steady_results.windows[w].iops);
+			if (options->measure_latency) {
+				printf(" | %10.3lf", (double)steady_results.windows[w].p99_us/1000);
+			}
 			printf("\n");
 		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_work(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+		const FixedWork& work = *options->work;
+
+		// each share of the work, its size, what was done of it and when it was all done
+		struct Share {
+			std::string name;
+			uint64_t quota;
+			uint64_t done;
+			uint64_t finished_us;
+		};
+		std::vector<Share> shares;
+		if (work.per_target) {
+			for (auto& target : options->targets) {
+				const FixedWork::Progress& progress = *work.targets.at(target.get());
+				shares.push_back({ target->path, progress.quota,
+						std::min(progress.done.load(), progress.quota), progress.finished_us.load() });
+			}
+		} else {
+			for (auto& thread_result : results->thread_results) {
+				uint64_t quota = work.amount;
+				if (work.unit == FixedWork::PASS) {
+					quota = 0;
+					for (auto& t_result : thread_result->target_results) {
+						quota += work.quota(*t_result->target);
+					}
+				}
+				shares.push_back({ "thread " + std::to_string(thread_result->thread_id), quota,
+						std::min(thread_result->work_results->done, quota),
+						thread_result->work_results->finished_us });
+			}
+		}
+
+		double seconds = test_seconds(*options, *results);
+		printf("Fixed work (%s)\n", results->work_done ? "done" : "not done in the duration");
+		printf("\t%s: %.3lfs\n", results->work_done ? "time to complete" : "ran for", seconds);
+		printf("\t%15s |   done |   time(s) | %s\n", work.unit == FixedWork::OPS ? "ops" : "bytes",
+				work.per_target ? "target" : "thread");
+		for (auto& share : shares) {
+			printf("\t%15lu | %5.1lf%% | ", share.quota, (double)share.done*100/share.quota);
+			if (share.finished_us) {
+				printf("%9.3lf", (double)(share.finished_us - options->start_time_us)/1000000);
+			} else {
+				printf("%9s", "-");
+			}
+			printf(" | %s\n", share.name.c_str());
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_scan(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		std::shared_ptr<JobResults> results = job->get_results();
+
+		uint64_t chunks = 0;
+		uint64_t first_us = 0;
+		uint64_t last_us = 0;
+		for (auto& thread_result : results->thread_results) {
+			const ScanResults& scan_results = *thread_result->scan_results;
+			chunks += scan_results.chunks;
+			if (scan_results.finished_us) {
+				first_us = first_us ? std::min(first_us, scan_results.finished_us) : scan_results.finished_us;
+				last_us = std::max(last_us, scan_results.finished_us);
+			}
+		}
+
+		printf("Parallel scan (%s)\n", results->work_done ? "done" : "not done in the duration");
+		printf("\tchunks taken: %lu of %lu\n", chunks, options->scan->size());
+		printf("\t%s: %.3lfs", results->work_done ? "time to complete" : "ran for",
+				test_seconds(*options, *results));
+		if (results->work_done) {
+			// how long the first thread to run out had to wait for the last
+			printf(" (tail: %.3lfs)", (double)(last_us - first_us)/1000000);
+		}
+		printf("\n");
+		printf("\tthread |   chunks |   stolen |   done(s)\n");
+		for (auto& thread_result : results->thread_results) {
+			const ScanResults& scan_results = *thread_result->scan_results;
+			printf("\t%6u | %8lu | %8lu | ", thread_result->thread_id, scan_results.chunks,
+					scan_results.stolen);
+			if (scan_results.finished_us) {
+				printf("%9.3lf\n", (double)(scan_results.finished_us - options->start_time_us)/1000000);
+			} else {
+				printf("%9s\n", "-");
+			}
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_precondition(const std::shared_ptr<Job>& job) {
+
+		std::shared_ptr<JobOptions> options = job->get_options();
+		const Precondition& pre = *options->precondition;
+
+		printf("Preconditioning (steady: %u rounds within %g%% of their average, trend under %g%%)\n",
+				pre.window, pre.range, pre.slope);
+		for (auto& target : options->targets) {
+			if (!pre.results.count(target.get())) continue;
+			const Precondition::Result& result = pre.results.at(target.get());
+
+			printf("\t%s\n", target->path.c_str());
+			for (unsigned int p = 0; p < result.pass_ms.size(); ++p) {
+				printf("\t\tsequential pass %u: %.1lfs\n", p + 1, (double)result.pass_ms[p]/1000);
+			}
+			size_t rounds = result.round_iops.size();
+			if (!rounds) continue;
+			printf("\t\t%s after %lu round%s\n", result.reached ? "steady" : "not steady",
+					rounds, rounds == 1 ? "" : "s");
+			printf("\t\tround |  I/O per s\n");
+			for (size_t r = 0; r < rounds; ++r) {
+				// the rounds steady state was judged on
+				bool in_window = result.reached && r + pre.window >= rounds;
+				printf("\t\t%5lu | %10.2lf%s\n", r + 1, result.round_iops[r], in_window ? " *" : "");
+			}
+		}
+		printf("\n");
+	}
+
+	void ResultFormatterText::print_sweep(const Profile& profile) {
+
+		const ParamSweep& sweep = *profile.sweep;
+		bool latency = profile.jobs[0]->get_options()->measure_latency;
+
+		FILE * csv = nullptr;
+		if (!sweep.csv_path.empty()) {
+			csv = fopen(sweep.csv_path.c_str(), "w");
+			if (!csv) {
+				fprintf(stderr, "Failed to open --sweep csv file %s\n", sweep.csv_path.c_str());
+			} else {
+				for (auto& setting : sweep.queue_settings(0)) {
+					fprintf(csv, "%s,", setting.first.c_str());
+				}
+				fprintf(csv, "block_size,queue_depth,threads,write_percent,mb_per_s,iops,"
+						"avg_latency_ms,p99_latency_ms,cpu_percent\n");
+			}
+		}
+
+		// the swept queue settings come first, each as wide as its name or longest value
+		std::vector<int> widths;
+		for (auto& param : sweep.queue_params) {
+			if (param.second.empty()) continue;
+			size_t width = param.first.size();
+			for (auto& value : param.second) {
+				width = std::max(width, value.size());
+			}
+			widths.push_back(width);
+		}
+
+		printf("Sweep of %lu points (duration: %us, warm up time: %us each)\n", profile.jobs.size(),
+				profile.jobs[0]->get_options()->duration,
+				profile.jobs[0]->get_options()->warmup_time);
+		printf("\tpoint |");
+		std::vector<std::pair<std::string, std::string>> queue_settings = sweep.queue_settings(0);
+		for (size_t i = 0; i < queue_settings.size(); ++i) {
+			printf(" %*s |", widths[i], queue_settings[i].first.c_str());
+		}
+		printf("    block |  QD | threads | write%% |       MB/s |  I/O per s |  CPU%%");
+		if (latency) {
+			printf(" | AvgLat(ms) |   99th(ms)");
+		}
+		printf("\n");
+
+		unsigned int point = 1;
+		for (auto& job : profile.jobs) {
+			std::shared_ptr<JobOptions> options = job->get_options();
+			std::shared_ptr<JobResults> results = job->get_results();
+
+			// the points only differ in the command line's own options, which every target
+			// outside a --group has, or the logical target of --stripe, --mirror or --erasure
+			std::shared_ptr<Target> logical = options->stripe ? options->stripe->logical :
+				options->mirror ? options->mirror->logical :
+				options->erasure ? options->erasure->logical : nullptr;
+			const Target& target = logical ? *logical : *options->targets[0];
+			unsigned int threads = options->use_total_threads ?
+				options->total_threads : options->targets[0]->threads_per_target;
+
+			uint64_t bytes = 0;
+			uint64_t iops = 0;
+			Histogram<uint64_t> latency_histogram;
+			for (auto& thread_result : results->thread_results) {
+				for (auto& t_result : thread_result->target_results) {
+					bytes += t_result->bytes_count;
+					iops += t_result->iops_count;
+					latency_histogram.Merge(t_result->read_latency_histogram);
+					latency_histogram.Merge(t_result->write_latency_histogram);
+				}
+			}
+
+			double cpu = 0;
+			for (auto& usage : results->cpu_usage_percentages) {
+				cpu += usage.second[0]*100;
+			}
+			cpu /= std::max<size_t>(results->cpu_usage_percentages.size(), 1);
+
+			double mb_per_s = (double)bytes/(1<<20)/test_seconds(*options, *results);
+			double iops_per_s = (double)iops/test_seconds(*options, *results);
+			bool samples = latency_histogram.GetSampleSize() != 0;
+			double avg_ms = samples ? latency_histogram.GetAvg()/1000 : 0.0;
+			double p99_ms = samples ? (double)latency_histogram.GetPercentile(0.99)/1000 : 0.0;
+
+			queue_settings = sweep.queue_settings(point - 1);
+			printf("\t%5u |", point++);
+			for (size_t i = 0; i < queue_settings.size(); ++i) {
+				printf(" %*s |", widths[i], queue_settings[i].second.c_str());
+			}
+			printf(" %8lu | %3u | %7u | %6u | %10.2lf | %10.2lf | %5.1lf",
+					target.block_size,
+					target.overlap,
+					threads,
+					target.write_percentage,
+					mb_per_s,
+					iops_per_s,
+					cpu);
+			if (latency) {
+				printf(" | %10.3lf | %10.3lf", avg_ms, p99_ms);
+			}
+			printf("\n");
+
+			if (csv) {
+				for (auto& setting : queue_settings) {
+					fprintf(csv, "%s,", setting.second.c_str());
+				}
+				fprintf(csv, "%lu,%u,%u,%u,%.2lf,%.2lf,", target.block_size, target.overlap, threads,
+						target.write_percentage, mb_per_s, iops_per_s);
+				if (latency) {
+					fprintf(csv, "%.3lf,%.3lf,", avg_ms, p99_ms);
+				} else {
+					fprintf(csv, ",,");
+				}
+				fprintf(csv, "%.1lf\n", cpu);
+			}
+		}
+		if (profile.jobs[0]->get_options()->use_total_threads) {
+			printf("\t(threads is the total, -F)\n");
+		}
+		printf("\n");
+
+		if (csv) {
+			fclose(csv);
+		}
 	}
 
 // macro for printing a bar in the print_iops function
@@ -266,7 +1305,8 @@ namespace diskspd {
 // macro for getting appropriate read/write values in the print_iops function
 #define IOPS_GET(rval, wval, rwval) (t == READ ? t_result->rval : t == WRITE ? t_result->wval : t_result->rwval)
 
-	void ResultFormatterText::print_iops(const std::shared_ptr<Job>& job, Type t) {
+	void ResultFormatterText::print_iops(const std::shared_ptr<Job>& job, Type t, bool logical,
+			int group) {
 
 		std::shared_ptr<JobOptions> options = job->get_options();
 		std::shared_ptr<JobResults> results = job->get_results();
@@ -279,6 +1319,7 @@ namespace diskspd {
 		IOPS_RESULT_BAR()
 
 		double bucket_time_seconds = (double)options->io_bucket_duration_ms/1000.0;
+		double seconds = test_seconds(*options, *results);
 
 		uint64_t total_bytes = 0;
 		uint64_t total_iops = 0;
@@ -287,7 +1328,7 @@ namespace diskspd {
 
 		for (auto& thread_result : results->thread_results) {
 
-			for (auto& t_result : thread_result->target_results) {
+			for (auto& t_result : result_rows(*thread_result, logical, group)) {
 
 				printf("%6d | %15lu | %12lu | %10.2lf | %10.2lf ",
 						thread_result->thread_id,
@@ -296,11 +1337,11 @@ namespace diskspd {
 						(double)IOPS_GET(
 							read_bytes_count,
 							write_bytes_count,
-							bytes_count)/ (1<<20) / (double)options->duration,
+							bytes_count)/ (1<<20) / seconds,
 						(double)IOPS_GET(
 							read_iops_count,
 							write_iops_count,
-							iops_count)/ (double)options->duration
+							iops_count)/ seconds
 					  );
 
 				// iops stddev
@@ -365,8 +1406,8 @@ namespace diskspd {
 			printf("total:   %15lu | %12lu | %10.2lf | %10.2lf ",
 					total_bytes,
 					total_iops,
-					(double)total_bytes / (1<<20) / (double)options->duration,
-					(double)total_iops / (double)options->duration);
+					(double)total_bytes / (1<<20) / seconds,
+					(double)total_iops / seconds);
 		// total iops std dev
 		if (options->measure_iops_std_dev) {
 			printf("| %10.2lf ", total_bucketizer.GetStandardDeviation()/bucket_time_seconds);
@@ -33,7 +33,25 @@ namespace diskspd {
 				WRITE,
 				RW,
 			};
-			void print_iops(const std::shared_ptr<Job>& job, Type t);
+			// logical: print the logical ops (--stripe, --mirror, --erasure) rather than each target's
+			// group: only print the targets of this --group, or all of them if it's -1
+			void print_iops(const std::shared_ptr<Job>& job, Type t, bool logical = false,
+					int group = -1);
+			void print_percentiles(const std::shared_ptr<Job>& job, bool logical, int group = -1);
+			void print_chains(const std::shared_ptr<Job>& job);
+			void print_lsm(const std::shared_ptr<Job>& job);
+			void print_wal(const std::shared_ptr<Job>& job);
+			void print_mirror(const std::shared_ptr<Job>& job);
+			void print_erasure(const std::shared_ptr<Job>& job);
+			void print_cache(const std::shared_ptr<Job>& job);
+			void print_idle(const std::shared_ptr<Job>& job);
+			void print_qd(const std::shared_ptr<Job>& job);
+			void print_ramp(const std::shared_ptr<Job>& job);
+			void print_steady(const std::shared_ptr<Job>& job);
+			void print_precondition(const std::shared_ptr<Job>& job);
+			void print_work(const std::shared_ptr<Job>& job);
+			void print_scan(const std::shared_ptr<Job>& job);
+			void print_sweep(const Profile& profile);
 	};
 
 	class ResultFormatterXML : public IResultFormatter {
@@ -0,0 +1,182 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <assert.h>
+
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "scan.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool TargetScan::parse(const char * arg) {
+
+		std::string setting(arg);
+		if (setting.empty()) {
+			return true;
+		}
+		size_t eq = setting.find('=');
+		std::string value = eq == std::string::npos ? "" : setting.substr(eq + 1);
+		if (setting.substr(0, eq) != "chunk" || !Options::valid_byte_size(value.c_str()) ||
+				value.back() == 'b' || !(chunk_size = Options::byte_size_from_arg(value.c_str(), 0))) {
+			fprintf(stderr, "Invalid --scan setting \"%s\"\n", setting.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	void TargetScan::split(const std::vector<std::shared_ptr<Target>>& targets,
+			unsigned int threads) {
+
+		chunks.clear();
+		for (size_t t = 0; t < targets.size(); ++t) {
+			const Target& target = *targets[t];
+			// chunks are whole blocks, and so is the scan
+			off_t block_size = target.block_size;
+			off_t chunk_bytes = std::max(chunk_size/block_size, (size_t)1)*block_size;
+			off_t end = target.base_offset +
+				(target.max_size - target.base_offset)/block_size*block_size;
+			for (off_t offset = target.base_offset; offset < end; offset += chunk_bytes) {
+				chunks.push_back({ t, offset, std::min(offset + chunk_bytes, end) });
+			}
+		}
+
+		this->threads = threads;
+		deques.reset(new std::atomic<uint64_t>[threads]);
+		for (unsigned int i = 0; i < threads; ++i) {
+			uint64_t head = chunks.size()*i/threads;
+			uint64_t tail = chunks.size()*(i + 1)/threads;
+			deques[i] = head << 32 | tail;
+		}
+	}
+
+	bool TargetScan::take(unsigned int thread, Chunk& chunk, bool& stolen) {
+
+		// the front of its own deque
+		std::atomic<uint64_t>& own = deques[thread];
+		uint64_t deque = own.load();
+		while ((deque >> 32) < (deque & 0xFFFFFFFF)) {
+			if (own.compare_exchange_weak(deque, deque + ((uint64_t)1 << 32))) {
+				chunk = chunks[deque >> 32];
+				stolen = false;
+				return true;
+			}
+		}
+
+		// the back of the fullest other one, until they're all empty
+		stolen = true;
+		while (true) {
+			unsigned int victim = threads;
+			uint64_t most = 0;
+			for (unsigned int i = 0; i < threads; ++i) {
+				uint64_t d = deques[i].load();
+				uint64_t left = (d >> 32) < (d & 0xFFFFFFFF) ? (d & 0xFFFFFFFF) - (d >> 32) : 0;
+				if (left > most) {
+					most = left;
+					victim = i;
+				}
+			}
+			if (victim == threads) {
+				return false;
+			}
+
+			deque = deques[victim].load();
+			while ((deque >> 32) < (deque & 0xFFFFFFFF)) {
+				if (deques[victim].compare_exchange_weak(deque, deque - 1)) {
+					chunk = chunks[(deque & 0xFFFFFFFF) - 1];
+					return true;
+				}
+			}
+		}
+	}
+
+	std::shared_ptr<IAsyncIop> ScanSlots::take(size_t slot) {
+
+		if (offset >= chunk.end) {
+			bool stolen;
+			if (!thread.job_options->scan->take(thread.thread_id, chunk, stolen)) {
+				return nullptr;
+			}
+			offset = chunk.offset;
+			++thread.results->scan_results->chunks;
+			thread.results->scan_results->stolen += stolen;
+		}
+
+		std::shared_ptr<IAsyncIop>& op = ops[slot][chunk.target];
+		op->set_offset(offset);
+		offset += op->get_target_data()->target->block_size;
+		return op;
+	}
+
+	bool ScanSlots::start(size_t& started) {
+
+		std::vector<std::shared_ptr<TargetData>>& targets = thread.targets;
+
+		// the pool is -o slots; every target's buffer has room for at least that many
+		size_t slots = targets[0]->target->overlap;
+		for (auto& t_data : targets) {
+			slots = std::min(slots, (size_t)t_data->target->overlap);
+		}
+		ops.resize(slots);
+
+		started = 0;
+		for (size_t i = 0; i < ops.size(); ++i) {
+
+			for (auto& t_data : targets) {
+				void * read_buf = static_cast<char *>(t_data->buffer.ptr()) + i*t_data->target->block_size;
+				void * write_buf =
+					t_data->target->separate_buffers ? t_data->write_buffer.ptr() : read_buf;
+
+				ops[i].push_back(thread.io_manager->construct(
+						IAsyncIop::Type::READ,
+						t_data->fd,
+						t_data->target->base_offset,
+						read_buf,
+						write_buf,
+						t_data->target->block_size,
+						thread.thread_id,
+						t_data,
+						0
+						));
+				index[ops[i].back().get()] = i;
+			}
+
+			std::shared_ptr<IAsyncIop> op = take(i);
+			if (!op) {
+				continue;
+			}
+			if (thread.rw_rng_engine->get_percentage() <=
+					op->get_target_data()->target->write_percentage) {
+				op->set_type(IAsyncIop::Type::WRITE);
+			} else {
+				op->set_type(IAsyncIop::Type::READ);
+			}
+			op->set_time(PerfClock::get_time_us());
+
+			if (thread.io_manager->enqueue(op)) {
+				perror("aio enqueue failed");
+				thread.thread_abort();
+				return false;
+			}
+			++started;
+		}
+		return true;
+	}
+
+	std::shared_ptr<IAsyncIop> ScanSlots::next_op(const std::shared_ptr<IAsyncIop>& done) {
+		return take(index[done.get()]);
+	}
+
+} // namespace diskspd
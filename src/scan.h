@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <sys/types.h>
+
+#ifndef DISKSPD_SCAN_H
+#define DISKSPD_SCAN_H
+
+namespace diskspd {
+
+	struct Target;
+	struct ThreadParams;
+	class IAsyncIop;
+
+	/**
+	 *	A parallel full scan of every target (--scan, with -F). The targets are cut into chunks,
+	 *	and each thread starts with a deque of its own: an even share of them, in order. A
+	 *	thread takes chunks from the front of its deque, and once it's empty steals them from
+	 *	the back of whichever other deque has the most left, so threads on fast targets help out
+	 *	on slow ones rather than finishing early. The scan is over once every chunk is.
+	 *
+	 *	The deques are ranges of one array of chunks that never changes once the Job has split
+	 *	the targets, so a deque is just its head and tail in one atomic word: the owner moves
+	 *	the head up and thieves move the tail down, each with a compare and swap
+	 */
+	struct TargetScan {
+		size_t chunk_size			= 1024*1024;	// chunk=
+
+		struct Chunk {
+			size_t target;			// index into the Job's targets
+			off_t offset;
+			off_t end;
+		};
+
+		/**
+		 *	Parse a --scan argument: chunk=SIZE, or nothing for the default
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	Cut the whole blocks in [base_offset, max_size) of each target into chunks, and deal
+		 *	them out to the threads
+		 */
+		void split(const std::vector<std::shared_ptr<Target>>& targets, unsigned int threads);
+
+		/**
+		 *	Take the next chunk of a thread's own deque, or if that's empty, steal one from
+		 *	another's; stolen says which. Returns false once there are none left anywhere
+		 */
+		bool take(unsigned int thread, Chunk& chunk, bool& stolen);
+
+		inline size_t size() const { return chunks.size(); }
+
+		private:
+			std::vector<Chunk> chunks;
+			unsigned int threads	= 0;
+			// [thread]; the head of the deque in the high 32 bits, the tail in the low ones
+			std::unique_ptr<std::atomic<uint64_t>[]> deques;
+	};
+
+	/**
+	 *	Per-thread --scan results: the chunks a thread scanned, how many of them it stole, and
+	 *	when its last op finished, as an absolute time in microseconds
+	 */
+	struct ScanResults {
+		uint64_t chunks				= 0;
+		uint64_t stolen				= 0;
+		uint64_t finished_us		= 0;
+	};
+
+	/**
+	 *	A thread's pool of -o slots for --scan. Each slot has an op on every target; the slots
+	 *	share the thread's current chunk, each taking the next block of it
+	 */
+	class ScanSlots {
+		public:
+			ScanSlots(ThreadParams& thread) : thread(thread) {}
+
+			/**
+			 *	Create the ops for every slot on every target, and enqueue the first op of each
+			 *	slot there's a block for. Doesn't submit them. Sets started to the number of
+			 *	slots that have an op in flight
+			 */
+			bool start(size_t& started);
+
+			/**
+			 *	A slot's op completed; returns the slot's op for the next block of the scan, or
+			 *	nullptr if there are none left
+			 */
+			std::shared_ptr<IAsyncIop> next_op(const std::shared_ptr<IAsyncIop>& done);
+
+			inline size_t size() const { return ops.size(); }
+
+		private:
+			ThreadParams& thread;
+
+			// [slot][target]; a slot has an op with its own buffer on every target
+			std::vector<std::vector<std::shared_ptr<IAsyncIop>>> ops;
+			// the slot of each op
+			std::map<IAsyncIop *, size_t> index;
+
+			TargetScan::Chunk chunk = { 0, 0, 0 };
+			off_t offset			= 0;
+
+			std::shared_ptr<IAsyncIop> take(size_t slot);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_SCAN_H
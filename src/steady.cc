@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <assert.h>
+
+#include "options.h"
+#include "thread.h"
+#include "steady.h"
+
+namespace diskspd {
+
+	/**
+	 *	The coefficient of variation of values, and how far their least squares trend line
+	 *	moves from the first to the last, both as fractions of their mean. Returns false if
+	 *	the mean is 0
+	 */
+	static bool variation(const std::vector<double>& values, double& cv, double& drift) {
+		double n = values.size();
+		double mean = 0;
+		for (double v : values) mean += v;
+		mean /= n;
+		if (mean <= 0) {
+			return false;
+		}
+
+		double ssd = 0;
+		double x_mean = (n - 1)/2;
+		double sxy = 0;
+		double sxx = 0;
+		for (size_t x = 0; x < values.size(); ++x) {
+			ssd += (values[x] - mean)*(values[x] - mean);
+			sxy += (x - x_mean)*(values[x] - mean);
+			sxx += (x - x_mean)*(x - x_mean);
+		}
+		cv = sqrt(ssd/n)/mean;
+		drift = sxx ? fabs(sxy/sxx)*(n - 1)/mean : 0;
+		return true;
+	}
+
+	bool SteadyState::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t pos = 0;
+		while (pos < settings.size()) {
+			size_t end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --steady setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			char * value_end = nullptr;
+			double number = strtod(value.c_str(), &value_end);
+			bool valid = !value.empty() && *value_end == '\0' && number > 0;
+			if (key == "window" || key == "windows") {
+				valid &= Options::is_numeric(value.c_str());
+			}
+			if (key == "window") {
+				window_ms = number;
+			} else if (key == "windows") {
+				valid &= number >= 2;
+				windows = number;
+			} else if (key == "cv") {
+				cv = number;
+			} else if (key == "slope") {
+				slope = number;
+			} else if (key == "latency") {
+				latency_cv = number;
+			} else {
+				valid = false;
+			}
+			if (!valid) {
+				fprintf(stderr, "Invalid --steady setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool SteadyState::add_window(unsigned int w, const std::vector<std::shared_ptr<ThreadResults>>& threads,
+			bool latency, SteadyResults& results) const {
+
+		uint64_t ops = 0;
+		Histogram<uint64_t> latency_histogram;
+		for (auto& thread_result : threads) {
+			const WarmupResults::Window& window = thread_result->warmup_results->windows[w];
+			ops += window.ops;
+			latency_histogram.Merge(window.latency_histogram);
+		}
+
+		SteadyResults::Window window;
+		window.iops = (double)ops*1000/window_ms;
+		if (latency_histogram.GetSampleSize()) {
+			window.p99_us = latency_histogram.GetPercentile(0.99);
+		}
+		results.windows.push_back(window);
+
+		if (results.windows.size() < windows) {
+			return false;
+		}
+
+		std::vector<double> iops;
+		std::vector<double> p99;
+		for (size_t i = results.windows.size() - windows; i < results.windows.size(); ++i) {
+			iops.push_back(results.windows[i].iops);
+			p99.push_back(results.windows[i].p99_us);
+		}
+
+		double iops_cv, iops_drift;
+		if (!variation(iops, iops_cv, iops_drift) || iops_cv*100 > cv || iops_drift*100 > slope) {
+			return false;
+		}
+		if (latency) {
+			double p99_cv, p99_drift;
+			if (!variation(p99, p99_cv, p99_drift) || p99_cv*100 > latency_cv) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+} // namespace diskspd
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_STEADY_H
+#define DISKSPD_STEADY_H
+
+namespace diskspd {
+
+	struct ThreadResults;
+
+	/**
+	 *	Per-thread warm up results for --steady: the ops that completed in each window.
+	 *	Latencies are in microseconds, and only kept with -L
+	 */
+	struct WarmupResults {
+		struct Window {
+			uint64_t ops			= 0;
+			Histogram<uint64_t> latency_histogram;
+		};
+		std::vector<Window> windows;
+	};
+
+	/**
+	 *	The Job's warm up windows, and when it reached steady state
+	 */
+	struct SteadyResults {
+		struct Window {
+			double iops				= 0;
+			uint64_t p99_us			= 0;	// only with -L
+		};
+		std::vector<Window> windows;
+		bool reached				= false;
+		uint64_t warmup_ms			= 0;
+	};
+
+	/**
+	 *	A warm up that ends at steady state (--steady) rather than after a fixed time. The
+	 *	warm up is cut into windows, and once the last 'windows' of them are steady, the main
+	 *	duration starts; -W is the longest it can take. Steady means the throughput's
+	 *	coefficient of variation is under cv, and its least squares trend line moves less than
+	 *	slope over the span, both as percentages of the mean; with -L, the 99th percentile
+	 *	latency's coefficient of variation also has to be under latency_cv.
+	 *
+	 *	Threads add to the window the Job says is current. A window is only summed up once
+	 *	the next one has ended too, so no thread can still be adding to it
+	 */
+	struct SteadyState {
+		uint64_t window_ms			= 1000;		// window=
+		unsigned int windows		= 5;		// windows=
+		double cv					= 5;		// cv=
+		double slope				= 10;		// slope=
+		double latency_cv			= 10;		// latency=
+
+		// the window threads add to; set by the Job
+		std::atomic<unsigned int> current{0};
+
+		/**
+		 *	Parse a --steady argument: comma separated key=value settings, named as above, or
+		 *	nothing for the defaults. Percentages can be fractions
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	Sum up window w of every thread's warm up results into results, and check whether
+		 *	the last 'windows' windows are steady
+		 */
+		bool add_window(unsigned int w, const std::vector<std::shared_ptr<ThreadResults>>& threads,
+				bool latency, SteadyResults& results) const;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_STEADY_H
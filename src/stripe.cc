@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <assert.h>
+
+#include "debug.h"
+#include "async_io.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "stripe.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	void StripeSet::map(off_t offset, size_t nbytes, std::vector<Extent>& extents) const {
+
+		off_t members = extents.size();
+		for (auto& e : extents) {
+			e.nbytes = 0;
+		}
+
+		off_t pos = offset;
+		off_t end = offset + nbytes;
+		while (pos < end) {
+			off_t chunk = pos/unit;
+			off_t in_chunk = pos%unit;
+			Extent& e = extents[chunk % members];
+			size_t n = std::min((off_t)unit - in_chunk, end - pos);
+
+			// a member's next chunk of this op always follows on from its previous one
+			if (!e.nbytes) {
+				e.offset = (chunk/members)*unit + in_chunk;
+			}
+			e.nbytes += n;
+			pos += n;
+		}
+	}
+
+	/**
+	 *	State of one -o slot of logical ops
+	 */
+	struct StripeSlot {
+		// one op per member, reused for each logical op
+		std::vector<std::shared_ptr<IAsyncIop>> member_ops;
+		std::vector<StripeSet::Extent> extents;
+		IAsyncIop::Type type;
+		off_t offset = 0;			// logical offset
+		uint64_t start_us = 0;
+		unsigned int in_flight = 0;	// member ops not yet completed
+	};
+
+	/**
+	 *	Start the next logical op on a slot, enqueueing an op for each member it touches
+	 */
+	static bool start_logical_op(ThreadParams& thread, TargetData& logical, StripeSlot& slot) {
+
+		slot.type = thread.rw_rng_engine->get_percentage() <= logical.target->write_percentage ?
+			IAsyncIop::Type::WRITE : IAsyncIop::Type::READ;
+		slot.start_us = PerfClock::get_time_us();
+
+		thread.job_options->stripe->map(slot.offset, logical.target->block_size, slot.extents);
+
+		for (size_t m = 0; m < slot.extents.size(); ++m) {
+			if (!slot.extents[m].nbytes) continue;
+
+			std::shared_ptr<IAsyncIop>& op = slot.member_ops[m];
+			op->set_type(slot.type);
+			op->set_offset(thread.targets[m]->target->base_offset + slot.extents[m].offset);
+			op->set_nbytes(slot.extents[m].nbytes);
+			op->set_time(slot.start_us);
+
+			if (thread.io_manager->enqueue(op)) {
+				perror("aio enqueue failed");
+				thread.thread_abort();
+				return false;
+			}
+			++slot.in_flight;
+		}
+		return true;
+	}
+
+	void ThreadParams::stripe_func() {
+
+		const std::shared_ptr<Target>& logical_target = job_options->stripe->logical;
+
+		// offsets for logical ops come from a TargetData for the stripe set, like any target's
+		auto logical = std::make_shared<TargetData>();
+		logical->target = logical_target;
+		logical->results = results->logical_results;
+		logical->thread = targets[0]->thread;
+		logical->rng_engine = rng_engine;
+
+		std::vector<StripeSlot> slots(logical_target->overlap);
+		// the slot each member op belongs to
+		std::map<IAsyncIop *, size_t> slot_index;
+
+		off_t curr_offset = logical->get_start_offset();
+
+		for (size_t i = 0; i < slots.size(); ++i) {
+			StripeSlot& slot = slots[i];
+			slot.extents.resize(targets.size());
+			slot.offset = curr_offset;
+			curr_offset = logical->get_next_offset(curr_offset);
+
+			for (auto& t_data : targets) {
+				void * read_buf = static_cast<char *>(t_data->buffer.ptr()) + i*t_data->target->block_size;
+				void * write_buf =
+					t_data->target->separate_buffers ? t_data->write_buffer.ptr() : read_buf;
+
+				slot.member_ops.push_back(io_manager->construct(
+						IAsyncIop::Type::READ,
+						t_data->fd,
+						t_data->target->base_offset,
+						read_buf,
+						write_buf,
+						t_data->target->block_size,
+						thread_id,
+						t_data,
+						0
+						));
+				slot_index[slot.member_ops.back().get()] = i;
+			}
+
+			if (!start_logical_op(*this, *logical, slot)) {
+				return;
+			}
+		}
+
+		if (io_manager->submit(thread_id)) {
+			perror("aio submit failed");
+			thread_abort();
+			return;
+		}
+
+		// Unblock main thread (so the job can start the warmup/duration)
+		signal_initialized();
+
+		/************
+		 *	Do Work
+		 ************/
+
+		while(*run_threads) {
+
+			// block until a member op completes
+			std::shared_ptr<IAsyncIop> op = io_manager->wait(thread_id);
+
+			// potentially exit right after waiting for io - improves accuracy of duration
+			if (!*run_threads) break;
+
+			if (!check_completion(op)) {
+				return;
+			}
+
+			uint64_t abs_time_us = PerfClock::get_time_us();
+
+			// per member results
+			if (*record_results) {
+				record_completion(op, abs_time_us);
+			}
+
+			// the logical op completes with its slowest member
+			StripeSlot& slot = slots[slot_index[op.get()]];
+			if (--slot.in_flight) {
+				continue;
+			}
+
+			if (*record_results) {
+				record_logical_completion(slot.type == IAsyncIop::Type::WRITE,
+						logical_target->block_size, slot.start_us, abs_time_us);
+			}
+
+			slot.offset = logical->get_next_offset(slot.offset);
+			if (!start_logical_op(*this, *logical, slot)) {
+				return;
+			}
+			if (io_manager->submit(thread_id)) {
+				perror("aio submit failed");
+				thread_abort();
+				return;
+			}
+		}
+
+		// release resources
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <sys/types.h>
+
+#ifndef DISKSPD_STRIPE_H
+#define DISKSPD_STRIPE_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	A RAID0 stripe set across all of a Job's targets (--stripe). Logical ops are generated on
+	 *	the 'logical' target, split into one op per member they touch, and complete when the
+	 *	last of their member ops does
+	 */
+	struct StripeSet {
+		size_t unit = 0;		// bytes per stripe unit
+
+		// the stripe set as a single target; holds the offset, -w and -o settings for logical ops
+		std::shared_ptr<Target> logical;
+
+		/**
+		 *	The part of a member a logical op covers. With RAID0 this is always contiguous
+		 */
+		struct Extent {
+			off_t offset;		// relative to the member's base offset
+			size_t nbytes;		// 0 if the op doesn't touch the member
+		};
+
+		/**
+		 *	Split a logical op across the members, filling in one Extent for each (extents must
+		 *	already have one entry per member)
+		 */
+		void map(off_t offset, size_t nbytes, std::vector<Extent>& extents) const;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_STRIPE_H
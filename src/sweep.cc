@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+#include <assert.h>
+
+#include "options.h"
+#include "sys_info.h"
+#include "sweep.h"
+
+namespace diskspd {
+
+	/**
+	 *	Split a list of values separated by slashes
+	 */
+	static std::vector<std::string> split_values(const std::string& list) {
+		std::vector<std::string> values;
+		size_t pos = 0;
+		while (pos <= list.size()) {
+			size_t end = list.find('/', pos);
+			if (end == std::string::npos) end = list.size();
+			values.push_back(list.substr(pos, end - pos));
+			pos = end + 1;
+		}
+		return values;
+	}
+
+	bool ParamSweep::parse(const char * arg) {
+
+		std::string settings(arg);
+		size_t pos = 0;
+		while (pos < settings.size()) {
+			size_t end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			if (eq == std::string::npos) {
+				fprintf(stderr, "Invalid --sweep setting \"%s\"; expected key=value\n", setting.c_str());
+				return false;
+			}
+			std::string key = setting.substr(0, eq);
+			std::string value = setting.substr(eq + 1);
+
+			bool valid = !value.empty();
+			if (key == "b") {
+				block_sizes = split_values(value);
+			} else if (key == "w") {
+				write_percentages = split_values(value);
+			} else if (key == "t") {
+				threads = split_values(value);
+			} else if (key == "o") {
+				overlaps = split_values(value);
+			} else if (key == "settle") {
+				valid = Options::is_numeric(value.c_str());
+				settle_ms = strtoull(value.c_str(), nullptr, 10);
+			} else if (key == "csv") {
+				csv_path = value;
+			} else {
+				valid = false;
+				for (auto& param : queue_params) {
+					if (key == param.first) {
+						param.second = split_values(value);
+						// all but the scheduler are numbers
+						valid = !value.empty();
+						for (auto& v : param.second) {
+							valid &= !v.empty() && (key == "scheduler" || Options::is_numeric(v.c_str()));
+						}
+					}
+				}
+			}
+			if (!valid) {
+				fprintf(stderr, "Invalid --sweep setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+
+		if (block_sizes.empty() && write_percentages.empty() && threads.empty() &&
+				overlaps.empty() && queue_settings(0).empty()) {
+			fprintf(stderr, "--sweep needs a list of values for at least one of b, o, t, w and the queue settings\n");
+			return false;
+		}
+		return true;
+	}
+
+	size_t ParamSweep::size() const {
+		size_t points = std::max<size_t>(block_sizes.size(), 1)*std::max<size_t>(write_percentages.size(), 1)*
+			std::max<size_t>(threads.size(), 1)*std::max<size_t>(overlaps.size(), 1);
+		for (auto& param : queue_params) {
+			points *= std::max<size_t>(param.second.size(), 1);
+		}
+		return points;
+	}
+
+	size_t ParamSweep::value_index(size_t point, const std::vector<std::string>& values) const {
+
+		// innermost first
+		std::vector<const std::vector<std::string> *> lists = {
+			&overlaps, &threads, &write_percentages, &block_sizes
+		};
+		for (auto it = queue_params.rbegin(); it != queue_params.rend(); ++it) {
+			lists.push_back(&it->second);
+		}
+		for (auto list : lists) {
+			if (list == &values) break;
+			point /= std::max<size_t>(list->size(), 1);
+		}
+		return point % values.size();
+	}
+
+	bool ParamSweep::apply(size_t point, Options& options) const {
+
+		// -t sets threads per target, unless the command line used -F for the total
+		OptionType thread_option = options.get_arg(TOTAL_THREADS) ? TOTAL_THREADS : THREADS_PER_TARGET;
+
+		std::pair<OptionType, const std::vector<std::string> *> params[] = {
+			{ OVERLAP, &overlaps },
+			{ thread_option, &threads },
+			{ WRITE, &write_percentages },
+			{ BLOCK_SIZE, &block_sizes }
+		};
+		for (auto& param : params) {
+			const std::vector<std::string>& values = *param.second;
+			if (values.empty()) continue;
+
+			if (!options.set_arg(param.first, values[value_index(point, values)])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<std::pair<std::string, std::string>> ParamSweep::queue_settings(size_t point) const {
+		std::vector<std::pair<std::string, std::string>> settings;
+		for (auto& param : queue_params) {
+			if (param.second.empty()) continue;
+			settings.push_back({ param.first, param.second[value_index(point, param.second)] });
+		}
+		return settings;
+	}
+
+	bool ParamSweep::tune_queues(size_t point, const std::vector<std::string>& devices,
+			SysInfo& sys_info) {
+
+		for (auto& device : devices) {
+
+			// save everything before changing anything, as a new scheduler resets the rest
+			bool seen = false;
+			for (auto& setting : saved) {
+				seen |= setting.device == device;
+			}
+			for (auto& param : queue_params) {
+				if (seen || param.second.empty()) continue;
+
+				std::string value;
+				if (!sys_info.queue_setting(device, param.first, value)) {
+					fprintf(stderr, "Couldn't read %s of device %s\n", param.first.c_str(), device.c_str());
+					return false;
+				}
+				if (param.first == "scheduler") {
+					// the line of schedulers is like "sched1 sched2 [selectedsched]"
+					std::string offered = " " + value + " ";
+					for (auto& scheduler : param.second) {
+						if (offered.find(" " + scheduler + " ") == std::string::npos &&
+								offered.find(" [" + scheduler + "] ") == std::string::npos) {
+							fprintf(stderr, "Device %s doesn't offer scheduler %s (only %s)\n",
+									device.c_str(), scheduler.c_str(), value.c_str());
+							return false;
+						}
+					}
+					value = sys_info.scheduler_from_device(device);
+				}
+				saved.push_back({ device, param.first, value });
+			}
+
+			for (auto& setting : queue_settings(point)) {
+				if (!sys_info.set_queue_setting(device, setting.first, setting.second)) {
+					fprintf(stderr, "Couldn't set %s of device %s to %s: %s\n", setting.first.c_str(),
+							device.c_str(), setting.second.c_str(), strerror(errno));
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	void ParamSweep::restore_queues(SysInfo& sys_info) {
+		// in the order they were saved, so each device's scheduler goes back first
+		for (auto& setting : saved) {
+			if (!sys_info.set_queue_setting(setting.device, setting.name, setting.value)) {
+				fprintf(stderr, "Couldn't restore %s of device %s to %s: %s\n", setting.name.c_str(),
+						setting.device.c_str(), setting.value.c_str(), strerror(errno));
+			}
+		}
+		saved.clear();
+	}
+
+} // namespace diskspd
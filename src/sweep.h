@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+#ifndef DISKSPD_SWEEP_H
+#define DISKSPD_SWEEP_H
+
+namespace diskspd {
+
+	class Options;
+	struct SysInfo;
+
+	/**
+	 *	A parameter sweep (--sweep): lists of values for -b, -o, -t (or -F) and -w, and for the
+	 *	block queue settings of the targets' devices, run as one Job per combination. A
+	 *	parameter without a list keeps its current value. Points go in order of the queue
+	 *	settings, then -b, then -w, then -t, then -o, so the last changes fastest
+	 */
+	struct ParamSweep {
+		std::vector<std::string> block_sizes;			// b=
+		std::vector<std::string> write_percentages;		// w=
+		std::vector<std::string> threads;				// t=
+		std::vector<std::string> overlaps;				// o=
+		uint64_t settle_ms			= 500;				// settle=; idle time between points
+		std::string csv_path;							// csv=
+
+		// /sys/block/$device/queue settings, by name. The scheduler is first, as changing it
+		// resets the others to its defaults
+		std::vector<std::pair<std::string, std::vector<std::string>>> queue_params = {
+			{ "scheduler", {} },
+			{ "nr_requests", {} },
+			{ "read_ahead_kb", {} },
+			{ "rq_affinity", {} },
+			{ "nomerges", {} }
+		};
+
+		/**
+		 *	Parse a --sweep argument: comma separated key=value settings, named as above. The
+		 *	parameters take lists of values separated by slashes, e.g. b=4K/64K,o=1/8/32
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	The number of points
+		 */
+		size_t size() const;
+
+		/**
+		 *	Set the parameters of a point in options, as if they'd been given on the command
+		 *	line. Returns false if one is invalid
+		 */
+		bool apply(size_t point, Options& options) const;
+
+		/**
+		 *	The queue settings a point has, in the order they're applied
+		 */
+		std::vector<std::pair<std::string, std::string>> queue_settings(size_t point) const;
+
+		/**
+		 *	Apply a point's queue settings to the devices. The first time a device is seen,
+		 *	all of its settings that are swept are saved first, and every scheduler swept is
+		 *	checked against the ones it offers. Returns false if a setting can't be changed
+		 */
+		bool tune_queues(size_t point, const std::vector<std::string>& devices, SysInfo& sys_info);
+
+		/**
+		 *	Put back every setting tune_queues() changed
+		 */
+		void restore_queues(SysInfo& sys_info);
+
+		private:
+			struct SavedSetting {
+				std::string device;
+				std::string name;
+				std::string value;
+			};
+			std::vector<SavedSetting> saved;
+
+			/**
+			 *	The index into values of the value a point has
+			 */
+			size_t value_index(size_t point, const std::vector<std::string>& values) const;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_SWEEP_H
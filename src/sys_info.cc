@@ -11,6 +11,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cerrno>
+#include <cctype>
 
 #include <linux/limits.h>	// PATH_MAX
 #include <unistd.h>			// readlink
@@ -19,6 +21,7 @@
 #include <sys/sysmacros.h>
 #include <sys/types.h>		// DIR?
 #include <sys/stat.h>		// stat
+#include <fcntl.h>			// open
 
 #include "debug.h"
 #include "sys_info.h"
@@ -96,6 +99,10 @@ namespace diskspd {
 		return ret;
 	}
 
+	void SysInfo::set_affinity(const char * affinity_set) {
+		affinity_cpus = str_to_cpu_set(affinity_set);
+	}
+
 	void SysInfo::init_sys_info(const char * affinity_set) {
 
 		// Prevent the (perceived) cpu topology from being changed at runtime
@@ -339,6 +346,36 @@ namespace diskspd {
 		return sched;
 	}
 
+	bool SysInfo::queue_setting(const std::string& device, const std::string& name,
+			std::string& value) {
+
+		std::ifstream setting_file("/sys/block/" + device + "/queue/" + name);
+		if (!setting_file.is_open()) {
+			return false;
+		}
+		std::getline(setting_file, value);
+		while (value.size() && isspace(value.back())) {
+			value.pop_back();
+		}
+		return true;
+	}
+
+	bool SysInfo::set_queue_setting(const std::string& device, const std::string& name,
+			const std::string& value) {
+
+		std::string path = "/sys/block/" + device + "/queue/" + name;
+		int fd = open(path.c_str(), O_WRONLY);
+		if (fd == -1) {
+			return false;
+		}
+		// sysfs takes the whole value in one write, and reports a bad one as its error
+		ssize_t written = write(fd, value.c_str(), value.size());
+		int write_errno = errno;
+		close(fd);
+		errno = write_errno;
+		return written == (ssize_t)value.size();
+	}
+
 	off_t SysInfo::partition_size(dev_t device_id) {
 		if (!id_to_device.count(device_id)) {
 			fprintf(
@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 #include <cstdint>
+#include <string>
 #include <vector>
 #include <set>
 #include <map>
@@ -29,6 +30,12 @@ namespace diskspd {
 		 */
 		void init_sys_info(const char * affinity_set);
 
+		/**
+		 *	Replace affinity_cpus with the cpuset a string describes, once init_sys_info has been
+		 *	called; a --daemon's runs each have their own -a
+		 */
+		void set_affinity(const char * affinity_set);
+
 		/**
 		 *	Parse the contents of /proc/stat
 		 *	Returned keys are the cpu ids
@@ -48,6 +55,19 @@ namespace diskspd {
 		 */
 		std::string scheduler_from_device(std::string device);
 
+		/**
+		 *	Uses sysfs to read one of a block device's queue settings, i.e.
+		 *	/sys/block/$device/queue/$name. Returns false if it can't be read
+		 */
+		bool queue_setting(const std::string& device, const std::string& name, std::string& value);
+
+		/**
+		 *	Uses sysfs to change one of a block device's queue settings. Returns false, with errno
+		 *	set, if the kernel doesn't accept it
+		 */
+		bool set_queue_setting(const std::string& device, const std::string& name,
+				const std::string& value);
+
 		/**
 		 *	Uses sysfs to get the size of a block device or partition given a device id
 		 */
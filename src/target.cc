@@ -0,0 +1,61 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <cstdlib>
+#include <cstring>
+
+#include "target.h"
+
+namespace diskspd {
+
+	// --daemon; freed buffers by size, with the trim they were freed before
+	static std::mutex kept_mutex;
+	static bool keeping = false;
+	static unsigned int trims = 0;
+	static std::multimap<size_t, std::pair<void *, unsigned int>> kept;
+
+	void TargetBuffer::keep_freed(bool keep) {
+		std::lock_guard<std::mutex> lock(kept_mutex);
+		keeping = keep;
+	}
+
+	void TargetBuffer::trim_kept() {
+		std::lock_guard<std::mutex> lock(kept_mutex);
+		// a buffer that's been reused was taken out, and put back with the current count
+		for (auto it = kept.begin(); it != kept.end(); ) {
+			if (it->second.second != trims) {
+				free(it->second.first);
+				it = kept.erase(it);
+			} else {
+				++it;
+			}
+		}
+		++trims;
+	}
+
+	void * TargetBuffer::allocate(size_t size) {
+		{
+			std::lock_guard<std::mutex> lock(kept_mutex);
+			auto it = kept.find(size);
+			if (it != kept.end()) {
+				void * unaligned = it->second.first;
+				kept.erase(it);
+				return std::memset(unaligned, 0, size);
+			}
+		}
+		return std::calloc(size, 1);
+	}
+
+	void TargetBuffer::release(void * unaligned, size_t size) {
+		std::lock_guard<std::mutex> lock(kept_mutex);
+		if (keeping) {
+			kept.insert({ size, { unaligned, trims } });
+		} else {
+			free(unaligned);
+		}
+	}
+
+} // namespace diskspd
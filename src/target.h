@@ -6,6 +6,7 @@
 #include <cstring>
 #include <cstdlib>	// calloc
 #include <memory>
+#include <algorithm>
 #include <mutex>
 #include <pthread.h>
 #include <assert.h>
@@ -21,6 +22,15 @@
 
 namespace diskspd {
 
+	/**
+	 *	One range of a --random-dist distribution: io_percent of random I/O goes to the next
+	 *	target_percent of the target
+	 */
+	struct RandomDistRange {
+		unsigned int io_percent;
+		unsigned int target_percent;
+	};
+
 	/**
 	 *	Represents a file or device to read/write from
 	 */
@@ -54,6 +64,9 @@ namespace diskspd {
 		bool use_random_alignment	= false;		// -r
 		bool use_interlocked		= false;		// -si
 
+		// ranges of the target in offset order; empty means uniformly random offsets
+		std::vector<RandomDistRange> random_dist;	// --random-dist
+
 		unsigned int write_percentage	= 0;		// -w
 
 		unsigned int threads_per_target = 1;		// -t
@@ -64,6 +77,8 @@ namespace diskspd {
 
 		off_t max_throughput		= 0;			// -g, 0 denotes no throttling
 
+		unsigned int group			= 0;			// --group; 0 for the command line's own targets
+
 		// interlocked offset shared by all threads working on this file
 		off_t interlocked_offset	= 0;			// si
 		std::mutex interlocked_mutex;				// si
@@ -95,6 +110,10 @@ namespace diskspd {
 		IoBucketizer read_bucketizer;
 		IoBucketizer write_bucketizer;
 
+		// --chain passes, --lsm lookups and --wal commits: work made up of several ops or waits,
+		// and how long each took (us)
+		uint64_t chain_count = 0;
+		Histogram<uint64_t> chain_latency_histogram;
 	};
 
 	/**
@@ -140,7 +159,7 @@ namespace diskspd {
 			 */
 			~TargetBuffer() {
 				if (_sz) {
-					free(_unaligned);
+					release(_unaligned, _sz+_align-1);
 				}
 			}
 			/**
@@ -148,7 +167,7 @@ namespace diskspd {
 			 */
 			void calloc(size_t size, size_t align) {
 				if (_sz) {
-					free(_unaligned);
+					release(_unaligned, _sz+_align-1);
 				}
 				_sz = size;
 				_align = align;
@@ -177,6 +196,17 @@ namespace diskspd {
 			inline void * ptr() const { return _ptr; }	// get the pointer to the buffer
 			inline size_t size() const { return _sz; }
 
+			/**
+			 *	Keep freed buffers for later ones of the same size instead of freeing them, so a
+			 *	--daemon's runs get buffers that are already faulted in
+			 */
+			static void keep_freed(bool keep);
+
+			/**
+			 *	Free the kept buffers that no buffer has reused since the last call
+			 */
+			static void trim_kept();
+
 		private:
 			void new_buffer() {
 				// don't allocate a buffer if no size
@@ -185,11 +215,17 @@ namespace diskspd {
 				// check align is a power of 2 or == 1
 				assert(_align && (_align == 1 || !(_align & (_align - 1))));
 				// allocate enough space to guarantee we can produce an aligned buffer
-				_unaligned = std::calloc(_sz+_align-1, 1);
+				_unaligned = allocate(_sz+_align-1);
 				assert(_unaligned);
 
 				_ptr = reinterpret_cast<void *>(((size_t)_unaligned + _align - 1) & ~(_align - 1));
 			}
+			/**
+			 *	Zeroed memory, kept from an earlier buffer if it can be
+			 */
+			static void * allocate(size_t size);
+			static void release(void * unaligned, size_t size);
+
 			void * _unaligned = nullptr;	// pointer to real base of buffer
 			void * _ptr = nullptr;			// pointer to aligned base of buffer
 			size_t _sz = 0;					// size of aligned buffer
@@ -287,14 +323,39 @@ namespace diskspd {
 		 */
 		inline off_t random_offset() {
 			off_t alignment = target->stride;
+			off_t base = target->base_offset;
 			// generate a random offset aligned to random_alignment in the [base_offset,max_size) interval
 			off_t interval = target->max_size - target->base_offset - target->block_size;
 			interval -= (interval % alignment);
+
+			// --random-dist; narrow the interval down to the range the percentage falls in
+			if (!target->random_dist.empty()) {
+				off_t span = target->max_size - target->base_offset;
+				unsigned int pct = rng_engine->get_percentage();
+				unsigned int io_pct = 0;
+				unsigned int target_pct = 0;
+				for (auto& range : target->random_dist) {
+					io_pct += range.io_percent;
+					if (pct <= io_pct) {
+						// round the start of the range up to the alignment
+						off_t start = span*target_pct/100;
+						start = std::min((start + alignment - 1)/alignment*alignment, interval);
+						// the last offset in the range that doesn't overflow the target
+						off_t end = span*(target_pct + range.target_percent)/100 - 1;
+						end = std::min(end, interval);
+						base += start;
+						interval = end > start ? end - start : 0;
+						interval -= (interval % alignment);
+						break;
+					}
+					target_pct += range.target_percent;
+				}
+			}
 			off_t range = interval/alignment + 1;
 
 			off_t rnd =rng_engine->get_rand_offset(range);
 
-			return target->base_offset + rnd*alignment;
+			return base + rnd*alignment;
 		}
 	};
 } // namespace diskspd
@@ -7,6 +7,7 @@
 #include <cmath>
 #include <cstring>
 #include <unistd.h>
+#include <sys/prctl.h>
 
 #include "debug.h"
 #include "async_io.h"
@@ -15,6 +16,12 @@
 #include "job.h"
 #include "target.h"
 #include "thread.h"
+#include "idle.h"
+#include "weights.h"
+#include "throttle.h"
+#include "process.h"
+#include "qd.h"
+#include "scan.h"
 
 #include "perf_clock.h"
 #include "Histogram.h"
@@ -25,16 +32,14 @@ namespace diskspd {
 	void ThreadParams::thread_abort() {
 		*run_threads = false;						// stop all the other threads
 		*thread_error = true;						// signal to Job that a thread failed
-		if (initialized) {
+		if (event_fd != -1) {
+			ProcessWorkers::send(event_fd, ProcessWorkers::ABORTED);
+		} else if (initialized) {
 			job->thread_error_cv.notify_one();		// wake the Job thread
 		}
 	}
 
-	void ThreadParams::thread_func() {
-
-		/***********
-		 *	Setup
-		 ***********/
+	bool ThreadParams::thread_setup(size_t& total_overlap) {
 
 		// Initialize rng engine
 		if (job_options->use_time_seed) {
@@ -45,7 +50,7 @@ namespace diskspd {
 		rw_rng_engine = std::make_shared<RngEngine>();
 
 		// count total overlap for io_engine initialization
-		size_t total_overlap = 0;
+		total_overlap = 0;
 
 		// figure out how many buckets to put in the read/write bucketizers
 		uint64_t bucket_duration = 0;
@@ -57,6 +62,12 @@ namespace diskspd {
 			valid_buckets = (size_t)std::ceil((double)(job_options->duration * 1000) / (double)bucket_duration);
 		}
 
+		// --stripe, --mirror and --erasure results for logical ops need bucketizers too
+		if (results->logical_results && job_options->measure_iops_std_dev) {
+			results->logical_results->read_bucketizer.Initialize(bucket_duration, valid_buckets);
+			results->logical_results->write_bucketizer.Initialize(bucket_duration, valid_buckets);
+		}
+
 		// open all the files etc
 		for (auto& t_data : targets) {
 
@@ -72,11 +83,13 @@ namespace diskspd {
 			}
 
 			// open an instance of this target and put it in the TargetData
-			t_data->fd = open(t_data->target->path.c_str(), t_data->target->open_flags);
+			// an --lsm target is the directory holding the tables, which is only opened to fsync it
+			t_data->fd = open(t_data->target->path.c_str(),
+					job_options->lsm ? O_RDONLY | O_DIRECTORY : t_data->target->open_flags);
 			if (t_data->fd == -1) {
 				perror("Failed to open target");
 				thread_abort();
-				return;
+				return false;
 			}
 
 			// create and initialize I/O buffers
@@ -114,79 +127,333 @@ namespace diskspd {
 			}
 		}
 
-		/*****************
-		 *	Initialize IO
-		 *****************/
-
 		// create the group for the io manager
 		if (!io_manager->create_group(thread_id, total_overlap)) {
 			thread_abort();
+			return false;
+		}
+		return true;
+	}
+
+	void ThreadParams::signal_initialized() {
+		// --processes; the Job is in another process
+		if (event_fd != -1) {
+			ProcessWorkers::send(event_fd, ProcessWorkers::INITIALIZED);
+			initialized = true;
 			return;
 		}
 
-		// generate I/O request details
-		int aio_result = 0;
+		std::unique_lock<std::mutex> thread_lock(job->thread_mutex);
+		job->thread_counter++;
+		thread_lock.unlock();
+		job->thread_cv.notify_one();
+
+		initialized = true;
+	}
+
+	bool ThreadParams::check_completion(const std::shared_ptr<IAsyncIop>& op) {
+		int err = op->get_errno();
+		int ret = op->get_ret();
+		if (err != 0) {
+			fprintf(stderr, "aio error: %s\n", strerror(err));
+			thread_abort();
+			return false;
+		}
+		if (ret != op->get_nbytes()) {
+			fprintf(stderr, "ret from aio not equal to block size, it's %d\n", ret);
+			thread_abort();
+			return false;
+		}
+		return true;
+	}
+
+	void ThreadParams::record_completion(const std::shared_ptr<IAsyncIop>& op, uint64_t abs_time_us) {
+
+		// an op timed just before the duration started, but reaped once record_results was set,
+		// isn't part of it, and would be a bucket far past the end of the bucketizer
+		uint64_t start_us = start_time_us ? *start_time_us : job_options->start_time_us;
+		if (abs_time_us < start_us) {
+			return;
+		}
+
+		std::shared_ptr<TargetData> t_data = op->get_target_data();
+		int ret = op->get_ret();
+
+		t_data->results->bytes_count += ret;
+		++t_data->results->iops_count;
+
+		uint64_t since_start_us = 0;	// time since start of duration
+		uint64_t op_time_us = 0;		// time this op took to complete
+
+		if (job_options->measure_iops_std_dev || job_options->measure_latency) {
+			since_start_us = abs_time_us - start_us;
+			op_time_us = abs_time_us - op->get_time();
+		}
+
+		if (op->get_type() == IAsyncIop::Type::READ) {
+
+			++t_data->results->read_iops_count;
+			t_data->results->read_bytes_count += ret;
+
+			if (job_options->measure_iops_std_dev) {
+				t_data->results->read_bucketizer.Add(since_start_us/1000);
+			}
+
+			if (job_options->measure_latency) {
+				t_data->results->read_latency_histogram.Add(op_time_us);
+			}
+
+		} else {
+
+			++t_data->results->write_iops_count;
+			t_data->results->write_bytes_count += ret;
+
+			if (job_options->measure_iops_std_dev) {
+				t_data->results->write_bucketizer.Add(since_start_us/1000);
+			}
+
+			if (job_options->measure_latency) {
+				t_data->results->write_latency_histogram.Add(op_time_us);
+			}
 
-		// how much this thread throttles its throughput
-		// NOTE: this is clearly incorrect, but it matches the windows version of diskspd
-		off_t thread_throughput = targets[0]->target->max_throughput;
+		}
+	}
+
+	void ThreadParams::record_logical_completion(bool is_write, size_t nbytes,
+			uint64_t start_us, uint64_t abs_time_us) {
+
+		// as in record_completion()
+		uint64_t duration_start_us = start_time_us ? *start_time_us : job_options->start_time_us;
+		if (abs_time_us < duration_start_us) {
+			return;
+		}
+
+		TargetResults& results = *this->results->logical_results;
+
+		results.bytes_count += nbytes;
+		++results.iops_count;
+
+		uint64_t since_start_us = abs_time_us - duration_start_us;
+		uint64_t op_time_us = abs_time_us - start_us;
+
+		if (!is_write) {
+
+			++results.read_iops_count;
+			results.read_bytes_count += nbytes;
+
+			if (job_options->measure_iops_std_dev) {
+				results.read_bucketizer.Add(since_start_us/1000);
+			}
+
+			if (job_options->measure_latency) {
+				results.read_latency_histogram.Add(op_time_us);
+			}
+
+		} else {
+
+			++results.write_iops_count;
+			results.write_bytes_count += nbytes;
+
+			if (job_options->measure_iops_std_dev) {
+				results.write_bucketizer.Add(since_start_us/1000);
+			}
+
+			if (job_options->measure_latency) {
+				results.write_latency_histogram.Add(op_time_us);
+			}
+
+		}
+	}
+
+	bool ThreadParams::do_work(const std::shared_ptr<IAsyncIop>& op, uint64_t abs_time_us,
+			uint64_t quota, bool& counted) {
 
+		const FixedWork& work = *job_options->work;
+		uint64_t amount = work.work(op->get_nbytes());
+
+		// the target's work is shared with its other threads
+		if (work.per_target) {
+			FixedWork::Progress& progress = *work.targets.at(op->get_target_data()->target.get());
+			uint64_t done = progress.done.fetch_add(amount);
+			counted = done < progress.quota;
+			if (counted && done + amount >= progress.quota) {
+				progress.finished_us = abs_time_us;
+			}
+			return done + amount < progress.quota;
+		}
+
+		WorkResults& work_results = *results->work_results;
+		counted = work_results.done < quota;
+		if (counted) {
+			work_results.done += amount;
+			if (work_results.done >= quota) {
+				work_results.finished_us = abs_time_us;
+			}
+		}
+		return work_results.done < quota;
+	}
+
+	void ThreadParams::release_targets() {
 		for (auto& t_data : targets) {
+			close(t_data->fd);
+		}
+	}
 
-			off_t curr_offset = t_data->get_start_offset();
-			//thread_throughput += t_data->target->max_throughput; // see above
+	void ThreadParams::thread_func() {
 
-			// for i in range(-o)
-			for (unsigned int i = 0; i < t_data->target->overlap; ++i) {
+		/***********
+		 *	Setup
+		 ***********/
 
-				// get the index into the buffer corresponding to this overlap
-				void * read_buf = static_cast<void *>(
-							&(
-								static_cast<char *>(
-									t_data->buffer.ptr())[i*t_data->target->block_size]
-							)
-						);
+		size_t total_overlap = 0;
+		if (!thread_setup(total_overlap)) {
+			return;
+		}
 
-				IAsyncIop::Type aio_type;
+		// replaying a trace is a different workload entirely
+		if (job_options->replay_trace) {
+			replay_func();
+			return;
+		}
 
-				// by default, write buffer is the same as read
-				void * write_buf = read_buf;
-				// use a different buffer for writes if -Zs specified
-				if(t_data->target->separate_buffers) {
-					write_buf = t_data->write_buffer.ptr();
-				}
+		// so are dependent chains, as slots don't simply restart their op
+		if (!job_options->chain.empty()) {
+			chain_func();
+			return;
+		}
 
-				// decide read or write
-				if (rw_rng_engine->get_percentage() <= t_data->target->write_percentage) {
-					aio_type = IAsyncIop::Type::WRITE;
+		if (job_options->lsm) {
+			lsm_func();
+			return;
+		}
 
-				} else {
-					aio_type = IAsyncIop::Type::READ;
-				}
+		if (job_options->wal) {
+			wal_func();
+			return;
+		}
 
-				// create an object to represent this op
-				std::shared_ptr<IAsyncIop> op = io_manager->construct(
-						aio_type,
-						t_data->fd,
-						curr_offset,
-						read_buf,
-						write_buf,
-						t_data->target->block_size,
-						thread_id,		// group id should be thread-unique, so just use thread_id
-						t_data,
-						PerfClock::get_time_us()
-						);
+		if (job_options->stripe) {
+			stripe_func();
+			return;
+		}
+
+		if (job_options->mirror) {
+			mirror_func();
+			return;
+		}
 
-				// enqueue it with the io manager
-				aio_result = io_manager->enqueue(op);
+		if (job_options->erasure) {
+			erasure_func();
+			return;
+		}
 
-				if (aio_result) {
-					perror("aio enqueue failed");
-					thread_abort();
+		// --ramp; a thread that isn't doing I/O yet counts as initialized, but waits for its
+		// step before starting its ops
+		if (job_options->ramp && thread_id >= job_options->ramp->active) {
+			signal_initialized();
+			while (thread_id >= job_options->ramp->active) {
+				if (!*run_threads) {
+					release_targets();
 					return;
 				}
+				usleep(1000);
+			}
+		}
 
-				curr_offset = t_data->get_next_offset(curr_offset);
+		// --scan; the scan starts with the measured duration, so the thread counts as
+		// initialized and waits for it before taking its first chunk
+		if (job_options->scan) {
+			signal_initialized();
+			while (!*record_results) {
+				if (!*run_threads) {
+					release_targets();
+					return;
+				}
+				usleep(100);
+			}
+		}
+
+		/*****************
+		 *	Initialize IO
+		 *****************/
+
+		// generate I/O request details
+		int aio_result = 0;
+
+		// --weights; a pool of -o slots shared by the targets, rather than -o per target
+		std::unique_ptr<WeightedSlots> weighted;
+		std::unique_ptr<ScanSlots> scanned;
+		size_t scan_started = 0;
+		if (job_options->weights) {
+			weighted.reset(new WeightedSlots(*this));
+			if (!weighted->start()) {
+				return;
+			}
+			total_overlap = weighted->size();
+		} else if (job_options->scan) {
+			// --scan; a pool of -o slots that go wherever the thread's chunks are
+			scanned.reset(new ScanSlots(*this));
+			if (!scanned->start(scan_started)) {
+				return;
+			}
+			total_overlap = scanned->size();
+		} else {
+			for (auto& t_data : targets) {
+
+				off_t curr_offset = t_data->get_start_offset();
+	
+				// for i in range(-o)
+				for (unsigned int i = 0; i < t_data->target->overlap; ++i) {
+
+					// get the index into the buffer corresponding to this overlap
+					void * read_buf = static_cast<void *>(
+								&(
+									static_cast<char *>(
+										t_data->buffer.ptr())[i*t_data->target->block_size]
+								)
+							);
+
+					IAsyncIop::Type aio_type;
+
+					// by default, write buffer is the same as read
+					void * write_buf = read_buf;
+					// use a different buffer for writes if -Zs specified
+					if(t_data->target->separate_buffers) {
+						write_buf = t_data->write_buffer.ptr();
+					}
+
+					// decide read or write
+					if (rw_rng_engine->get_percentage() <= t_data->target->write_percentage) {
+						aio_type = IAsyncIop::Type::WRITE;
+
+					} else {
+						aio_type = IAsyncIop::Type::READ;
+					}
+
+					// create an object to represent this op
+					std::shared_ptr<IAsyncIop> op = io_manager->construct(
+							aio_type,
+							t_data->fd,
+							curr_offset,
+							read_buf,
+							write_buf,
+							t_data->target->block_size,
+							thread_id,		// group id should be thread-unique, so just use thread_id
+							t_data,
+							PerfClock::get_time_us()
+							);
+
+					// enqueue it with the io manager
+					aio_result = io_manager->enqueue(op);
+
+					if (aio_result) {
+						perror("aio enqueue failed");
+						thread_abort();
+						return;
+					}
+
+					curr_offset = t_data->get_next_offset(curr_offset);
+				}
 			}
 		}
 
@@ -199,43 +466,109 @@ namespace diskspd {
 		}
 
 		// Unblock main thread (so the job can start the warmup/duration)
-		std::unique_lock<std::mutex> thread_lock(job->thread_mutex);
-		job->thread_counter++;
-		thread_lock.unlock();
-		job->thread_cv.notify_one();
-
-		initialized = true;
+		if (!initialized) {
+			signal_initialized();
+		}
 
 		/************
 		 *	Do Work
 		 ************/
 
-		off_t thread_bytes_count = 0;
+		// -g and --rate; ops wait here for their tokens
+		std::unique_ptr<ThreadThrottle> throttle;
+		bool throttled = job_options->rate != nullptr;
+		for (auto& t_data : targets) {
+			throttled |= t_data->target->max_throughput != 0;
+		}
+		if (throttled) {
+			throttle.reset(new ThreadThrottle(*this));
+			// the default timer slack of 50us would blur the pacing at high rates
+			prctl(PR_SET_TIMERSLACK, 1);
+		}
+
+		// --idle; ops held back while the Job drains for a gap
+		std::vector<std::shared_ptr<IAsyncIop>> parked;
+
+		// --qd-target; holds back the ops over the thread's queue depth limit
+		std::unique_ptr<QdController> qd;
+		if (job_options->qd_target) {
+			qd.reset(new QdController(*job_options->qd_target, total_overlap, *results->qd_results));
+		}
+
+		// --work and --scan; the ops that won't be restarted because there's nothing left for
+		// them to do. Once they all are, the thread tells the Job it's done
+		size_t retired = scanned ? total_overlap - scan_started : 0;
+		auto signal_done = [&]() {
+			if (scanned) {
+				results->scan_results->finished_us = PerfClock::get_time_us();
+			}
+			std::lock_guard<std::mutex> lock(job->thread_mutex);
+			++job->threads_done;
+			job->thread_error_cv.notify_one();
+		};
+
+		// --work; this thread's share of it if it's per thread
+		uint64_t work_quota = 0;
+		if (job_options->work) {
+			if (job_options->work->unit != FixedWork::PASS) {
+				work_quota = job_options->work->amount;
+			}
+			for (auto& t_data : targets) {
+				if (job_options->work->unit == FixedWork::PASS) {
+					work_quota += job_options->work->quota(*t_data->target);
+				}
+			}
+		}
+
+		// --scan; there may not have been a chunk for any of them
+		if (scanned && retired == total_overlap) {
+			signal_done();
+		}
 
 		// wait on ops finishing, restarting them at a new offset
-		while(*run_threads) {
-
-			// Throughput throttling (-g)
-			// We check the total throughput on this thread
-			// If it's too high, we sleep for a millisecond
-			// This matches the behavior of the Windows version
-			if (*record_results && thread_throughput) {
-				// get time since start of duration
-				uint64_t since_start_ms = PerfClock::get_time_ms() - job_options->start_time_ms;
-
-				if (since_start_ms != 0) {
-					// get an estimate of throughput by counting the bytes
-					off_t curr_bytes_per_ms = thread_bytes_count/since_start_ms;
-					// throttle if we're over the max
-					if (curr_bytes_per_ms > thread_throughput) {
-						usleep(1000);
-						continue;
+		while(*run_threads && retired < total_overlap) {
+
+			std::shared_ptr<IAsyncIop> op;
+
+			// -g and --rate; issue the held ops that are due, and otherwise wait for a
+			// completion no longer than until the next one is
+			if (throttle && throttle->held_ops()) {
+				uint64_t now_ns = PerfClock::get_time_ns();
+				uint64_t release_ns = throttle->next_release_ns();
+
+				if (release_ns <= now_ns) {
+					while (throttle->held_ops() && throttle->next_release_ns() <= now_ns) {
+						op = throttle->pop();
+						op->set_time(now_ns/1000);
+						if (io_manager->enqueue(op)) {
+							perror("aio enqueue failed");
+							thread_abort();
+							return;
+						}
 					}
+					if (io_manager->submit(thread_id)) {
+						perror("aio submit failed");
+						thread_abort();
+						return;
+					}
+					continue;
 				}
-			}
 
-			// block until an operation completes
-			std::shared_ptr<IAsyncIop> op = io_manager->wait(thread_id);
+				size_t spare_ops = qd ? qd->spare_ops() : 0;
+				if (throttle->held_ops() + spare_ops + parked.size() + retired == total_overlap) {
+					// nothing is in flight, so there's nothing to wait for but the clock; a
+					// slow rate still checks on the Job now and then
+					PerfClock::sleep_until_ns(std::min(release_ns, now_ns + 10000000));
+					continue;
+				}
+				op = io_manager->wait(thread_id, (release_ns - now_ns + 999)/1000);
+				if (!op) {
+					continue;
+				}
+			} else {
+				// block until an operation completes
+				op = io_manager->wait(thread_id);
+			}
 
 			// potentially exit right after waiting for io - improves accuracy of duration
 			if (!*run_threads) break;
@@ -244,73 +577,97 @@ namespace diskspd {
 			std::shared_ptr<TargetData> t_data = op->get_target_data();
 
 			// check for errors in the result
-			int err = op->get_errno();
-			int ret = op->get_ret();
-			if (err != 0) {
-				fprintf(stderr, "aio error: %s\n", strerror(err));
-				thread_abort();
-				return;
-			}
-			if (ret != t_data->target->block_size) {
-				fprintf(stderr, "ret from aio not equal to block size, it's %d\n", ret);
-				thread_abort();
+			if (!check_completion(op)) {
 				return;
 			}
 
 			uint64_t abs_time_us = PerfClock::get_time_us();
 
-			// record results if we're in the main duration
-			if (*record_results) {
-
-				// throughput monitoring for the whole thread
-				thread_bytes_count += t_data->target->block_size;
-
-				t_data->results->bytes_count += ret;
-				++t_data->results->iops_count;
-
-				uint64_t since_start_us = 0;	// time since start of duration
-				uint64_t op_time_us = 0;		// time this op took to complete
-
-				if (job_options->measure_iops_std_dev || job_options->measure_latency) {
-					since_start_us = abs_time_us - job_options->start_time_us;
-					op_time_us = abs_time_us - op->get_time();
-				}
+			// --work; an op isn't counted once its share of the work is done, and isn't
+			// restarted once it's done it
+			bool counted = true;
+			bool more_work = true;
+			if (job_options->work && *record_results) {
+				more_work = do_work(op, abs_time_us, work_quota, counted);
+			}
 
-				if (op->get_type() == IAsyncIop::Type::READ) {
+			// record results if we're in the main duration
+			if (*record_results && counted) {
 
-					++t_data->results->read_iops_count;
-					t_data->results->read_bytes_count += ret;
+				record_completion(op, abs_time_us);
 
-					if (job_options->measure_iops_std_dev) {
-						t_data->results->read_bucketizer.Add(since_start_us/1000);
+				// --ramp; the step being measured gets it too
+				if (job_options->ramp) {
+					RampResults::Step& step = results->ramp_results->steps[job_options->ramp->current];
+					++step.ops;
+					step.bytes += op->get_nbytes();
+					if (job_options->measure_latency) {
+						step.latency_histogram.Add(abs_time_us - op->get_time());
 					}
+				}
+			}
 
+			// --steady; until then, it counts toward the warm up window
+			else if (job_options->steady) {
+				std::vector<WarmupResults::Window>& windows = results->warmup_results->windows;
+				unsigned int w = job_options->steady->current;
+				if (w < windows.size()) {
+					++windows[w].ops;
 					if (job_options->measure_latency) {
-						t_data->results->read_latency_histogram.Add(op_time_us);
+						windows[w].latency_histogram.Add(abs_time_us - op->get_time());
 					}
+				}
+			}
 
-				} else {
+			// --work; the thread is done with its share once every op is
+			if (!more_work) {
+				if (++retired == total_overlap) {
+					signal_done();
+				}
+				continue;
+			}
 
-					++t_data->results->write_iops_count;
-					t_data->results->write_bytes_count += ret;
+			// --qd-target; the op's latency counts toward the current window
+			if (qd) {
+				qd->completed(op->get_time(), abs_time_us, *record_results);
+			}
 
-					if (job_options->measure_iops_std_dev) {
-						t_data->results->write_bucketizer.Add(since_start_us/1000);
-					}
+			// --cache; the op's pages are cached now, and a read was a miss
+			if (job_options->cache) {
+				job_options->cache->insert(t_data->target.get(), op->get_offset(), op->get_nbytes());
 
+				if (*record_results && op->get_type() == IAsyncIop::Type::READ) {
+					CacheResults& cache_results = *results->cache_results;
+					++cache_results.misses;
+					cache_results.miss_bytes += op->get_nbytes();
 					if (job_options->measure_latency) {
-						t_data->results->write_latency_histogram.Add(op_time_us);
+						cache_results.miss_latency_histogram.Add((abs_time_us - op->get_time())*1000);
 					}
+				}
+			}
 
+			// --weights; the slot's next op may be on another target
+			if (weighted) {
+				op = weighted->next_op(op);
+				t_data = op->get_target_data();
+			} else if (scanned) {
+				// --scan; the slot's next block may be on another target, or there may be none
+				op = scanned->next_op(op);
+				if (!op) {
+					if (++retired == total_overlap) {
+						signal_done();
+					}
+					continue;
 				}
+				t_data = op->get_target_data();
+			} else {
+				// update op offset
+				op->set_offset(t_data->get_next_offset(op->get_offset()));
 			}
 
 			// update op time
 			op->set_time(abs_time_us);
 
-			// update op offset
-			op->set_offset(t_data->get_next_offset(op->get_offset()));
-
 			//v_printf("Starting op at %lu\n", op->get_offset());
 
 			// change op type. this will switch from read to write buffer if necessary
@@ -322,6 +679,59 @@ namespace diskspd {
 
 			}
 
+			// --cache; reads that hit don't go to the target
+			if (job_options->cache && !skip_cache_hits(op)) {
+				break;
+			}
+
+			// --idle; once a gap is due, hold the op back until all of them are
+			if (job_options->idle && job_options->idle->due(abs_time_us)) {
+				parked.push_back(op);
+				if (parked.size() < total_overlap) {
+					continue;
+				}
+				if (!idle_gap(parked)) {
+					break;
+				}
+				continue;
+			}
+
+			// --qd-target; hold the op back if the thread is over its queue depth limit, and
+			// issue spares if the limit went up
+			if (qd) {
+				if (total_overlap - qd->spare_ops() > qd->limit()) {
+					qd->hold(op);
+					continue;
+				}
+				while (qd->spare_ops() && total_overlap - qd->spare_ops() < qd->limit()) {
+					std::shared_ptr<IAsyncIop> spare = qd->pop();
+					spare->set_time(abs_time_us);
+					if (throttle) {
+						uint64_t now_ns = PerfClock::get_time_ns();
+						uint64_t release_ns = throttle->reserve(spare, now_ns);
+						if (release_ns > now_ns) {
+							throttle->hold(spare, release_ns);
+							continue;
+						}
+					}
+					if (io_manager->enqueue(spare)) {
+						perror("aio enqueue failed");
+						thread_abort();
+						return;
+					}
+				}
+			}
+
+			// -g and --rate; hold it back if it has to wait for tokens
+			if (throttle) {
+				uint64_t now_ns = PerfClock::get_time_ns();
+				uint64_t release_ns = throttle->reserve(op, now_ns);
+				if (release_ns > now_ns) {
+					throttle->hold(op, release_ns);
+					continue;
+				}
+			}
+
 			// re-queue and submit it
 			aio_result = io_manager->enqueue(op);
 			if (aio_result) {
@@ -338,9 +748,7 @@ namespace diskspd {
 		}
 
 		// release resources
-		for (auto& t_data : targets) {
-			close(t_data->fd);
-		}
+		release_targets();
 
 		v_printf("Ending thread %d\n", thread_id);
 	}
@@ -14,10 +14,20 @@
 namespace diskspd {
 
 	struct TargetResults;
+	struct MirrorResults;
+	struct ErasureResults;
+	struct CacheResults;
+	struct IdleResults;
+	struct QdResults;
+	struct RampResults;
+	struct WarmupResults;
+	struct WorkResults;
+	struct ScanResults;
 	struct TargetData;
 	class Job;
 	struct JobOptions;
 	class IAsyncIOManager;
+	class IAsyncIop;
 
 	/**
 	 *	Results collected by a single thread, updated as the Job runs
@@ -26,6 +36,37 @@ namespace diskspd {
 		unsigned int thread_id;
 
 		std::vector<std::shared_ptr<TargetResults>> target_results;
+
+		// --stripe, --mirror and --erasure; results for the logical ops on the stripe set, mirror
+		// or erasure coded set
+		std::shared_ptr<TargetResults> logical_results;
+
+		// --mirror; hedged read results
+		std::shared_ptr<MirrorResults> mirror_results;
+
+		// --erasure; parity math results
+		std::shared_ptr<ErasureResults> erasure_results;
+
+		// --cache; buffer cache hits and misses
+		std::shared_ptr<CacheResults> cache_results;
+
+		// --idle; latency of the probes after idle gaps
+		std::shared_ptr<IdleResults> idle_results;
+
+		// --qd-target; the queue depth each thread settled on
+		std::shared_ptr<QdResults> qd_results;
+
+		// --ramp; what completed in each step
+		std::shared_ptr<RampResults> ramp_results;
+
+		// --steady; what completed in each warm up window
+		std::shared_ptr<WarmupResults> warmup_results;
+
+		// --work; how much of its share of the work this thread did, and when
+		std::shared_ptr<WorkResults> work_results;
+
+		// --scan; the chunks this thread scanned, and when it was done
+		std::shared_ptr<ScanResults> scan_results;
 	};
 
 	/**
@@ -63,6 +104,11 @@ namespace diskspd {
 		volatile bool * record_results;
 		volatile bool * thread_error;
 
+		/// --processes; in a worker process, the pipe it tells the Job about its progress on,
+		/// and the Job's start time, which its copy of the JobOptions doesn't have
+		int event_fd = -1;
+		volatile uint64_t * start_time_us = nullptr;
+
 		std::shared_ptr<RngEngine> rng_engine;		 // used for random offsets; default is seeded with 0
 		std::shared_ptr<RngEngine> rw_rng_engine;	 // use for deciding read/write; seeded with random_device
 
@@ -71,6 +117,101 @@ namespace diskspd {
 		 */
 		void thread_func();
 
+		/**
+		 *	Thread function for --replay; issues the ops of one traced thread
+		 */
+		void replay_func();
+
+		/**
+		 *	Thread function for --chain; each slot issues the steps of the chain one after the other
+		 */
+		void chain_func();
+
+		/**
+		 *	Thread function for --lsm; a flush, compaction or point lookup thread, depending on
+		 *	rel_thread_id
+		 */
+		void lsm_func();
+
+		/**
+		 *	Thread function for --wal; commits records to the log, leading a group commit
+		 *	whenever no other thread is
+		 */
+		void wal_func();
+
+		/**
+		 *	Thread function for --stripe; each slot issues logical ops on the stripe set,
+		 *	split into ops on the members
+		 */
+		void stripe_func();
+
+		/**
+		 *	Thread function for --mirror; each slot issues logical ops on the mirror, writing to
+		 *	every replica and reading from one, hedging slow reads to another
+		 */
+		void mirror_func();
+
+		/**
+		 *	Thread function for --erasure; each slot issues logical ops on the erasure coded set,
+		 *	encoding and writing every chunk, or reading any K and rebuilding the data
+		 */
+		void erasure_func();
+
+		/**
+		 *	Seed the rng engines, open the targets, allocate their buffers and create this thread's
+		 *	io manager group. Sets total_overlap to the total -o of all this thread's targets
+		 */
+		bool thread_setup(size_t& total_overlap);
+
+		/**
+		 *	Tell the Job this thread has submitted its first ops
+		 */
+		void signal_initialized();
+
+		/**
+		 *	Check a completed op for errors, aborting the Job if there are any
+		 */
+		bool check_completion(const std::shared_ptr<IAsyncIop>& op);
+
+		/**
+		 *	Add a completed op to its target's results
+		 */
+		void record_completion(const std::shared_ptr<IAsyncIop>& op, uint64_t abs_time_us);
+
+		/**
+		 *	Add a completed logical op (--stripe, --mirror or --erasure), which started at start_us, to
+		 *	results->logical_results
+		 */
+		void record_logical_completion(bool is_write, size_t nbytes, uint64_t start_us,
+				uint64_t abs_time_us);
+
+		/**
+		 *	--cache; look op up in the buffer cache if it's a read. Each hit is counted and
+		 *	completed on the spot, and op moves on to its next offset, until it's a write or a
+		 *	miss that needs to go to the target. Returns false if the Job ended first
+		 */
+		bool skip_cache_hits(const std::shared_ptr<IAsyncIop>& op);
+
+		/**
+		 *	--idle; called once all of this thread's ops are held back in parked. Waits for the
+		 *	other threads to drain, and if this one is the last, leaves the device idle for the
+		 *	gap and probes it. Then restarts the parked ops. Returns false if the Job ended first
+		 */
+		bool idle_gap(std::vector<std::shared_ptr<IAsyncIop>>& parked);
+
+		/**
+		 *	--work; count a completed op toward its share of the work, quota being this
+		 *	thread's share if the work is per thread. Sets counted if it was still needed, and
+		 *	returns whether there's more of that share to do
+		 */
+		bool do_work(const std::shared_ptr<IAsyncIop>& op, uint64_t abs_time_us, uint64_t quota,
+				bool& counted);
+
+		/**
+		 *	Close this thread's targets
+		 */
+		void release_targets();
+
 		/**
 		 *	Abort the Job and tell it that a thread failed
 		 */
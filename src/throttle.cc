@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "throttle.h"
+
+namespace diskspd {
+
+	uint64_t TokenBucket::reserve(uint64_t now_ns, uint64_t cost) {
+
+		if (!ns_per_unit) {
+			return now_ns;
+		}
+		uint64_t cost_ns = (uint64_t)(cost*ns_per_unit);
+
+		uint64_t prev = tat.load();
+		uint64_t release_ns;
+		uint64_t next;
+		do {
+			// a full bucket, or one that's been left alone a while, lets the op go now
+			release_ns = std::max(now_ns, prev > burst_ns ? prev - burst_ns : 0);
+			next = std::max(prev, release_ns) + cost_ns;
+		} while (!tat.compare_exchange_weak(prev, next));
+
+		return release_ns;
+	}
+
+	uint64_t RateBuckets::reserve(uint64_t now_ns, size_t nbytes) {
+		return std::max(iops.reserve(now_ns, 1), bytes.reserve(now_ns, nbytes));
+	}
+
+	bool RateLimits::parse(const char * arg) {
+
+		std::string list(arg);
+		size_t pos = 0;
+		while (pos <= list.size()) {
+			size_t end = list.find(',', pos);
+			if (end == std::string::npos) end = list.size();
+
+			std::string entry = list.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t colon = entry.find(':');
+			std::string scope = entry.substr(0, colon);
+			std::string value = colon == std::string::npos ? "" : entry.substr(colon + 1);
+
+			Limit * limit =
+				scope == "target" ? &target :
+				scope == "thread" ? &thread :
+				scope == "job" ? &job : nullptr;
+			if (!limit || value.empty()) {
+				fprintf(stderr, "Invalid --rate entry \"%s\"; expected target, thread or job:LIMIT\n",
+						entry.c_str());
+				return false;
+			}
+
+			const std::string iops = "iops";
+			if (value.size() > iops.size() &&
+					value.compare(value.size() - iops.size(), iops.size(), iops) == 0) {
+				value.resize(value.size() - iops.size());
+				if (!Options::is_numeric(value.c_str()) || value == "0") {
+					fprintf(stderr, "Invalid --rate IOPS \"%s\"\n", entry.c_str());
+					return false;
+				}
+				limit->iops = strtoull(value.c_str(), nullptr, 10);
+			} else {
+				if (!Options::valid_byte_size(value.c_str()) || value.back() == 'b') {
+					fprintf(stderr, "Invalid --rate bandwidth \"%s\"\n", entry.c_str());
+					return false;
+				}
+				limit->bytes = Options::byte_size_from_arg(value.c_str(), 0);
+			}
+		}
+		return true;
+	}
+
+	void RateLimits::set_targets(const std::vector<std::shared_ptr<Target>>& targets) {
+		job_buckets.iops.set_rate(job.iops);
+		job_buckets.bytes.set_rate(job.bytes);
+		for (auto& t : targets) {
+			RateBuckets& buckets = target_buckets[t.get()];
+			buckets.iops.set_rate(target.iops);
+			buckets.bytes.set_rate(target.bytes);
+		}
+	}
+
+	ThreadThrottle::ThreadThrottle(ThreadParams& thread) : thread(thread) {
+
+		if (thread.job_options->rate) {
+			const RateLimits& rate = *thread.job_options->rate;
+			thread_buckets.iops.set_rate(rate.thread.iops);
+			thread_buckets.bytes.set_rate(rate.thread.bytes);
+		}
+
+		// -g is in bytes per millisecond
+		for (auto& t_data : thread.targets) {
+			max_throughput_buckets[t_data->target.get()].bytes.set_rate(
+					t_data->target->max_throughput*1000.0);
+		}
+	}
+
+	uint64_t ThreadThrottle::reserve(const std::shared_ptr<IAsyncIop>& op, uint64_t now_ns) {
+
+		const Target * target = op->get_target_data()->target.get();
+		size_t nbytes = op->get_nbytes();
+
+		uint64_t release_ns = max_throughput_buckets.at(target).reserve(now_ns, nbytes);
+		release_ns = std::max(release_ns, thread_buckets.reserve(now_ns, nbytes));
+
+		if (thread.job_options->rate) {
+			RateLimits& rate = *thread.job_options->rate;
+			release_ns = std::max(release_ns, rate.target_buckets.at(target).reserve(now_ns, nbytes));
+			release_ns = std::max(release_ns, rate.job_buckets.reserve(now_ns, nbytes));
+		}
+		return release_ns;
+	}
+
+} // namespace diskspd
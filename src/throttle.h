@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <queue>
+#include <utility>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#ifndef DISKSPD_THROTTLE_H
+#define DISKSPD_THROTTLE_H
+
+namespace diskspd {
+
+	struct Target;
+	struct ThreadParams;
+	class IAsyncIop;
+
+	/**
+	 *	A token bucket, as the generic cell rate algorithm: rather than counting tokens, it keeps
+	 *	the time the bucket will next be full (tat), and an op takes its cost off by moving that
+	 *	forward. Reserving is a compare and swap, so threads can share a bucket without a lock.
+	 *	Up to a millisecond's worth of tokens can be banked, so an op that goes a little late
+	 *	doesn't lower the rate
+	 */
+	class TokenBucket {
+		public:
+			static const uint64_t burst_ns = 1000000;
+
+			/**
+			 *	Set the rate in units (ops or bytes) per second; 0 is unlimited
+			 */
+			void set_rate(double per_second) {
+				ns_per_unit = per_second ? 1e9/per_second : 0;
+			}
+
+			inline bool limited() const { return ns_per_unit != 0; }
+
+			/**
+			 *	Take cost units for an op ready at now_ns. Returns when it may go, which is
+			 *	now_ns or later
+			 */
+			uint64_t reserve(uint64_t now_ns, uint64_t cost);
+
+		private:
+			double ns_per_unit = 0;
+			std::atomic<uint64_t> tat{0};
+	};
+
+	/**
+	 *	An IOPS and a bandwidth bucket for one scope
+	 */
+	struct RateBuckets {
+		TokenBucket iops;
+		TokenBucket bytes;
+
+		inline bool limited() const { return iops.limited() || bytes.limited(); }
+
+		/**
+		 *	Reserve an op of nbytes in both; returns when it may go
+		 */
+		uint64_t reserve(uint64_t now_ns, size_t nbytes);
+	};
+
+	/**
+	 *	Rate limits for --rate, in ops and bytes per second, at three scopes: each target (all
+	 *	threads' ops on it), each thread, and the whole Job. An op waits until all of the
+	 *	buckets it's in allow it
+	 */
+	struct RateLimits {
+		struct Limit {
+			uint64_t iops		= 0;
+			uint64_t bytes		= 0;
+		};
+		Limit target;
+		Limit thread;
+		Limit job;
+
+		RateBuckets job_buckets;
+		std::map<const Target *, RateBuckets> target_buckets;
+
+		/**
+		 *	Parse a --rate argument: comma separated SCOPE:LIMIT, where SCOPE is target, thread
+		 *	or job, and LIMIT is a number of ops with an iops suffix, or a byte size (K|M|G)
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	Set up the buckets, once the Job's targets are known
+		 */
+		void set_targets(const std::vector<std::shared_ptr<Target>>& targets);
+	};
+
+	/**
+	 *	A thread's side of -g and --rate: its own buckets, and the ops waiting on tokens
+	 */
+	class ThreadThrottle {
+		public:
+			ThreadThrottle(ThreadParams& thread);
+
+			/**
+			 *	Reserve tokens for op, ready at now_ns, in every bucket it's in. Returns when it
+			 *	may go
+			 */
+			uint64_t reserve(const std::shared_ptr<IAsyncIop>& op, uint64_t now_ns);
+
+			/**
+			 *	Hold an op back until release_ns
+			 */
+			inline void hold(const std::shared_ptr<IAsyncIop>& op, uint64_t release_ns) {
+				held.push({ release_ns, op });
+			}
+
+			inline size_t held_ops() const { return held.size(); }
+			inline uint64_t next_release_ns() const { return held.top().first; }
+
+			inline std::shared_ptr<IAsyncIop> pop() {
+				std::shared_ptr<IAsyncIop> op = held.top().second;
+				held.pop();
+				return op;
+			}
+
+		private:
+			ThreadParams& thread;
+
+			RateBuckets thread_buckets;
+			// -g is per thread per target
+			std::map<const Target *, RateBuckets> max_throughput_buckets;
+
+			typedef std::pair<uint64_t, std::shared_ptr<IAsyncIop>> HeldOp;
+			struct Later {
+				bool operator()(const HeldOp& a, const HeldOp& b) const { return a.first > b.first; }
+			};
+			std::priority_queue<HeldOp, std::vector<HeldOp>, Later> held;
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_THROTTLE_H
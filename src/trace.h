@@ -0,0 +1,54 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <cstdint>
+
+#ifndef DISKSPD_TRACE_H
+#define DISKSPD_TRACE_H
+
+namespace diskspd {
+
+	/**
+	 *	On-disk format of an I/O trace, written by the LD_PRELOAD capture library
+	 *	(src/capture/diskspd_capture.cc) and read back by diskspd for --replay.
+	 *
+	 *	A trace is a TraceHeader followed by a stream of fixed size TraceRecords. Records with
+	 *	op == TRACE_OP_PATH define a path and are immediately followed by 'size' bytes of path
+	 *	name (not null terminated). A path is always defined before the first record using it.
+	 *	Records from different threads are not ordered relative to each other, but the records of
+	 *	any single thread are in time order.
+	 */
+
+	const char TRACE_MAGIC[8] = {'D','S','P','D','T','R','C','\0'};
+	const uint32_t TRACE_VERSION = 1;
+
+	enum TraceOp : uint8_t {
+		TRACE_OP_READ	= 0,
+		TRACE_OP_WRITE	= 1,
+		TRACE_OP_SYNC	= 2,	// fsync or fdatasync
+		TRACE_OP_PATH	= 3		// defines path_id; followed by the path name
+	};
+
+	struct TraceHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t record_size;		// sizeof(TraceRecord), for sanity checking
+		uint64_t start_time_ns;		// CLOCK_MONOTONIC time the capture started
+	};
+
+	struct TraceRecord {
+		uint64_t time_ns;			// CLOCK_MONOTONIC time the op was issued
+		uint64_t offset;			// file offset in bytes
+		uint32_t size;				// bytes transferred, or length of the path for TRACE_OP_PATH
+		uint32_t tid;				// kernel thread id of the issuing thread
+		uint32_t path_id;			// index of the path this op was issued against
+		uint8_t op;					// TraceOp
+		uint8_t reserved[3];
+	};
+
+	static_assert(sizeof(TraceHeader) == 24, "TraceHeader layout changed");
+	static_assert(sizeof(TraceRecord) == 32, "TraceRecord layout changed");
+
+} // namespace diskspd
+
+#endif // DISKSPD_TRACE_H
@@ -0,0 +1,174 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+#include "debug.h"
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "wal.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool WalLog::parse(const char * arg) {
+
+		std::string range(arg);
+		size_t dash = range.find('-');
+		if (dash == std::string::npos) {
+			fprintf(stderr, "Invalid --wal argument; expected MIN_SIZE-MAX_SIZE\n");
+			return false;
+		}
+		std::string min = range.substr(0, dash);
+		std::string max = range.substr(dash + 1);
+
+		if (!Options::valid_byte_size(min.c_str()) || !Options::valid_byte_size(max.c_str())) {
+			fprintf(stderr, "Invalid --wal record size\n");
+			return false;
+		}
+		min_record_size = Options::byte_size_from_arg(min.c_str(), 1);
+		max_record_size = Options::byte_size_from_arg(max.c_str(), 1);
+
+		if (min_record_size > max_record_size) {
+			fprintf(stderr, "--wal minimum record size is larger than the maximum\n");
+			return false;
+		}
+		return true;
+	}
+
+	void ThreadParams::wal_func() {
+
+		std::shared_ptr<TargetData>& t_data = targets[0];
+		const Target& target = *t_data->target;
+		WalLog& log = *job_options->wal;
+
+		// a leader's batch holds at most one record from every thread, padded for O_DIRECT
+		size_t align = target.open_flags & O_DIRECT ? target.sector_size : 1;
+		size_t batch_max = job_options->total_threads*log.max_record_size + align;
+		TargetBuffer batch_buf(batch_max, align);
+
+		std::shared_ptr<IAsyncIop> op = io_manager->construct(
+				IAsyncIop::Type::WRITE,
+				t_data->fd,
+				target.base_offset,
+				batch_buf.ptr(),
+				batch_buf.ptr(),
+				batch_max,
+				thread_id,
+				t_data,
+				0
+				);
+
+		// Unblock main thread (so the job can start the warmup/duration)
+		signal_initialized();
+
+		/************
+		 *	Do Work
+		 ************/
+
+		while (*run_threads) {
+
+			WalRecord record;
+			record.data = t_data->buffer.ptr();
+			record.size = log.min_record_size +
+				rng_engine->get_rand_offset(log.max_record_size - log.min_record_size + 1);
+			record.durable = false;
+
+			uint64_t enqueue_us = PerfClock::get_time_us();
+
+			std::unique_lock<std::mutex> lock(log.mutex);
+			log.pending.push_back(&record);
+
+			while (!record.durable && !log.failed) {
+
+				if (log.leader_active) {
+					log.committed.wait(lock);
+					continue;
+				}
+
+				// lead: take everything pending (including our own record) as one batch
+				log.leader_active = true;
+				std::vector<WalRecord *> batch;
+				batch.swap(log.pending);
+
+				size_t nbytes = 0;
+				for (auto r : batch) nbytes += r->size;
+				nbytes = (nbytes + align - 1) & ~(align - 1);
+
+				off_t offset = log.tail;
+				if (offset < target.base_offset || offset + (off_t)nbytes > target.max_size) {
+					offset = target.base_offset;
+				}
+				log.tail = offset + nbytes;
+				lock.unlock();
+
+				size_t copied = 0;
+				for (auto r : batch) {
+					memcpy(static_cast<char *>(batch_buf.ptr()) + copied, r->data, r->size);
+					copied += r->size;
+				}
+
+				op->set_offset(offset);
+				op->set_nbytes(nbytes);
+				op->set_time(PerfClock::get_time_us());
+
+				bool ok = !io_manager->enqueue(op) && !io_manager->submit(thread_id);
+				if (ok) {
+					io_manager->wait(thread_id);
+					ok = check_completion(op);
+				} else {
+					perror("aio submit failed");
+				}
+				if (ok && fdatasync(t_data->fd)) {
+					perror("fdatasync failed");
+					ok = false;
+				}
+				if (ok && *record_results) {
+					record_completion(op, PerfClock::get_time_us());
+				}
+
+				lock.lock();
+				for (auto r : batch) r->durable = true;
+				if (ok && *record_results) {
+					++log.batches;
+					log.records += batch.size();
+					for (auto r : batch) log.record_bytes += r->size;
+					log.batch_histogram.Add(batch.size());
+				}
+				log.failed |= !ok;
+				log.leader_active = false;
+				log.committed.notify_all();
+			}
+
+			bool failed = log.failed;
+			lock.unlock();
+
+			if (failed) {
+				thread_abort();
+				return;
+			}
+
+			if (*record_results) {
+				++t_data->results->chain_count;
+				if (job_options->measure_latency) {
+					t_data->results->chain_latency_histogram.Add(PerfClock::get_time_us() - enqueue_us);
+				}
+			}
+		}
+
+		// release resources
+		release_targets();
+
+		v_printf("Ending thread %d\n", thread_id);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,60 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "Histogram.h"
+
+#ifndef DISKSPD_WAL_H
+#define DISKSPD_WAL_H
+
+namespace diskspd {
+
+	/**
+	 *	A record waiting to be committed to the log
+	 */
+	struct WalRecord {
+		const void * data;
+		size_t size;
+		bool durable;
+	};
+
+	/**
+	 *	Shared state of the --wal group commit workload. Threads add their records to 'pending';
+	 *	whichever thread finds no leader becomes the leader, takes every pending record, writes
+	 *	them to the tail of the log in one write and fdatasyncs it, then wakes the others
+	 */
+	struct WalLog {
+		size_t min_record_size		= 256;
+		size_t max_record_size		= 4096;
+
+		std::mutex mutex;
+		std::condition_variable committed;
+
+		std::vector<WalRecord *> pending;
+		bool leader_active			= false;
+		// set if a leader failed, so the threads waiting on it give up
+		bool failed					= false;
+
+		// offset of the next batch; the log wraps around at the target's max size
+		off_t tail					= 0;
+
+		// during the main duration only; protected by mutex
+		uint64_t batches			= 0;
+		uint64_t records			= 0;
+		uint64_t record_bytes		= 0;
+		Histogram<uint64_t> batch_histogram;	// records per batch
+
+		/**
+		 *	Parse a --wal argument: MIN_SIZE-MAX_SIZE
+		 */
+		bool parse(const char * arg);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_WAL_H
@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+
+#include "async_io.h"
+#include "options.h"
+#include "job.h"
+#include "target.h"
+#include "thread.h"
+#include "weights.h"
+
+#include "perf_clock.h"
+
+namespace diskspd {
+
+	bool TargetWeights::parse(const char * arg) {
+
+		std::string list(arg);
+		size_t pos = 0;
+		while (pos <= list.size()) {
+			size_t end = list.find(',', pos);
+			if (end == std::string::npos) end = list.size();
+
+			std::string entry = list.substr(pos, end - pos);
+			pos = end + 1;
+
+			std::string weight = entry;
+			std::string cap;
+			size_t colon = weight.find(':');
+			if (colon != std::string::npos) {
+				cap = weight.substr(colon + 1);
+				weight.resize(colon);
+			}
+
+			if (weight.empty() || !Options::is_numeric(weight.c_str()) ||
+					(colon != std::string::npos &&
+						(cap.empty() || !Options::is_numeric(cap.c_str()) || cap == "0"))) {
+				fprintf(stderr, "Invalid --weights entry \"%s\"; expected WEIGHT[:MAX_OUTSTANDING]\n",
+						entry.c_str());
+				return false;
+			}
+			weights.push_back(atoi(weight.c_str()));
+			max_overlap.push_back(cap.empty() ? 0 : atoi(cap.c_str()));
+		}
+		return true;
+	}
+
+	size_t WeightedSlots::pick_target() {
+
+		const TargetWeights& weights = *thread.job_options->weights;
+
+		unsigned int total = 0;
+		for (size_t t = 0; t < in_flight.size(); ++t) {
+			if (!weights.max_overlap[t] || in_flight[t] < weights.max_overlap[t]) {
+				total += weights.weights[t];
+			}
+		}
+
+		unsigned int r = thread.rng_engine->get_rand_offset(total);
+		for (size_t t = 0; t < in_flight.size(); ++t) {
+			if (weights.max_overlap[t] && in_flight[t] >= weights.max_overlap[t]) continue;
+			if (r < weights.weights[t]) {
+				return t;
+			}
+			r -= weights.weights[t];
+		}
+		// Profile makes sure the caps leave room for every slot
+		return in_flight.size() - 1;
+	}
+
+	std::shared_ptr<IAsyncIop> WeightedSlots::take(size_t slot) {
+
+		size_t t = pick_target();
+		++in_flight[t];
+
+		std::shared_ptr<TargetData>& t_data = thread.targets[t];
+		offsets[t] = started[t] ? t_data->get_next_offset(offsets[t]) : t_data->get_start_offset();
+		started[t] = true;
+
+		std::shared_ptr<IAsyncIop>& op = ops[slot][t];
+		op->set_offset(offsets[t]);
+		return op;
+	}
+
+	bool WeightedSlots::start() {
+
+		std::vector<std::shared_ptr<TargetData>>& targets = thread.targets;
+		in_flight.assign(targets.size(), 0);
+		offsets.assign(targets.size(), 0);
+		started.assign(targets.size(), false);
+
+		// the pool is -o slots; every target's buffer has room for that many
+		ops.resize(targets[0]->target->overlap);
+
+		for (size_t i = 0; i < ops.size(); ++i) {
+
+			for (auto& t_data : targets) {
+				void * read_buf = static_cast<char *>(t_data->buffer.ptr()) + i*t_data->target->block_size;
+				void * write_buf =
+					t_data->target->separate_buffers ? t_data->write_buffer.ptr() : read_buf;
+
+				ops[i].push_back(thread.io_manager->construct(
+						IAsyncIop::Type::READ,
+						t_data->fd,
+						t_data->target->base_offset,
+						read_buf,
+						write_buf,
+						t_data->target->block_size,
+						thread.thread_id,
+						t_data,
+						0
+						));
+				index[ops[i].back().get()] = { i, ops[i].size() - 1 };
+			}
+
+			std::shared_ptr<IAsyncIop> op = take(i);
+			if (thread.rw_rng_engine->get_percentage() <=
+					op->get_target_data()->target->write_percentage) {
+				op->set_type(IAsyncIop::Type::WRITE);
+			} else {
+				op->set_type(IAsyncIop::Type::READ);
+			}
+			op->set_time(PerfClock::get_time_us());
+
+			if (thread.io_manager->enqueue(op)) {
+				perror("aio enqueue failed");
+				thread.thread_abort();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::shared_ptr<IAsyncIop> WeightedSlots::next_op(const std::shared_ptr<IAsyncIop>& done) {
+
+		const std::pair<size_t, size_t>& slot_target = index[done.get()];
+		--in_flight[slot_target.second];
+		return take(slot_target.first);
+	}
+
+} // namespace diskspd
@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <memory>
+#include <sys/types.h>
+
+#ifndef DISKSPD_WEIGHTS_H
+#define DISKSPD_WEIGHTS_H
+
+namespace diskspd {
+
+	struct ThreadParams;
+	class IAsyncIop;
+
+	/**
+	 *	Per-target weights for threads that use every target (--weights with -F). A thread has
+	 *	a pool of -o slots rather than -o per target; whenever a slot's op completes, its next
+	 *	op goes to a target picked at random in proportion to the weights, among the targets
+	 *	that are under their own cap on outstanding ops
+	 */
+	struct TargetWeights {
+		std::vector<unsigned int> weights;
+		std::vector<unsigned int> max_overlap;	// 0 for no cap
+
+		/**
+		 *	Parse a --weights argument: WEIGHT[:MAX_OUTSTANDING] for each target, comma separated
+		 */
+		bool parse(const char * arg);
+	};
+
+	/**
+	 *	A thread's pool of slots for --weights
+	 */
+	class WeightedSlots {
+		public:
+			WeightedSlots(ThreadParams& thread) : thread(thread) {}
+
+			/**
+			 *	Create the ops for every slot on every target, and enqueue each slot's first op.
+			 *	Doesn't submit them
+			 */
+			bool start();
+
+			/**
+			 *	A slot's op completed; returns the op for the slot's next target, at that target's
+			 *	next offset
+			 */
+			std::shared_ptr<IAsyncIop> next_op(const std::shared_ptr<IAsyncIop>& done);
+
+			inline size_t size() const { return ops.size(); }
+
+		private:
+			ThreadParams& thread;
+
+			// [slot][target]; a slot has an op with its own buffer on every target
+			std::vector<std::vector<std::shared_ptr<IAsyncIop>>> ops;
+			// the slot and target of each op
+			std::map<IAsyncIop *, std::pair<size_t, size_t>> index;
+
+			std::vector<unsigned int> in_flight;
+			// each target's offsets follow on from the last op on it, whichever slot that was
+			std::vector<off_t> offsets;
+			std::vector<bool> started;
+
+			size_t pick_target();
+			std::shared_ptr<IAsyncIop> take(size_t slot);
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_WEIGHTS_H
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <assert.h>
+
+#include "options.h"
+#include "target.h"
+#include "work.h"
+
+namespace diskspd {
+
+	bool FixedWork::parse(const char * arg) {
+
+		std::string settings(arg);
+		bool have_work = false;
+		size_t pos = 0;
+		while (pos < settings.size()) {
+			size_t end = settings.find(',', pos);
+			if (end == std::string::npos) end = settings.size();
+
+			std::string setting = settings.substr(pos, end - pos);
+			pos = end + 1;
+
+			size_t eq = setting.find('=');
+			std::string key = setting.substr(0, eq);
+			std::string value = eq == std::string::npos ? "" : setting.substr(eq + 1);
+
+			bool valid = true;
+			if (key == "pass" && eq == std::string::npos) {
+				unit = PASS;
+				have_work = true;
+			} else if (key == "ops" && Options::is_numeric(value.c_str())) {
+				unit = OPS;
+				amount = strtoull(value.c_str(), nullptr, 10);
+				valid = amount > 0;
+				have_work = true;
+			} else if (key == "bytes" && Options::valid_byte_size(value.c_str()) && value.back() != 'b') {
+				unit = BYTES;
+				amount = Options::byte_size_from_arg(value.c_str(), 0);
+				valid = amount > 0;
+				have_work = true;
+			} else if (key == "per" && (value == "thread" || value == "target")) {
+				per_target = value == "target";
+			} else {
+				valid = false;
+			}
+			if (!valid) {
+				fprintf(stderr, "Invalid --work setting \"%s\"\n", setting.c_str());
+				return false;
+			}
+		}
+		if (!have_work) {
+			fprintf(stderr, "--work needs ops=N, bytes=SIZE or pass\n");
+			return false;
+		}
+		return true;
+	}
+
+	uint64_t FixedWork::quota(const Target& target) const {
+		return unit == PASS ? target.max_size - target.base_offset : amount;
+	}
+
+} // namespace diskspd
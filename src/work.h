@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#ifndef DISKSPD_WORK_H
+#define DISKSPD_WORK_H
+
+namespace diskspd {
+
+	struct Target;
+
+	/**
+	 *	Per-thread fixed work results (--work): how much of its share a thread has done, and
+	 *	when it was all done, as an absolute time in microseconds (0 if it never was)
+	 */
+	struct WorkResults {
+		uint64_t done				= 0;
+		uint64_t finished_us		= 0;
+	};
+
+	/**
+	 *	A fixed amount of work to do (--work) rather than a fixed duration, which becomes the
+	 *	longest it can take: a number of ops, a number of bytes, or a pass, which is the bytes
+	 *	in [base_offset, max_size) of a target. The work is either each thread's, across its
+	 *	targets, or each target's, across its threads.
+	 *
+	 *	Work is counted as ops complete in the measured duration. Once a share is done, the
+	 *	ops on it aren't restarted, and any that were still in flight aren't counted
+	 */
+	struct FixedWork {
+		enum Unit {
+			OPS,
+			BYTES,
+			PASS
+		};
+		Unit unit					= PASS;
+		uint64_t amount				= 0;
+		bool per_target				= false;	// per=
+
+		/**
+		 *	A target's progress, when per_target
+		 */
+		struct Progress {
+			uint64_t quota			= 0;
+			std::atomic<uint64_t> done{0};
+			std::atomic<uint64_t> finished_us{0};
+		};
+		// set up by the Job before any thread starts
+		std::map<const Target *, std::unique_ptr<Progress>> targets;
+
+		/**
+		 *	Parse a --work argument: ops=N, bytes=SIZE or pass, then optionally
+		 *	per=thread or per=target
+		 */
+		bool parse(const char * arg);
+
+		/**
+		 *	The work there is for a target
+		 */
+		uint64_t quota(const Target& target) const;
+
+		/**
+		 *	The work a completed op did
+		 */
+		inline uint64_t work(size_t nbytes) const {
+			return unit == OPS ? 1 : nbytes;
+		}
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_WORK_H
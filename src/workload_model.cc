@@ -0,0 +1,337 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <map>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "workload_model.h"
+
+namespace diskspd {
+
+	// resolution of the offset distribution; each bucket is 1% of the extent
+	static const unsigned int OFFSET_BUCKETS = 100;
+	// most ranges a fitted offset distribution is reduced to
+	static const size_t MAX_DIST_RANGES = 10;
+	// neighbouring ranges whose densities are within this many standard errors of each other are
+	// indistinguishable from noise, and are always merged
+	static const double DIST_MERGE_THRESHOLD = 3;
+
+	/**
+	 *	A run of offset buckets with similar density, used while fitting the offset distribution
+	 */
+	struct BucketRange {
+		unsigned int width;		// in buckets
+		uint64_t ops;
+
+		double density() const { return (double)ops/width; }
+	};
+
+	/**
+	 *	How different the densities of two neighbouring ranges are, in standard errors; op counts
+	 *	are treated as poisson so the variance of a count is the count itself
+	 */
+	static double merge_cost(const BucketRange& a, const BucketRange& b) {
+		double variance = (double)a.ops/(a.width*a.width) + (double)b.ops/(b.width*b.width);
+		return variance ? std::fabs(a.density() - b.density())/std::sqrt(variance) : 0;
+	}
+
+	/**
+	 *	Reduce per-bucket op counts to a handful of ranges of similar density, and express them as
+	 *	--random-dist percentages
+	 */
+	static std::vector<RandomDistRange> fit_offset_dist(const std::vector<uint64_t>& buckets,
+			uint64_t total) {
+
+		std::vector<BucketRange> ranges;
+		for (auto count : buckets) {
+			ranges.push_back({1, count});
+		}
+
+		// repeatedly merge the most similar neighbours
+		while (ranges.size() > 1) {
+			size_t best = 0;
+			double best_cost = std::numeric_limits<double>::max();
+			for (size_t i = 0; i + 1 < ranges.size(); ++i) {
+				double cost = merge_cost(ranges[i], ranges[i+1]);
+				if (cost < best_cost) {
+					best = i;
+					best_cost = cost;
+				}
+			}
+			if (ranges.size() <= MAX_DIST_RANGES && best_cost >= DIST_MERGE_THRESHOLD) {
+				break;
+			}
+			ranges[best].width += ranges[best+1].width;
+			ranges[best].ops += ranges[best+1].ops;
+			ranges.erase(ranges.begin() + best + 1);
+		}
+
+		// round the I/O shares to whole percentages that still add up to 100, giving the leftover
+		// points to the ranges that lost the most in rounding
+		std::vector<RandomDistRange> dist;
+		std::vector<std::pair<double, size_t>> remainders;
+		unsigned int assigned = 0;
+		for (size_t i = 0; i < ranges.size(); ++i) {
+			double share = 100.0*ranges[i].ops/total;
+			unsigned int pct = (unsigned int)share;
+			dist.push_back({pct, ranges[i].width*100/OFFSET_BUCKETS});
+			remainders.push_back(std::make_pair(share - pct, i));
+			assigned += pct;
+		}
+		std::sort(remainders.rbegin(), remainders.rend());
+		for (size_t i = 0; assigned < 100; ++i, ++assigned) {
+			++dist[remainders[i].second].io_percent;
+		}
+		return dist;
+	}
+
+	/**
+	 *	Format a byte count the way diskspd's options take it, e.g. 4K instead of 4096
+	 */
+	static std::string byte_size_arg(uint64_t bytes) {
+		const char * suffixes = "GMK";
+		for (int i = 0; i < 3; ++i) {
+			uint64_t unit = 1ULL << (10*(3-i));
+			if (bytes && bytes % unit == 0) {
+				return std::to_string(bytes/unit) + suffixes[i];
+			}
+		}
+		return std::to_string(bytes);
+	}
+
+	WorkloadModel WorkloadModel::fit(const Trace& trace, unsigned int path) {
+
+		WorkloadModel model;
+		model.path = trace.paths[path];
+
+		std::map<size_t, uint64_t> size_counts;
+		std::vector<uint64_t> times;
+		uint64_t sequential = 0;
+		uint64_t offset_bits = 0;
+		uint64_t batches = 0;
+		uint64_t batched_ops = 0;
+
+		for (auto& ops : trace.thread_ops) {
+
+			bool used = false;
+			off_t next_sequential = -1;
+			// ops issued by a single io_submit or io_uring_enter share a timestamp
+			uint64_t batch_time = 0;
+			uint64_t batch = 0;
+
+			for (auto& op : ops) {
+				if (op.target != path) continue;
+				used = true;
+
+				if (op.op == TRACE_OP_SYNC) {
+					++model.syncs;
+					continue;
+				}
+				if (op.op == TRACE_OP_WRITE) {
+					++model.writes;
+				} else {
+					++model.reads;
+				}
+
+				++size_counts[op.size];
+				times.push_back(op.time_ns);
+
+				if (op.offset == next_sequential) {
+					++sequential;
+				}
+				next_sequential = op.offset + op.size;
+				offset_bits |= op.offset;
+				model.extent = std::max(model.extent, op.offset + (off_t)op.size);
+
+				if (batch && op.time_ns == batch_time) {
+					++batch;
+				} else {
+					batches += batch ? 1 : 0;
+					batched_ops += batch;
+					batch_time = op.time_ns;
+					batch = 1;
+				}
+			}
+			batches += batch ? 1 : 0;
+			batched_ops += batch;
+
+			if (used) {
+				++model.threads;
+			}
+		}
+
+		uint64_t data_ops = model.reads + model.writes;
+		if (!data_ops) {
+			return model;
+		}
+
+		for (auto& s : size_counts) {
+			model.sizes.push_back(s);
+		}
+		std::stable_sort(model.sizes.begin(), model.sizes.end(),
+				[](const std::pair<size_t, uint64_t>& a, const std::pair<size_t, uint64_t>& b) {
+					return a.second > b.second;
+				});
+
+		model.sequential_fraction = (double)sequential/data_ops;
+		model.depth = (double)batched_ops/batches;
+
+		// alignment: the lowest set bit of any offset, but no more than the most common size
+		size_t block_size = model.sizes[0].first;
+		model.alignment = 1;
+		while ((size_t)model.alignment*2 <= block_size && !(offset_bits & model.alignment)) {
+			model.alignment *= 2;
+		}
+
+		// offset distribution, and how much of the space the busiest parts take up
+		std::vector<uint64_t> buckets(OFFSET_BUCKETS, 0);
+		for (auto& ops : trace.thread_ops) {
+			for (auto& op : ops) {
+				if (op.target != path || op.op == TRACE_OP_SYNC) continue;
+				++buckets[(uint64_t)op.offset*OFFSET_BUCKETS/model.extent];
+			}
+		}
+		model.offset_dist = fit_offset_dist(buckets, data_ops);
+
+		std::vector<uint64_t> busiest(buckets);
+		std::sort(busiest.rbegin(), busiest.rend());
+		const double hot_io[3] = {0.5, 0.8, 0.9};
+		uint64_t covered = 0;
+		unsigned int used_buckets = 0;
+		for (int i = 0; i < 3; ++i) {
+			while (covered < hot_io[i]*data_ops) {
+				covered += busiest[used_buckets++];
+			}
+			model.hot_space[i] = (double)used_buckets/OFFSET_BUCKETS;
+		}
+
+		// inter-arrival times, across all the threads
+		std::sort(times.begin(), times.end());
+		model.duration_s = (times.back() - times.front())/1e9;
+		if (times.size() > 1) {
+			std::vector<double> gaps;
+			double sum = 0;
+			for (size_t i = 1; i < times.size(); ++i) {
+				gaps.push_back((times[i] - times[i-1])/1e3);
+				sum += gaps.back();
+			}
+			model.gap_mean_us = sum/gaps.size();
+			double sq_dev = 0;
+			for (auto gap : gaps) {
+				sq_dev += (gap - model.gap_mean_us)*(gap - model.gap_mean_us);
+			}
+			if (model.gap_mean_us) {
+				model.gap_cv = std::sqrt(sq_dev/gaps.size())/model.gap_mean_us;
+			}
+			std::sort(gaps.begin(), gaps.end());
+			model.gap_p50_us = gaps[gaps.size()*50/100];
+			model.gap_p99_us = gaps[std::min(gaps.size() - 1, gaps.size()*99/100)];
+		}
+
+		return model;
+	}
+
+	void WorkloadModel::print(FILE * out) const {
+
+		uint64_t data_ops = reads + writes;
+
+		fprintf(out, "\tpath: '%s'\n", path.c_str());
+		fprintf(out, "\t\tops: %lu (%lu reads, %lu writes, %lu syncs) over %.3fs from %u threads\n",
+				data_ops + syncs, reads, writes, syncs, duration_s, threads);
+		if (!data_ops) {
+			return;
+		}
+
+		unsigned int write_pct = (unsigned int)((writes*100 + data_ops/2)/data_ops);
+		fprintf(out, "\t\tread/write ratio: %u/%u\n", 100 - write_pct, write_pct);
+
+		fprintf(out, "\t\top sizes:");
+		uint64_t others = data_ops;
+		for (size_t i = 0; i < sizes.size() && i < 5; ++i) {
+			fprintf(out, " %lu (%.1f%%)", sizes[i].first, 100.0*sizes[i].second/data_ops);
+			others -= sizes[i].second;
+		}
+		if (others) {
+			fprintf(out, " other (%.1f%%)", 100.0*others/data_ops);
+		}
+		fprintf(out, "\n");
+
+		fprintf(out, "\t\tsequential ops: %.1f%%\n", 100*sequential_fraction);
+		fprintf(out, "\t\toffset alignment: %lu, extent: %luB\n", alignment, extent);
+		fprintf(out, "\t\toffset skew: 50%% of ops to %.0f%% of the extent, 80%% to %.0f%%, 90%% to %.0f%%\n",
+				100*hot_space[0], 100*hot_space[1], 100*hot_space[2]);
+		fprintf(out, "\t\toffset distribution (IO%%/extent%%):");
+		for (auto& range : offset_dist) {
+			fprintf(out, " %u/%u", range.io_percent, range.target_percent);
+		}
+		fprintf(out, "\n");
+		fprintf(out, "\t\tinter-arrival time: mean %.1fus, 50th %.1fus, 99th %.1fus, CV %.2f\n",
+				gap_mean_us, gap_p50_us, gap_p99_us, gap_cv);
+		fprintf(out, "\t\tops issued together per thread: %.2f\n", depth);
+		if (duration_s > 0) {
+			uint64_t bytes = 0;
+			for (auto& s : sizes) bytes += s.first*s.second;
+			fprintf(out, "\t\tthroughput: %.2f iops, %.2f MB/s\n",
+					data_ops/duration_s, bytes/duration_s/(1024*1024));
+		}
+	}
+
+	std::string WorkloadModel::command_line(const std::string& target, off_t size,
+			unsigned int rate_percent) const {
+
+		uint64_t data_ops = reads + writes;
+		size_t block_size = sizes[0].first;
+		unsigned int write_pct = (unsigned int)((writes*100 + data_ops/2)/data_ops);
+
+		std::string cmd = "diskspd -b" + byte_size_arg(block_size);
+
+		if (sequential_fraction >= 0.5) {
+			cmd += " -s";
+			// give each thread its own part of the target to stream through, like the traced threads
+			off_t space = size ? size : extent;
+			off_t thread_offset = space/threads - (space/threads) % block_size;
+			if (threads > 1 && thread_offset) {
+				cmd += " -T" + byte_size_arg(thread_offset);
+			}
+		} else {
+			cmd += " -r" + byte_size_arg(alignment);
+			// the distribution is relative, so it carries over to targets of any size
+			if (offset_dist.size() > 1) {
+				cmd += " --random-dist=";
+				for (size_t i = 0; i < offset_dist.size(); ++i) {
+					if (i) cmd += ",";
+					cmd += std::to_string(offset_dist[i].io_percent) + "/" +
+						std::to_string(offset_dist[i].target_percent);
+				}
+			}
+		}
+
+		cmd += " -w" + std::to_string(write_pct);
+		cmd += " -t" + std::to_string(threads);
+
+		// assuming latency stays the same, outstanding I/O has to grow with the rate (Little's law)
+		unsigned int overlap = (unsigned int)std::ceil(depth*rate_percent/100);
+		cmd += " -o" + std::to_string(std::max(overlap, 1u));
+
+		// -g is in bytes per millisecond for each thread
+		if (duration_s > 0) {
+			uint64_t bytes = 0;
+			for (auto& s : sizes) bytes += s.first*s.second;
+			double per_ms = bytes/duration_s/1000*rate_percent/100/threads;
+			cmd += " -g" + std::to_string(std::max((uint64_t)std::llround(per_ms), (uint64_t)1));
+		}
+
+		if (size) {
+			cmd += " -c" + byte_size_arg(size);
+		}
+		cmd += " " + target;
+
+		return cmd;
+	}
+
+} // namespace diskspd
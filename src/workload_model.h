@@ -0,0 +1,96 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+#include <sys/types.h>
+
+#include "replay.h"
+#include "target.h"
+
+#ifndef DISKSPD_WORKLOAD_MODEL_H
+#define DISKSPD_WORKLOAD_MODEL_H
+
+namespace diskspd {
+
+	/**
+	 *	A statistical model of the I/O issued to one traced path, fitted for --synthesize.
+	 *	Unlike a replay, the model can be turned into a diskspd command line that drives the usual
+	 *	offset and rate machinery, so it can be scaled to other rates and target sizes
+	 */
+	struct WorkloadModel {
+
+		std::string path;
+
+		uint64_t reads = 0;
+		uint64_t writes = 0;
+		uint64_t syncs = 0;
+
+		// time between the first and last op on the path
+		double duration_s = 0;
+
+		// op sizes and how many ops had each, most common first
+		std::vector<std::pair<size_t, uint64_t>> sizes;
+
+		// fraction of ops that started where the issuing thread's previous op on the path ended
+		double sequential_fraction = 0;
+
+		// largest power of 2 (up to the most common size) that all offsets are aligned to
+		off_t alignment = 1;
+
+		// end of the highest op on the path; offsets are modelled as fractions of this
+		off_t extent = 0;
+
+		// where the ops land, as a distribution over ranges of [0, extent) in offset order
+		std::vector<RandomDistRange> offset_dist;
+
+		// how concentrated the ops are: fraction of [0, extent) receiving 50%, 80% and 90% of them,
+		// when taking the busiest parts of the path first
+		double hot_space[3] = {0, 0, 0};
+
+		// time between consecutive ops on the path from any thread, in microseconds
+		double gap_mean_us = 0;
+		double gap_p50_us = 0;
+		double gap_p99_us = 0;
+		double gap_cv = 0;		// coefficient of variation; 1 for poisson arrivals
+
+		// threads that issued ops to the path
+		unsigned int threads = 0;
+		// mean number of ops each thread issued together (in one io_submit or io_uring_enter)
+		double depth = 0;
+
+		/**
+		 *	Fit a model to the ops on path number 'path' of the trace
+		 */
+		static WorkloadModel fit(const Trace& trace, unsigned int path);
+
+		/**
+		 *	Print the model in the same style as the results
+		 */
+		void print(FILE * out) const;
+
+		/**
+		 *	Build a diskspd command line generating this workload on 'target', with throughput and
+		 *	outstanding I/O scaled to rate_percent of the trace. A non-zero size is passed to -c
+		 */
+		std::string command_line(const std::string& target, off_t size, unsigned int rate_percent) const;
+	};
+
+	/**
+	 *	What --synthesize needs to print models and command lines
+	 */
+	struct SynthesisOptions {
+		std::shared_ptr<Trace> trace;
+		// targets for the command lines, one per traced path
+		std::vector<std::string> targets;
+		off_t size = 0;						// -c
+		unsigned int rate_percent = 100;	// --scale-rate
+	};
+
+} // namespace diskspd
+
+#endif // DISKSPD_WORKLOAD_MODEL_H
@@ -37,15 +37,63 @@ bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -B12K -f76K df1 df2 # max siz
 
 bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -s1K df1 df2 # small stride
 bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -r1K df1 df2 # random align
+bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -r4K --random-dist=90/10,10/90 df1 df2 # skewed random
 bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -si df1 df2 # sequential interlock
 
 bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -T1K df1 df2 # small thread stride
 
 bin/diskspd -c1M -L -D -w50 -Sh -d1 -W1 -t4 -z -Zs -xp df1 df2 # posix suspend
 
+bin/diskspd -c1M -L -D -Sh -d1 -W1 -t4 -o4 -r4K -b4K --chain=rWf df1 df2 # read-modify-write-fsync chains
+bin/diskspd -c1M -L -D -Sh -d1 -W1 -t4 -o4 -r4K -b4K --chain=r4 -xp df1 df2 # dependent reads, posix
+
+mkdir -p lsmdir
+bin/diskspd -L -D -Sh -d2 -W1 -t2 -o4 -b4K --lsm=table=4M,size=16M,fanin=2,fp=10 lsmdir # LSM tree
+
+bin/diskspd -c1M -L -D -d1 -W1 -t8 --wal df1                  # group commit
+bin/diskspd -c1M -L -D -Sd -d1 -W1 -t8 --wal=100-1K -xp df1   # group commit, O_DIRECT, posix
+
+bin/diskspd -c1M -L -D -Sh -d1 -W1 -t2 -o4 -r4K -b64K --stripe=16K df1 df2 df3   # RAID0
+bin/diskspd -c1M -L -D -d1 -W1 -t2 -o2 -si -w50 -b48K --stripe=32K -xp df1 df2   # RAID0, partial stripes
+
+bin/diskspd -c1M -L -D -Sh -d2 -W1 -t2 -o8 -r4K -b4K -w20 --mirror=quorum=2,hedge=95 df1 df2 df3   # mirror
+bin/diskspd -c1M -L -d2 -W1 -t2 -o8 -r4K -b4K --mirror=hedge=99.9 -xp df1 df2   # hedged reads, posix
+
+bin/diskspd -c1M -L -D -Sh -d1 -W1 -t2 -o4 -r64K -b64K -w50 --erasure=2+2 df1 df2 df3 df4   # Reed-Solomon
+bin/diskspd -c1M -L -d1 -W1 -t1 -o4 -b16K -w30 --erasure=2+1,simd=scalar,read=data df1 df2 df3   # XOR, scalar
+
+bin/diskspd -c1M -L -d1 -W1 -t2 -o4 -r4K -w10 --random-dist=90/10,10/90 --cache=256K df1 df2   # buffer cache
+bin/diskspd -c1M -L -d1 -W1 -t1 -o4 -r4K --cache=128K,policy=2q,page=16K -xp df1   # 2Q, posix
+bin/diskspd -c1M -L -d2 -W1 -t1 -o1 -r4K df1 --group="-c1M -b256K -o16 -s256K -w100 df2"   # noisy neighbour
+bin/diskspd -c1M -L -d3 -W1 -t2 -o4 -r4K --idle=200,every=500,probes=3 df1 df2   # idle gaps
+bin/diskspd -c1M -L -d1 -W1 -F2 -o8 -r4K --weights=8,1,1:2 df1 df2 df3   # weighted targets
+bin/diskspd -c1M -L -d2 -W1 -t2 -o8 -r4K -b4K --rate=job:20000iops,target:40M df1 df2   # rate limits
+bin/diskspd -c1M -L -d3 -W1 -t2 -o32 -r4K -b4K --qd-target=1,pct=99,window=50 df1 df2   # latency-bound queue depth
+bin/diskspd -c1M -L -d1 -W1 -r4K --sweep=b=4K/64K,o=1/8,w=0/30,settle=100 df1 df2   # parameter sweep
+bin/diskspd -c1M -L -W1 -F4 -o4 -r4K -b4K --ramp=1,start=1,step=1 df1 df2   # thread ramp
+bin/diskspd -c1M -L -d1 -W10 -t2 -o4 -r4K --steady=window=500,windows=4,cv=10 df1 df2   # warm up until steady
+bin/diskspd -c1M -L -d1 -W1 -r4K --precondition=seq=64K,qd=8,round=1,rounds=6,window=3 df1   # SNIA PTS preconditioning
+bin/diskspd -c1M -L -d10 -W0 -b64K -o4 --work=pass df1   # time to complete a pass
+bin/diskspd -c1M -L -d10 -W0 -t2 -r4K -o4 --work=ops=5000,per=target df1 df2   # fixed work per target
+bin/diskspd -c1M -L -d10 -F4 -o4 -b4K --scan=chunk=64K df1 df2   # work-stealing scan
+echo '{"jobs":[{"d":1,"W":1,"L":true,"c":"1M","targets":[{"path":"df1","r":"4K"},{"path":"df2","b":"64K","w":100}]},{"d":1,"W":0,"t":2,"targets":[{"path":"df1","c":"1M","b":"8K"}]}]}' > df.json
+bin/diskspd --profile=df.json   # two Jobs from a JSON profile
+echo '{"jobs":[{"d":1,"W":1,"b":"4K","targets":[{"path":"df1","c":"1M"},{"path":"df2","c":"1M"},{"path":"df3","c":"2M","w":50}]}]}' > df2.json
+bin/diskspd --profile=df2.json   # targets sharing settings, then a --group
+bin/diskspd --daemon=df.sock & daemon=$!; sleep 1   # serve runs over a socket
+bin/diskspd --connect=df.sock -c1M -L -d1 -W1 -r4K df1; bin/diskspd --connect=df.sock -L -d1 -W1 -b64K df1; kill $daemon; rm -f df.sock
+bin/diskspd -c1M -L -D -d2 -W1 -t4 -o8 -r4K -w30 --processes df1   # worker processes
+bin/diskspd -c1M -d2 -W1 -t1 -o4 -b64K -g10K df1   # -g is paced too
+
+DISKSPD_CAPTURE_FILE=df.trace LD_PRELOAD=bin/libdiskspd_capture.so dd if=df1 of=df2 bs=4K conv=fsync
+bin/diskspd -L -d1 -W1 --replay=df.trace                # replay onto the traced files
+bin/diskspd -c1M -L -Sh -d1 -W1 -o4 --replay=df.trace df3 df4   # replay onto other files
+bin/diskspd --synthesize=df.trace --scale-rate=200 -c4M df3 df4   # model the trace at twice the rate
+
 
 # resource-intensive tests - should saturate a high performance SSD on Azure
 # keep in mind it takes 20-30 seconds to set the files up
 # bin/diskspd -c512M -b1M -L -D -w50 -Sh -z -Zs -d30 -W5 -o32 -t1 df1 df2 df3 df4 df5 df6 df7 df8
 # bin/diskspd -c512M -b4K -L -D -w50 -Sh -z -Zs -d30 -W5 -o32 -t1 df1 df2 df3 df4 df5 df6 df7 df8
-
+# bin/diskspd -c512M -b4K -L -d30 -W5 -o32 -t1 -r --age=256K df1   # aging writes most of the filesystem's free space
+# bin/diskspd -c512M -b4K -L -d10 -W2 -t1 -r --sweep=scheduler=none/mq-deadline/kyber/bfq,nr_requests=32/64,o=1/32 df1   # needs root